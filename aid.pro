@@ -21,9 +21,26 @@ SOURCES +=  $$_PRO_FILE_PWD_/src/main.cpp\
             $$_PRO_FILE_PWD_/src/qwBottomPanel.cpp \
             $$_PRO_FILE_PWD_/src/globals.cpp \
             $$_PRO_FILE_PWD_/src/CTcpServer.cpp \
+            $$_PRO_FILE_PWD_/src/CDirectoryWatcher.cpp \
             $$_PRO_FILE_PWD_/src/CNormalizator.cpp \
             $$_PRO_FILE_PWD_/src/CNativeData.cpp \
             $$_PRO_FILE_PWD_/src/CBitParser.cpp \
+            $$_PRO_FILE_PWD_/src/CFrameSequence.cpp \
+            $$_PRO_FILE_PWD_/src/CFloatExport.cpp \
+            $$_PRO_FILE_PWD_/src/CSession.cpp \
+            $$_PRO_FILE_PWD_/src/CSpillStore.cpp \
+            $$_PRO_FILE_PWD_/src/CImgRegistry.cpp \
+            $$_PRO_FILE_PWD_/src/CBufferPool.cpp \
+            $$_PRO_FILE_PWD_/src/CMemoryReport.cpp \
+            $$_PRO_FILE_PWD_/src/CTiledImage.cpp \
+            $$_PRO_FILE_PWD_/src/CRenderCache.cpp \
+            $$_PRO_FILE_PWD_/src/CWorkPool.cpp \
+            $$_PRO_FILE_PWD_/src/CToolQueue.cpp \
+            $$_PRO_FILE_PWD_/src/CCommandQueue.cpp \
+            $$_PRO_FILE_PWD_/src/CStreamTable.cpp \
+            $$_PRO_FILE_PWD_/src/CDecodePipeline.cpp \
+            $$_PRO_FILE_PWD_/src/CDecodeHelpers.cpp \
+            $$_PRO_FILE_PWD_/src/CDecodePlan.cpp \
             $$_PRO_FILE_PWD_/src/qwStatusBar.cpp \
             $$_PRO_FILE_PWD_/src/static.cpp
 
@@ -38,11 +55,30 @@ HEADERS +=  $$_PRO_FILE_PWD_/inc/aidMainWindow.h \
             $$_PRO_FILE_PWD_/inc/globals.h \
             $$_PRO_FILE_PWD_/inc/defines.h \
             $$_PRO_FILE_PWD_/inc/CTcpServer.h \
+            $$_PRO_FILE_PWD_/inc/CDirectoryWatcher.h \
             $$_PRO_FILE_PWD_/inc/commons.h \
             $$_PRO_FILE_PWD_/inc/CNormalizator.h \
             $$_PRO_FILE_PWD_/inc/CNativeData.h \
             $$_PRO_FILE_PWD_/inc/CImgContext.h \
-            $$_PRO_FILE_PWD_/inc/CBitParser.h
+            $$_PRO_FILE_PWD_/inc/CBitParser.h \
+            $$_PRO_FILE_PWD_/inc/CFrameSequence.h \
+            $$_PRO_FILE_PWD_/inc/CFloatExport.h \
+            $$_PRO_FILE_PWD_/inc/CSession.h \
+            $$_PRO_FILE_PWD_/inc/CSpillStore.h \
+            $$_PRO_FILE_PWD_/inc/CImgRegistry.h \
+            $$_PRO_FILE_PWD_/inc/CBufferPool.h \
+            $$_PRO_FILE_PWD_/inc/CMemoryReport.h \
+            $$_PRO_FILE_PWD_/inc/CTiledImage.h \
+            $$_PRO_FILE_PWD_/inc/CRenderCache.h \
+            $$_PRO_FILE_PWD_/inc/CWorkPool.h \
+            $$_PRO_FILE_PWD_/inc/CToolQueue.h \
+            $$_PRO_FILE_PWD_/inc/CCommandQueue.h \
+            $$_PRO_FILE_PWD_/inc/CCancelToken.h \
+            $$_PRO_FILE_PWD_/inc/CProgress.h \
+            $$_PRO_FILE_PWD_/inc/CStreamTable.h \
+            $$_PRO_FILE_PWD_/inc/CDecodePipeline.h \
+            $$_PRO_FILE_PWD_/inc/CDecodeHelpers.h \
+            $$_PRO_FILE_PWD_/inc/CDecodePlan.h
 
 RESOURCES += \
             $$_PRO_FILE_PWD_\media\resources.qrc
@@ -0,0 +1,79 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CBUFFERPOOL_H
+#define CBUFFERPOOL_H
+
+#include <QtGlobal>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CBufferPool class.
+ * \section DESCRIPTION
+ *          The allocator of all native image buffers (see CNativeData): received payloads,
+ *          RIC files, spilled and session payloads and computed images.
+ *
+ *          Sizes are rounded up to size classes (four classes per power of two), released
+ *          blocks are kept on per-class free lists and handed out again, so streaming
+ *          frames of the same size does not touch the heap. Blocks are 64-byte aligned;
+ *          large blocks are hugepage aligned and advised as such where the system allows.
+ *          The free lists hold at most POOL_MAX_CACHED_MB, the rest goes back to the system.
+ *
+ *          All members are thread safe.
+ */
+
+class CBufferPool
+{
+public:
+    /*! Returns a block of at least <sizeInBytes> bytes, NULL when out of memory. */
+    static char*        acquire(quint64 sizeInBytes);
+
+    /*! Returns a block of at least <sizeInBytes> bytes holding the first <usedBytes> of <blockPtr> (may be NULL); <blockPtr> is released when moved. */
+    static char*        grow(char *blockPtr, quint64 usedBytes, quint64 sizeInBytes);
+
+    /*! Puts a block back on its free list (NULL is ignored). */
+    static void         release(char *blockPtr);
+
+    /*! Returns the usable size of a block. */
+    static quint64      getCapacity(const char *blockPtr);
+
+    /*! Frees all cached blocks. */
+    static void         trim();
+
+    /*! Returns the number of bytes in blocks handed out. */
+    static quint64      getLiveBytes();
+
+    /*! Returns the number of bytes cached on the free lists. */
+    static quint64      getCachedBytes();
+
+private:
+    static int          sizeClass(quint64 sizeInBytes, quint64 *classBytes);
+    static char*        allocateBlock(int sizeClass, quint64 classBytes);
+    static void         freeBlock(char *blockPtr);
+
+    static QMutex                       poolLock;
+    static QHash<int, QVector<char*> >  freeLists;
+    static quint64                      liveBytes;
+    static quint64                      cachedBytes;
+};
+
+#endif // CBUFFERPOOL_H
@@ -0,0 +1,77 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CCANCELTOKEN_H
+#define CCANCELTOKEN_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QVector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CCancelToken class.
+ * \section DESCRIPTION
+ *          A cooperative cancellation flag shared by its copies. Long loops (decoding, the
+ *          tools) check isCancelled() once per row and give up; cancel() may be called from
+ *          any thread.
+ *
+ *          A token linked to other tokens (see linkTo) is also cancelled with them, e.g. a
+ *          tool job is cancelled when any of its images is removed. Links are set up before
+ *          the token is handed over to the job.
+ */
+
+class CCancelToken
+{
+public:
+    CCancelToken() : state(new dCancelState) {}
+
+    void          cancel(){state->flag.fetchAndStoreOrdered(1);}
+
+    bool          isCancelled() const
+                  {
+                      if(state->flag.fetchAndAddOrdered(0) != 0)
+                          return true;
+                      for(int i = 0; i < state->links.size(); i++)
+                          if(state->links.at(i)->flag.fetchAndAddOrdered(0) != 0)
+                              return true;
+                      return false;
+                  }
+
+    /*! Cancels this token with <other> (and with the tokens <other> is linked to). */
+    void          linkTo(const CCancelToken &other)
+                  {
+                      state->links.append(other.state);
+                      state->links += other.state->links;
+                  }
+
+private:
+    typedef struct dCancelState
+    {
+        dCancelState() : flag(0) {}
+
+        QAtomicInt                               flag;
+        QVector<QSharedPointer<dCancelState> >   links;
+    }dCancelState;
+
+    QSharedPointer<dCancelState> state;
+};
+
+#endif // CCANCELTOKEN_H
@@ -0,0 +1,90 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CCOMMANDQUEUE_H
+#define CCOMMANDQUEUE_H
+
+#include "CImgContext.h"
+
+#include <QtGlobal>
+#include <QObject>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QSharedPointer>
+#include <QVector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The cmdS struct.
+ *        An internal message-queue element structure.
+ */
+
+struct cmdS
+{
+    int                         commandID;
+    quintptr                    auxParam;
+    /*! The image the command refers to (kept alive until the command is executed). */
+    QSharedPointer<CImgContext> imgPtr;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CCommandQueue class.
+ * \section DESCRIPTION
+ *          The local command queue: commands posted by any thread, executed by the GUI
+ *          thread. Posting is lock-free (commands are pushed to an atomic stack, the
+ *          consumer takes the whole stack at once), so workers never wait for the GUI.
+ *
+ *          The first command posted after a drain wakes the consumer with a queued call
+ *          of its slot; further commands join that wake-up until the consumer drains the
+ *          queue, so a burst of commands costs a single event-loop turn.
+ *
+ *          Any thread may post, only the consumer may take.
+ */
+
+class CCommandQueue
+{
+public:
+                                 CCommandQueue();
+                                ~CCommandQueue();
+
+    /*! Sets the consumer: <method> (a slot of <receiver>) is invoked when commands arrive. Set once, before the workers start. */
+    void                         setReceiver(QObject *receiver, const char *method);
+
+    void                         post(const cmdS &cmd);
+
+    /*! Takes all posted commands, oldest first. Consumer only. */
+    QVector<cmdS>                takeAll();
+
+private:
+    typedef struct dCommandNode
+    {
+        cmdS                     cmd;
+        dCommandNode            *next;
+    }dCommandNode;
+
+    void                         wake();
+
+    QAtomicPointer<dCommandNode> head;
+    QAtomicInt                   wakePending;
+    QObject                     *receiver;
+    const char                  *method;
+};
+
+#endif // CCOMMANDQUEUE_H
@@ -0,0 +1,142 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CDECODEHELPERS_H
+#define CDECODEHELPERS_H
+
+#include "CTiledImage.h"
+#include "CCancelToken.h"
+#include "defines.h"
+
+#include <QtGlobal>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QProcess>
+#include <QSharedMemory>
+#include <QSystemSemaphore>
+#include <QDateTime>
+#include <QTimer>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CDecodeHelpers class.
+ * \section DESCRIPTION
+ *          Optional out-of-process decoding (see Globals::decodeHelperCount). A pool of helper
+ *          processes (this executable started with CL_DECODE_HELPER_PROCESS) runs the pixel
+ *          decode of CImgContext::loadFromNativeData: the payload is copied to a shared
+ *          memory segment, a helper decodes it into the same segment and the viewer only
+ *          reads the pixels back. A malformed payload or format that crashes (or hangs) the
+ *          decoder takes one helper down: its job is retried once on another helper and the
+ *          image is marked bad when that one fails too. Dead helpers are restarted.
+ *
+ *          Each helper has a small control segment and two system semaphores (request and
+ *          response), made anew for every helper started (a generation), so a dead helper
+ *          never leaves counts behind for its successor; a job segment is made per job. Every
+ *          posted job has a sequence number, answers to another job are discarded. The helpers are watched from the GUI
+ *          thread: when one exits during a job, its response is posted with
+ *          DECODE_HELPER_CRASHED, so the waiting decode never blocks on a dead process. The
+ *          watchdog also abandons the jobs whose image has been cancelled: the decode gets
+ *          DECODE_HELPER_CANCELLED and the helper is killed and restarted. A helper exits when
+ *          the viewer closes its standard input.
+ *
+ *          decode() may be called from any thread; start() and stop() from the GUI thread.
+ */
+
+class CDecodeHelpers : public QObject
+{
+    Q_OBJECT
+public:
+    /*! Starts <count> helper processes (stops the running ones first). */
+    static void              start(int count);
+
+    /*! Stops the helpers; pending decodes get DECODE_HELPER_CRASHED and fall back. */
+    static void              stop();
+
+    static bool              isEnabled();
+    static int               getHelperCount();
+
+    /*!
+     * \brief  Decodes a payload in a helper process.
+     * \return DECODE_HELPER_OK (<visualData>, <gainOut> and <biasOut> are set), DECODE_HELPER_FAILED
+     *         (the helper rejected the job), DECODE_HELPER_CRASHED (every attempt took a helper
+     *         down), DECODE_HELPER_CANCELLED (<cancelToken> was cancelled before or during the
+     *         job) or DECODE_HELPER_UNAVAILABLE (no helper running, or the job does not fit a
+     *         shared segment): the caller decodes in process then.
+     */
+    static int               decode(const QString &formatStr,
+                                    quint32 width,
+                                    quint32 height,
+                                    quint32 rowStrideInBits,
+                                    const float gain[4],
+                                    const float bias[4],
+                                    quint32 auxFilteringFlags,
+                                    const char *payloadPtr,
+                                    quint64 payloadSize,
+                                    CTiledImage *visualData,
+                                    float gainOut[4],
+                                    float biasOut[4],
+                                    const CCancelToken &cancelToken);
+
+    /*! The main loop of a helper process (see main.cpp). */
+    static int               helperMain(const QString &slotKey);
+
+private slots:
+    void                     helperFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void                     watchdog();
+
+private:
+    typedef struct
+    {
+        QProcess            *process;
+        QSharedMemory       *control;
+        QSystemSemaphore    *request;
+        QSystemSemaphore    *response;
+        quint32              generation;
+        bool                 alive;
+        bool                 busy;
+        QDateTime            jobStartedAt;
+        CCancelToken         jobToken;
+        bool                 cancelled;
+        int                  restarts;
+    }dHelperSlot;
+
+                             CDecodeHelpers();
+    static CDecodeHelpers*   instance();
+    static bool              startSlot(int index);
+    static void              renewSlot(int index);
+    static void              postResult(int index, int status);
+    static int               decodeOnce(int index, quint32 generation, quint32 sequence, QSharedMemory &job,
+                                        CTiledImage *visualData, float gainOut[4], float biasOut[4]);
+    static int               runJob(const QString &jobKey);
+    static QString           slotKey(int index, quint32 generation);
+
+    static QMutex            helpersLock;
+    static QWaitCondition    slotFreed;
+    static QVector<dHelperSlot> helperSlots;
+    static bool              running;
+    static quint32           lastJobId;
+    static quint32           lastJobSequence;
+    static quint32           lastGeneration;
+    QTimer                   watchdogTimer;
+};
+
+#endif // CDECODEHELPERS_H
@@ -0,0 +1,112 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CDECODEPIPELINE_H
+#define CDECODEPIPELINE_H
+
+#include "CImgContext.h"
+#include "defines.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QElapsedTimer>
+
+class CWorker_loadFromNativeData;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The counters of a decode pipeline stage, as shown by the pipeline panel.
+ */
+
+typedef struct
+{
+    QString     name;
+    int         queued;         //!< Jobs waiting in front of the stage.
+    int         peakQueued;
+    int         bound;          //!< The queue bound (0: unbounded).
+    int         running;
+    quint64     done;
+    quint64     waitUs;         //!< Total time spent in the queue by the jobs done.
+    quint64     busyUs;         //!< Total run time of the jobs done.
+    quint64     stalls;         //!< Times the stage was held back by a full queue behind it.
+}dPipelineStage;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CDecodePipeline class.
+ * \section DESCRIPTION
+ *          Runs the received images (see CWorker_loadFromNativeData) in four stages:
+ *
+ *          receive   - the socket services hand the complete payloads over (GUI thread);
+ *          validate  - header checks, strings and the content hash (pool threads);
+ *          decode    - context creation and the decode itself (pool threads, in parallel,
+ *                      the images in focus first, see CPrioritizedTask);
+ *          publish   - thumbnails and lists (GUI thread, see CMD_PUBLISH_IMAGES).
+ *
+ *          The queues between the stages are bounded: a stage does not start new jobs while
+ *          the queue behind it is full, and the receivers stop reading their sockets while
+ *          the validate queue is full, so a fast producer is held back by TCP instead of
+ *          filling the memory. Every stage counts its jobs, queue and run times and stalls;
+ *          the stage whose queue stays full is the bottleneck.
+ *
+ *          All members are thread safe.
+ */
+
+class CDecodePipeline
+{
+public:
+    /*! Receive stage: queues a loader (created in the calling thread) for validation. */
+    static void                    submit(CWorker_loadFromNativeData *worker);
+
+    /*! Returns true when the validate queue is full; the receivers wait before reading more. */
+    static bool                    isSaturated();
+
+    /*! Publish stage: takes the decoded images (GUI thread). */
+    static QList<QSharedPointer<CImgContext> > takePublished();
+
+    /*! Returns the counters of all stages, in the stage order. */
+    static QList<dPipelineStage>   snapshot();
+
+private:
+    friend class CPipelineTask;
+
+    typedef struct
+    {
+        CWorker_loadFromNativeData  *worker;
+        QSharedPointer<CImgContext>  image;
+        qint64                       queuedAtUs;
+    }dPipelineJob;
+
+    static void                    dispatch();
+    static void                    runStage(int stage, dPipelineJob job);
+    static qint64                  now();
+    static void                    enqueue(int stage, QList<dPipelineJob> &queue, dPipelineJob &job);
+    static dPipelineJob            dequeue(int stage, QList<dPipelineJob> &queue, int index);
+
+    static QMutex                  pipelineLock;
+    static QElapsedTimer           clock;
+    static QList<dPipelineJob>     validateQueue;
+    static QList<dPipelineJob>     decodeQueue;
+    static QList<dPipelineJob>     publishQueue;
+    static dPipelineStage          stages[PIPELINE_STAGE_COUNT];
+};
+
+#endif // CDECODEPIPELINE_H
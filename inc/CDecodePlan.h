@@ -0,0 +1,104 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CDECODEPLAN_H
+#define CDECODEPLAN_H
+
+#include "defines.h"
+#include "CNormalizator.h"
+#include "CTiledImage.h"
+#include "CCancelToken.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QSharedPointer>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The layout and pre-filters shared by all images of a batch (see CDecodePlan::decodeBatch).
+ */
+
+typedef struct
+{
+    quint32     width;
+    quint32     height;
+    quint32     rowStrideInBits;
+    float       gain[4];
+    float       bias[4];
+}dDecodeParams;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CDecodePlan class.
+ * \section DESCRIPTION
+ *          A compiled pixel format: the format string parsed once (see CBitParser) into a
+ *          prototype normalizator, copied into the normalizators that decode with it. Plans
+ *          are immutable and shared; the last DECODE_PLAN_CACHE_SIZE formats compiled are
+ *          kept, so a stream of images sending the same format string parses it once.
+ *
+ *          decodeBatch decodes many buffers of one plan and layout on the work pool: every
+ *          lane sets a normalizator up once and decodes buffer after buffer with it, only
+ *          the data pointer changes between the images.
+ *
+ *          All members are thread safe.
+ */
+
+class CDecodePlan
+{
+public:
+    /*! Returns the plan of <formatStr> (from the cache when compiled before), NULL on a parse error (see <log>). */
+    static QSharedPointer<const CDecodePlan> compile(const QString &formatStr, QString *log = NULL);
+
+    /*! Sets the format of <normalizator> up (no parsing). */
+    void                             applyTo(CNormalizator &normalizator) const {normalizator.copyFormat(prototype);}
+
+    const QString&                   getFormat() const {return formatStr;}
+    quint8                           getEffectiveBitCount() const {return effectiveBitCount;}
+    quint8                           getColumnStride() const {return columnStride;}
+
+    /*! Returns the size in bytes a buffer of <params> must have. */
+    quint64                          getBufferSize(const dDecodeParams &params) const;
+
+    /*!
+     * \brief  Decodes <buffers> (all of <params>) across the pool threads; the calling thread takes part.
+     * \return The decoded images in the order of <buffers>; null images once <cancelToken> is cancelled.
+     */
+    static QVector<CTiledImage>      decodeBatch(const QSharedPointer<const CDecodePlan> &plan,
+                                                 const dDecodeParams &params,
+                                                 const QVector<const char*> &buffers,
+                                                 const CCancelToken &cancelToken = CCancelToken());
+
+private:
+                                     CDecodePlan(){}
+
+    CNormalizator                    prototype;
+    QString                          formatStr;
+    quint8                           effectiveBitCount;
+    quint8                           columnStride;
+
+    static QMutex                    cacheLock;
+    static QHash<QString, QSharedPointer<const CDecodePlan> > cache;
+    static QList<QString>            cacheOrder;
+};
+
+#endif // CDECODEPLAN_H
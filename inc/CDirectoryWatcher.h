@@ -0,0 +1,92 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CDIRECTORYWATCHER_H
+#define CDIRECTORYWATCHER_H
+
+#include "Threads.h"
+#include "globals.h"
+#include "commons.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QPointer>
+#include <QSocketNotifier>
+#include <QFileSystemWatcher>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CDirectoryWatcher class.
+ * \section DESCRIPTION
+ *          Watch-folder ingest for producers which cannot open a socket. Files dropped into
+ *          the watched directory (RIC files or raw AID dumps, both starting with the magic chars)
+ *          are loaded with the same native data path as the TCP server.
+ *          On Linux the directory is watched with inotify: only completed files are reported
+ *          (close after write or rename into the directory), so the directory is never rescanned.
+ *          Other platforms fall back to QFileSystemWatcher and an incremental listing.
+ *          Files with a WATCH_PARTIAL_SUFFIXES suffix or a leading dot are ignored.
+ */
+
+class CDirectoryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    CDirectoryWatcher(QObject * parent = 0);
+   ~CDirectoryWatcher();
+
+    /*!
+     * \brief Starts watching <path>. Files already present in the directory are ingested too.
+     * \param postAction WATCH_POST_KEEP, WATCH_POST_DELETE or WATCH_POST_ARCHIVE.
+     * \param archivePath Target directory for WATCH_POST_ARCHIVE.
+     */
+    int             start(const QString &path, int postAction, const QString &archivePath);
+    void            stop();
+    bool            isWorking(){return !watchedPath.isEmpty();}
+    QString         getWatchedPath(){return watchedPath;}
+
+public slots:
+    void            iAmDone();
+
+private slots:
+    void            inotifyEvent();
+    void            directoryChanged(const QString &path);
+
+private:
+    void            enqueue(const QString &fileName);
+    void            scanDirectory();
+    void            dispatch();
+
+    QString         watchedPath;
+    QString         archivePath;
+    int             postAction;
+
+    QStringList     pendingFiles;
+    QSet<QString>   knownFiles;
+    int             activeWorkers;
+
+    int             inotifyFd;
+    QPointer<QSocketNotifier>    inotifyNotifierPtr;
+    QPointer<QFileSystemWatcher> fsWatcherPtr;
+};
+
+#endif // CDIRECTORYWATCHER_H
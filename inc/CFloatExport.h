@@ -0,0 +1,74 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CFLOATEXPORT_H
+#define CFLOATEXPORT_H
+
+#include "CImgContext.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CFloatExport class.
+ * \section DESCRIPTION
+ *          Writes the decoded pixel values of an image as 32 bit floats, straight from the native
+ *          data (the 8 bit visual data is not used, pre-filter gain/bias is not applied).
+ *          Float channels are written as they are, integer channels are normalized the same way
+ *          as for the comparator and the recaster. The image is decoded and written one band
+ *          of rows at a time (at most FLOAT_EXPORT_BAND_BYTES, whole tile rows), the rows of
+ *          a band are decoded in parallel.
+ *
+ *          Supported outputs:
+ *          - PFM (Portable Float Map): RGB, little-endian, bottom-to-top rows, alpha is dropped.
+ *          - AID tiled float (*.atf): FLOAT_EXPORT_TILED_MAGIC, then quint32 width, height,
+ *            tile size and channel count (4), all little-endian, followed by the tiles in
+ *            row-major order. Each tile holds its rows of RGBA floats; edge tiles are clipped
+ *            to the image size.
+ */
+
+class CFloatExport
+{
+public:
+                                 CFloatExport(const QSharedPointer<CImgContext> &imgCtxPtr);
+
+    int                          saveToPFMFile(const QString &fileName);
+    int                          saveToTiledFloatFile(const QString &fileName);
+
+    QString                      lastLog;
+
+private:
+    /*! Sets up the reader and the band size. */
+    int                          setup();
+    /*! Decodes rows [firstRow, firstRow + rowCount) into <band> (RGBA floats, top-to-bottom rows). */
+    void                         decodeBand(quint32 firstRow, quint32 rowCount);
+
+    QSharedPointer<CImgContext>  imgCtxPtr;
+    CNormalizator                normalizator;
+    QSharedPointer<CNativeData>  fileData;
+    QVector<float>               band;
+    quint32                      bandRows;
+    quint32                      width;
+    quint32                      height;
+};
+
+#endif // CFLOATEXPORT_H
@@ -0,0 +1,107 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CFRAMESEQUENCE_H
+#define CFRAMESEQUENCE_H
+
+#include "defines.h"
+#include "CNativeData.h"
+#include "CTiledImage.h"
+#include "CDecodePlan.h"
+
+#include <QtGlobal>
+#include <QSharedPointer>
+#include <QImage>
+#include <QMutex>
+#include <QMap>
+#include <QSet>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CFrameSequence class.
+ *        Describes a multi-frame RAW capture stored as one native data block:
+ *        <frameCount> consecutive frames of <frameSize> bytes, each starting
+ *        <frameStride> bytes after the previous one. All frames share a single
+ *        pixel format, size and gain/bias. Decoded frames are kept in a small
+ *        cache around the current frame index, filled by background workers.
+ */
+
+class CFrameSequence
+{
+public:
+                                 CFrameSequence(const QSharedPointer<CNativeData> &nativeDataPtr);
+
+    /*! Sets up the frame layout and decoding parameters. Returns RES_OK or RES_ERROR (see <lastLog>). */
+    int                          setup(quint32       width,
+                                       quint32       height,
+                                       quint32       rowStrideInBits,
+                                       QString       formatStr,
+                                       const float   gain[4],
+                                       const float   bias[4],
+                                       quint32       frameSize,
+                                       quint32       frameStride,
+                                       quint32       frameCount);
+
+    /*! Decodes a single frame. Thread safe, does not touch the cache. */
+    CTiledImage                  decodeFrame(qint32 index);
+
+    /*! Decodes frames as one batch across the pool threads (see CDecodePlan::decodeBatch). Thread safe, does not touch the cache. */
+    QVector<CTiledImage>         decodeFrames(const QList<qint32> &indices);
+
+    /*! Cache access. */
+    bool                         getCachedFrame(qint32 index, CTiledImage &frame);
+    /*! Returns the index of the cached frame nearest to <index> (and the frame), -1 when the cache is empty. */
+    qint32                       getNearestCachedFrame(qint32 index, CTiledImage &frame);
+    void                         storeFrame(qint32 index, const CTiledImage &frame);
+
+    /*! Returns the size of all cached frames in bytes. */
+    quint64                      getCacheSizeInBytes();
+
+    /*! Marks <index> as the current frame and drops cached frames far from it. */
+    void                         setCursor(qint32 index);
+
+    /*! Starts background decoding of the frame <index> and the frames around it (see SEQ_PREFETCH_RADIUS). */
+    static void                  prefetch(const QSharedPointer<CFrameSequence> &sequencePtr, qint32 index);
+
+    /*! Returns a pointer to the first byte of the given frame. */
+    char*                        getFramePtr(qint32 index);
+
+    qint32                       getFrameCount(){return frameCount;}
+    quint32                      getFrameSize(){return frameSize;}
+    quint32                      getFrameStride(){return frameStride;}
+
+    QString                      lastLog;
+
+private:
+    QSharedPointer<CNativeData>  nativeDataPtr;
+
+    QSharedPointer<const CDecodePlan> plan;
+    dDecodeParams                params;
+
+    quint32                      frameSize;
+    quint32                      frameStride;
+    qint32                       frameCount;
+
+    QMutex                       cacheLock;
+    QMap<qint32, CTiledImage>    frameCache;
+    QSet<qint32>                 pendingFrames;
+    qint32                       cursor;
+};
+
+#endif // CFRAMESEQUENCE_H
@@ -28,6 +28,13 @@
 #include "CNativeData.h"
 #include "CNormalizator.h"
 #include "CBitParser.h"
+#include "CFrameSequence.h"
+#include "CTiledImage.h"
+#include "CRenderCache.h"
+#include "CCancelToken.h"
+#include "CProgress.h"
+#include "CDecodeHelpers.h"
+#include "CDecodePlan.h"
 
 #include <QPixmap>
 #include <QtDebug>
@@ -37,6 +44,9 @@
 #include <QPointer>
 #include <QPainter>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInt>
+#include <QSet>
 
 
 #ifdef QT4_HEADERS
@@ -54,6 +64,35 @@ const uint STATE_READY             =0x00;    //Ready for render.
 const uint STATE_BUSY              =0x01;    //Busy - currently processed.
 const uint STATE_BAD               =0x02;    //Bad - data corrupted or invalid bit parser string.
 const uint STATE_DELETE_MARK       =0x03;    //Marked for deletion.
+const uint STATE_SPILLED           =0x04;    //Data moved to the spill file (see CSpillStore).
+
+/*!
+ * Bytes held by an image, by category (see CImgContext::getMemoryUsage).
+ */
+
+typedef struct
+{
+    quint64 nativeBytes;        //Native payload.
+    quint64 visualBytes;        //Decoded ARGB32 data.
+    quint64 renderBytes;        //Render tiles of a shown image.
+    quint64 sequenceBytes;      //Cached frames of a sequence.
+    quint64 thumbnailBytes;     //Thumbnail icon and kept snapshot thumbnail.
+}dMemoryUsage;
+
+/*!
+ * What CImgContext::writeRIC writes, taken under the image lock (see CImgContext::snapshotRIC).
+ */
+
+typedef struct
+{
+    dHeader                     header;
+    bool                        raw;
+    QSharedPointer<CNativeData> nativeData;     //The payload of a raw image.
+    CTiledImage                 visual;         //The pixels of a graphics file image.
+    QByteArray                  formatBytes;
+    QByteArray                  nameBytes;
+    QByteArray                  notesBytes;
+}dRICSnapshot;
 
 //Image source flags
 const int SOURCE_RAW               =0x01;    //Loaded from uploaded pixel array.
@@ -188,6 +227,31 @@ class CImgContext : public QObject
     public:
         QMutex             notesLock;
 
+//------data access (shared by the readers of the pixels, exclusive for the writers replacing them)
+    private:
+        QReadWriteLock     dataLock;
+    public:
+        /*! Shared access for readers (render, tools, export); false when a writer holds it longer than <timeout> ms (-1 waits).
+            The save workers hold it for the whole save: the image stays viewable, the writers wait for the end of the save. */
+        bool               lockDataForRead(int timeout = 0){return dataLock.tryLockForRead(timeout);}
+        /*! Exclusive access for writers (spill, fault-in); false when it is held longer than <timeout> ms (-1 waits). */
+        bool               lockDataForWrite(int timeout = 0){return dataLock.tryLockForWrite(timeout);}
+        void               unlockData(){dataLock.unlock();}
+
+//------cancellation of the work on the image (see CCancelToken)
+    private:
+        CCancelToken       lifetimeToken;
+        CCancelToken       decodeToken;
+    public:
+        /*! The token fired when the image is removed (deleted or evicted); jobs link their tokens to it. */
+        CCancelToken       getCancelToken(){return lifetimeToken;}
+        void               cancelAll(){lifetimeToken.cancel();}
+        /*! Cancels the running decode only (superseded by a newer frame). */
+        void               cancelDecode(){THREAD_SAFE {decodeToken.cancel();}}
+        bool               isDecodeCancelled(){THREAD_SAFE {return decodeToken.isCancelled();}}
+        /*! Lets the decode run the jobs of the images in focus at tile boundaries (see CWorkPool::yieldToFocus). */
+        void               setPreemptibleDecode(bool value){myNormalizator.setPreemptible(value);}
+
 //------state flag
     private:
         uint               myState;
@@ -269,35 +333,105 @@ public:
 
 //------visual data
      private:
-        QImage             visualData;
+        CTiledImage        visualData;
+        /*! The loaders replace the data under the internal lock, the memory accounting reads it meanwhile. */
+        void               setVisualData(const CTiledImage &data){THREAD_SAFE {visualData = data;}}
      public:
-        QByteArray         getVisualData()
+        /*! Native view of a graphics file image (B8G8R8A8), read in place; it keeps the pixels alive. */
+        QSharedPointer<CNativeData> getVisualDataView()
         {
-            QByteArray ret;
-            for(int i = 0; i < visualData.height(); i++)
-                ret.append((char*)visualData.scanLine(i), visualData.bytesPerLine());
-            return ret;
+            THREAD_SAFE
+            return QSharedPointer<CNativeData>(new CNativeData(visualData.toImage()));
         }
 
         bool hasAlpha(){return visualData.hasAlphaChannel();}
 
-//------render data
+        /*!
+         * \brief   Sets up a private normalizator reading the pixels (the current frame of a sequence).
+         *          The tools read through it instead of myNormalizator, so they do not disturb
+         *          pixel picking or each other. The caller holds the data read lock while it is used.
+         * @param   reader  normalizator to set up
+         * @param   viewPtr receives the view keeping the pixels of a graphics file alive
+         * @param   log     receives the error description
+         * @return  success flag (RES_OK/RES_ERROR)
+         */
+        int setupReader(CNormalizator &reader, QSharedPointer<CNativeData> &viewPtr, QString &log)
+        {
+            QSharedPointer<const CDecodePlan> plan;
+            char       *dataPtr;
+            quint32     rowStride;
+
+            if(imgSource == SOURCE_FILE)
+            {
+                //Graphics files are read from the ARGB32 visual data.
+                viewPtr = getVisualDataView();
+                dataPtr = viewPtr->getDataPtr();
+                rowStride = 0;
+            }
+            else
+            {
+                dataPtr = getNativeFramePtr();
+                rowStride = rowStrideInBits;
+            }
+
+            if(dataPtr == NULL)
+            {
+                log = "No native data attached.";
+                return RES_ERROR;
+            }
+
+            plan = CDecodePlan::compile((imgSource == SOURCE_FILE)?QString("B8G8R8A8"):myPixelFormat, &log);
+            if(plan.isNull())
+                return RES_ERROR;
+
+            plan->applyTo(reader);
+            reader.setImageWidth(iwidth);
+            reader.setImageHeight(iheight);
+            reader.setRowStride(rowStride);
+            reader.setNativeDataPtr(dataPtr);
+            reader.adjustCapacity();
+            return RES_OK;
+        }
+
+//------frame sequence
+     private:
+        QSharedPointer<CFrameSequence>   frameSequencePtr;
+        qint32                           currentFrame;
+        qint32                           requestedFrame;
+     public:
+        bool               isSequence(){return !frameSequencePtr.isNull();}
+        qint32             getFrameCount(){return frameSequencePtr.isNull()?1:frameSequencePtr->getFrameCount();}
+        qint32             getCurrentFrame(){return currentFrame;}
+        qint32             getRequestedFrame(){return requestedFrame;}
+        char*              getNativeFramePtr()
+                           {if(nativeDataPtr.isNull()) return NULL;
+                            return frameSequencePtr.isNull()?nativeDataPtr->getDataPtr():frameSequencePtr->getFramePtr(currentFrame);}
+
+//------render data (tiles of the shown image, made on demand and kept by CRenderCache)
      private:
-        QPixmap           *renderDataPtr;
+        bool               renderActive;
      public:
-        const QPixmap     *getRenderDataPtr(){return renderDataPtr;}
+        bool               isRenderable(){return renderActive;}
 
 //------name
     private:
         QString            myName;
     public:
+        /*! Called on every rename, keeps the registry name index up to date (see globals.cpp). */
+        static void      (*renameHook)(const void *imgContextPtr, const QString &newName);
+
         void setMyName(QString name)
         {
+            bool renamed = (myName != name);
+
             myName = name;
             myThumbnail.dont_process_an_update_event = true;
             myThumbnail.setText(name);
             myThumbnail.setToolTip(name);
             myThumbnail.dont_process_an_update_event = false;
+
+            if(renamed && renameHook)
+                renameHook(this, name);
         }
         QString            getMyName(){return myName;}
 
@@ -333,15 +467,19 @@ public:
 //------thumbnail
         CThumbnail         myThumbnail;
 
-//------image context list aux. members
+//------registry ID (see CImgRegistry)
     private:
-         QSharedPointer<CImgContext>      prev;
-         QSharedPointer<CImgContext>      next;
+         quint32                          myID;
     public:
-         QSharedPointer<CImgContext>      getPrevPtr(){return prev;}
-         QSharedPointer<CImgContext>      getNextPtr(){return next;}
-         void                             setPrevPtr(const QSharedPointer<CImgContext> &_prev) {prev = _prev;}
-         void                             setNextPtr(const QSharedPointer<CImgContext> &_next) {next = _next;}
+         quint32                          getMyID(){return myID;}
+         void                             setMyID(quint32 id){myID = id;}
+
+//------payload hash (see CImgRegistry::findByContentHash), zero when unknown
+    private:
+         quint64                          contentHash;
+    public:
+         quint64                          getContentHash(){return contentHash;}
+         void                             setContentHash(quint64 hash){contentHash = hash;}
 
 //------active focus tracking
     private:
@@ -349,26 +487,25 @@ public:
     public:
          void SetFocus(panelID pID)
          {
+             touch();
              if(myState == STATE_READY)
              {
                 activeInPanel[pID] = 1;
-                if(renderDataPtr == NULL)
+                if(!renderActive)
                     produceRenderableData();
              }
          }
 
          void LostFocus(panelID pID)
          {
+             touch();
              activeInPanel[pID] = 0;
 
              if((activeInPanel[panelLeftTop] == 0)&&
                 (activeInPanel[panelRightBottom] == 0))
              {
-                 if(renderDataPtr)
-                 {
-                    delete renderDataPtr;
-                    renderDataPtr = NULL;
-                 }
+                 renderActive = false;
+                 CRenderCache::drop(myID);
              }
          }
 
@@ -377,9 +514,143 @@ public:
              return (activeInPanel[pID])?true:false;
          }
 
-//------aux info
+//------memory accounting and eviction (see Globals::evictImages)
+    private:
+         static QAtomicInt                viewClock;
+         quint32                          lastViewStamp;
+         bool                             pinned;
+         bool                             toolOutput;
+    public:
+         /*! Marks the image as the most recently viewed one. */
+         void                             touch(){lastViewStamp = viewClock.fetchAndAddOrdered(1) + 1;}
+         quint32                          getLastViewStamp(){return lastViewStamp;}
+
+         /*! Pinned images are never evicted. */
+         void                             setPinned(bool value){pinned = value;}
+         bool                             isPinned(){return pinned;}
+
+         /*! Images produced by the tools (comparator, recaster) are reported separately. */
+         void                             setToolOutput(bool value){toolOutput = value;}
+         bool                             isToolOutput(){return toolOutput;}
+
+//------stream mode (see CStreamTable)
+    private:
+         quint32                          streamSkipped;
+         quint64                          streamTicket;
+    public:
+         /*! The arrival order of the frame within its stream (0 when the image is not a stream frame). */
+         void                             setStreamTicket(quint64 value){streamTicket = value;}
+         quint64                          getStreamTicket(){return streamTicket;}
+
+         /*! The number of frames of the image stream skipped so far, when the image is a stream frame. */
+         void                             setStreamSkipped(quint32 value){streamSkipped = value;}
+         quint32                          getStreamSkipped(){return streamSkipped;}
+
+         /*! Takes over the view (position, zoom, flags and linear filter) of the previous frame of the stream. */
+         void                             adoptViewOf(const QSharedPointer<CImgContext> &previousPtr)
+         {
+             setImgOffset(axX, previousPtr->getImgOffset(axX));
+             setImgOffset(axY, previousPtr->getImgOffset(axY));
+             setZoomFactor(previousPtr->getZoomFactor());
+             setFlags(previousPtr->getFlags());
+             for(int i = 0; i < 3; i++)
+             {
+                 setBias((channel)i, previousPtr->getBias((channel)i));
+                 setMul((channel)i, previousPtr->getMul((channel)i));
+                 setDiv((channel)i, previousPtr->getDiv((channel)i));
+             }
+         }
+
+         /*!
+          * \brief  Returns the bytes held by the image, by category.
+          * \param  countedBlocks native and visual data blocks already accounted for (may be
+          *         shared between images, e.g. after reinterpretation or by duplicates);
+          *         updated on return
+          */
+         dMemoryUsage getMemoryUsage(QSet<const void*> *countedBlocks = NULL)
+         {
+             THREAD_SAFE
+             dMemoryUsage usage = {0, 0, 0, 0, 0};
+
+             if((countedBlocks == NULL)||(!countedBlocks->contains(visualData.getBlockKey())))
+                 usage.visualBytes = visualData.getSizeInBytes();
+             if(countedBlocks)
+                 countedBlocks->insert(visualData.getBlockKey());
+             //Keyed by the payload, a view of a graphics file image is its visual data.
+             if(!nativeDataPtr.isNull())
+             {
+                 if((countedBlocks == NULL)||(!countedBlocks->contains(nativeDataPtr->getData().constData())))
+                     usage.nativeBytes = nativeDataPtr->getData().size();
+                 if(countedBlocks)
+                     countedBlocks->insert(nativeDataPtr->getData().constData());
+             }
+             usage.renderBytes = CRenderCache::getImageBytes(myID);
+             if(!frameSequencePtr.isNull())
+                 usage.sequenceBytes = frameSequencePtr->getCacheSizeInBytes();
+             usage.thumbnailBytes = (quint64)snapshotThumbnail.bytesPerLine()*snapshotThumbnail.height();
+             if(!myThumbnail.icon().isNull())
+                 usage.thumbnailBytes += (quint64)UI_THUMBNAIL_SIZE*UI_THUMBNAIL_SIZE*4;
+             return usage;
+         }
+
+         /*! Returns the number of bytes held by the image, see getMemoryUsage. */
+         quint64 getMemoryFootprint(QSet<const void*> *countedBlocks = NULL)
+         {
+             dMemoryUsage usage = getMemoryUsage(countedBlocks);
+
+             return usage.nativeBytes + usage.visualBytes + usage.renderBytes + usage.sequenceBytes + usage.thumbnailBytes;
+         }
+
+//------progress of the work on the image (updated by the workers, formatted by the view)
+    public:
+         CProgress progress;
+
+//------thumbnail restored from a session snapshot or kept for a spilled image (shown until the data is decoded)
+    public:
+         QImage snapshotThumbnail;
+
+         /*! Drops the snapshot once the data is decoded (under the lock, see getMemoryUsage). */
+         void dropSnapshotThumbnail(){THREAD_SAFE {snapshotThumbnail = QImage();}}
+
+         QImage getThumbnailImage()
+         {
+             THREAD_SAFE
+             if(myState == STATE_SPILLED)
+                 return snapshotThumbnail;
+             return visualData.scaled(UI_THUMBNAIL_SIZE, UI_THUMBNAIL_SIZE, Qt::KeepAspectRatio);
+         }
+
+//------spill file location (see CSpillStore)
     public:
-         QString auxInfo;
+         qint64  spillOffset;
+         quint32 spillSize;
+
+         /*!
+          * \brief Drops the data of a spilled image, keeping its thumbnail and view state.
+          *        The image must not be shown in any panel.
+          */
+         void dropSpilledData()
+         {
+             THREAD_SAFE
+             snapshotThumbnail = visualData.scaled(UI_THUMBNAIL_SIZE, UI_THUMBNAIL_SIZE, Qt::KeepAspectRatio);
+             nativeDataPtr.clear();
+             visualData = CTiledImage();
+             myState = STATE_SPILLED;
+             need_thumbnail_refresh = true;
+         }
+
+         /*!
+          * \brief Returns an image whose fault-in has failed to the spilled state; the spill
+          *        file still holds its data and the snapshot thumbnail is kept.
+          */
+         void restoreSpilled()
+         {
+             THREAD_SAFE
+             nativeDataPtr.clear();
+             visualData = CTiledImage();
+             myState = STATE_SPILLED;
+             need_thumbnail_refresh = true;
+         }
 
 
 //------
@@ -426,7 +697,7 @@ public:
             myThumbnail.setFlags(myThumbnail.flags()|Qt::ItemIsEditable);
             myThumbnail.setMyParent((void*)this);
 
-            myNormalizator.setMyParent(reinterpret_cast<void*>(this));
+            myNormalizator.setProgress(&progress);
 
             flag_bitfield = 0x81E;
 
@@ -434,8 +705,21 @@ public:
             setMyName("LOADING");
             activeInPanel[0] = activeInPanel[1] = 0;
 
-            renderDataPtr = NULL;
+            renderActive = false;
             rowStrideInBits = 0;
+            currentFrame = 0;
+            requestedFrame = 0;
+            contentHash = 0;
+
+            pinned = false;
+            toolOutput = false;
+            streamSkipped = 0;
+            streamTicket = 0;
+            touch();
+
+            spillOffset = 0;
+            spillSize = 0;
+            myID = 0;
         }
 
        /*!
@@ -472,6 +756,10 @@ public:
             {
                 thumbPainter.drawImage(0,0, visualData.scaled(UI_THUMBNAIL_SIZE, UI_THUMBNAIL_SIZE, Qt::KeepAspectRatio));
             }
+            else if(((myState == STATE_BUSY)||(myState == STATE_SPILLED))&&(!snapshotThumbnail.isNull()))
+            {
+                thumbPainter.drawImage(0,0, snapshotThumbnail);
+            }
             else if(myState == STATE_BUSY)
             {
                 QPixmap tmpPM = QPixmap(":/icos/wait.png");
@@ -483,12 +771,16 @@ public:
                 thumbPainter.drawPixmap(0,0, tmpPM.scaled(UI_THUMBNAIL_SIZE, UI_THUMBNAIL_SIZE, Qt::KeepAspectRatio));
             }
 
+            if(pinned)
+                thumbPainter.fillRect(UI_THUMBNAIL_SIZE - UI_THUMBNAIL_PIN_MARK_SIZE, 0, UI_THUMBNAIL_PIN_MARK_SIZE, UI_THUMBNAIL_PIN_MARK_SIZE, Qt::darkRed);
+
             myThumbnail.dont_process_an_update_event = true;
             myThumbnail.setFlags(myThumbnail.flags()&~Qt::ItemIsSelectable);
             myThumbnail.setIcon(QIcon(thumbnail));
             need_thumbnail_refresh = false;
 
-            if(myState == STATE_READY)
+            //Selecting a spilled image faults it back in.
+            if((myState == STATE_READY)||(myState == STATE_SPILLED))
                 myThumbnail.setFlags(myThumbnail.flags() | Qt::ItemIsSelectable);
             myThumbnail.dont_process_an_update_event = false;
         }
@@ -499,10 +791,88 @@ public:
          */
         void attachNativeData(const QSharedPointer<CNativeData> _nativeDataPtr)
         {
+             THREAD_SAFE
              nativeDataPtr = _nativeDataPtr;
         }
 
 
+        /*!
+         * \brief Frame sequence attacher.
+         *        The already decoded visual data becomes the first frame of the sequence.
+         * \param _frameSequencePtr - a sequence sharing this context native data.
+         */
+        void attachFrameSequence(const QSharedPointer<CFrameSequence> &_frameSequencePtr)
+        {
+            {
+                THREAD_SAFE
+                frameSequencePtr = _frameSequencePtr;
+            }
+            currentFrame = 0;
+            requestedFrame = 0;
+            frameSequencePtr->setCursor(0);
+            frameSequencePtr->storeFrame(0, visualData);
+            CFrameSequence::prefetch(frameSequencePtr, 0);
+        }
+
+        /*!
+         * \brief Switches the visual data to the given frame of the sequence.
+         *        A cached (prefetched) frame is swapped in immediately. On a cache miss
+         *        the nearest cached frame stands in and the frame is decoded in the
+         *        background (see showPendingFrame), scrubbing never waits for a decode.
+         * \param index frame index
+         * \return success flag (RES_OK/RES_ERROR)
+         */
+        int showFrame(qint32 index)
+        {
+            CTiledImage frame;
+
+            if((frameSequencePtr.isNull())||(myState != STATE_READY))
+                return RES_ERROR;
+
+            index = max(0, min(index, frameSequencePtr->getFrameCount()-1));
+            requestedFrame = index;
+            if(index == currentFrame)
+                return RES_OK;
+
+            frameSequencePtr->setCursor(index);
+            CFrameSequence::prefetch(frameSequencePtr, index);
+            if(!frameSequencePtr->getCachedFrame(index, frame))
+            {
+                index = frameSequencePtr->getNearestCachedFrame(index, frame);
+                if((index < 0)||(index == currentFrame))
+                    return RES_OK;
+            }
+
+            if(frame.isNull())
+                return RES_ERROR;
+
+            {
+                THREAD_SAFE
+                visualData = frame;
+                currentFrame = index;
+                myNormalizator.setNativeDataPtr(frameSequencePtr->getFramePtr(index));
+            }
+
+            if(renderActive)
+                produceRenderableData();
+            return RES_OK;
+        }
+
+        /*!
+         * \brief Swaps in the requested frame once it has been decoded (see showFrame).
+         * \return true when the shown frame has changed
+         */
+        bool showPendingFrame()
+        {
+            CTiledImage frame;
+
+            if((frameSequencePtr.isNull())||(myState != STATE_READY)||(requestedFrame == currentFrame))
+                return false;
+            if(!frameSequencePtr->getCachedFrame(requestedFrame, frame))
+                return false;
+            return (showFrame(requestedFrame) == RES_OK);
+        }
+
        /*!
         * \brief   File image loader.
         * @param   filename QFileInfo object
@@ -511,15 +881,17 @@ public:
 
         int loadFromFile(QFileInfo filename)
         {
+            QImage fileData;
+
             setMyName(filename.fileName());
 
-            if(!visualData.load(filename.absoluteFilePath()))
+            if(!fileData.load(filename.absoluteFilePath()))
                 return RES_ERROR;
 
-            iwidth  = visualData.width();
-            iheight = visualData.height();
+            iwidth  = fileData.width();
+            iheight = fileData.height();
 
-            visualData = visualData.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            setVisualData(CTiledImage::fromImage(fileData.convertToFormat(QImage::Format_ARGB32_Premultiplied)));
 
             myNotes = "Loaded from: " + filename.absolutePath();
             myPixelFormat = "B8G8R8A8";
@@ -536,8 +908,14 @@ public:
 
          int saveToGraphicsFile(const QString &filename)
          {
-             THREAD_SAFE
-             return (visualData.save(filename))?RES_OK:RES_ERROR;
+             CTiledImage visual;
+
+             //Encoded without the lock, the pixels are implicitly shared.
+             {
+                 THREAD_SAFE
+                 visual = visualData;
+             }
+             return (visual.toImage().save(filename))?RES_OK:RES_ERROR;
          }
 
          /*!
@@ -552,61 +930,103 @@ public:
 
          int saveToRICFile(const QString &filename)
          {
-             THREAD_SAFE
              QFile   ofile(filename);
-             dHeader header;
+             int     res;
+
              if(!ofile.open(QIODevice::WriteOnly))
                  return RES_ERROR;
 
-             WRITE_AND_VERIFY(magichars, MAGIC_CHARS_SIZE);
+             res = writeRIC(ofile);
+             ofile.close();
+             return res;
+         }
+
+         /*!
+          * \brief  Writes the RIC container (header, strings and data) to an open device.
+          * \param  ofile device opened for writing
+          * \return success flag (RES_OK/RES_ERROR)
+          */
+
+         int writeRIC(QIODevice &ofile)
+         {
+             dRICSnapshot snapshot;
+
+             if(snapshotRIC(snapshot) != RES_OK)
+                 return RES_ERROR;
+             return writeRIC(ofile, snapshot);
+         }
+
+         /*!
+          * \brief  Takes what writeRIC writes. The data is implicitly shared: it is taken under
+          *         the lock and written without it (the writers replacing it are held off by the
+          *         data lock, see lockDataForRead).
+          * \return RES_ERROR for a raw image without native data
+          */
+
+         int snapshotRIC(dRICSnapshot &snapshot)
+         {
+             THREAD_SAFE
+
+             snapshot.raw = (imgSource == SOURCE_RAW);
+             snapshot.nativeData = nativeDataPtr;
+             snapshot.visual = visualData;
+             snapshot.formatBytes = myPixelFormat.toLatin1();
+             snapshot.nameBytes = myName.toLatin1();
+             snapshot.notesBytes = myNotes.toLatin1();
+             if(snapshot.raw && snapshot.nativeData.isNull())
+                 return RES_ERROR;
 
-             header.width = this->iwidth;
-             header.height = this->iheight;
-             header.formatStrLength = this->myPixelFormat.size();
-             if(imgSource == SOURCE_RAW)
+             snapshot.header.width = this->iwidth;
+             snapshot.header.height = this->iheight;
+             snapshot.header.formatStrLength = snapshot.formatBytes.size();
+             snapshot.header.nameLength = snapshot.nameBytes.size();
+             snapshot.header.notesLength = snapshot.notesBytes.size();
+             snapshot.header.rowStrideInBits = rowStrideInBits;
+             snapshot.header.auxFiltering = 0;
+             for(int i = 0; i < 4; i++)
              {
-                if(!nativeDataPtr.isNull())
-                    header.sizeInBytes = this->nativeDataPtr->getData().size();
-                else
-                    goto __EXIT_WITH_ERROR;
+                 snapshot.header.normGain[i] = pgain[i];
+                 snapshot.header.normBias[i] = pbias[i];
              }
+             if(snapshot.raw)
+                 snapshot.header.sizeInBytes = snapshot.nativeData->getData().size();
              else
-                header.sizeInBytes = this->visualData.height()*this->visualData.bytesPerLine();
-
-             header.nameLength = this->myName.size();
-             header.notesLength = this->myNotes.size();
-             header.rowStrideInBits = rowStrideInBits;
-             header.auxFiltering = 0;
-
-             header.normGain[0] = pgain[0];
-             header.normGain[1] = pgain[1];
-             header.normGain[2] = pgain[2];
-             header.normGain[3] = pgain[3];
+                 snapshot.header.sizeInBytes = (quint64)snapshot.visual.height()*snapshot.visual.width()*4;
+             return RES_OK;
+         }
 
-             header.normBias[0] = pbias[0];
-             header.normBias[1] = pbias[1];
-             header.normBias[2] = pbias[2];
-             header.normBias[3] = pbias[3];
+         /*! Returns the number of bytes writeRIC writes for <snapshot>. */
+         static quint64 getRICSize(const dRICSnapshot &snapshot)
+         {
+             return MAGIC_CHARS_SIZE + sizeof(dHeader) + (quint64)snapshot.formatBytes.size() + snapshot.nameBytes.size()
+                    + snapshot.notesBytes.size() + snapshot.header.sizeInBytes;
+         }
 
-             WRITE_AND_VERIFY((char*)&header, sizeof(dHeader));
-             WRITE_AND_VERIFY(myPixelFormat.toLatin1().data(), myPixelFormat.size());
-             WRITE_AND_VERIFY(myName.toLatin1().data(), myName.size());
-             WRITE_AND_VERIFY(myNotes.toLatin1().data(),  myNotes.size());
+         static int writeRIC(QIODevice &ofile, const dRICSnapshot &snapshot)
+         {
+             WRITE_AND_VERIFY(magichars, MAGIC_CHARS_SIZE);
+             WRITE_AND_VERIFY((const char*)&snapshot.header, sizeof(dHeader));
+             WRITE_AND_VERIFY(snapshot.formatBytes.constData(), snapshot.formatBytes.size());
+             WRITE_AND_VERIFY(snapshot.nameBytes.constData(), snapshot.nameBytes.size());
+             WRITE_AND_VERIFY(snapshot.notesBytes.constData(), snapshot.notesBytes.size());
 
-             if(imgSource == SOURCE_RAW)
+             if(snapshot.raw)
              {
-                WRITE_AND_VERIFY(nativeDataPtr->getData().data(), nativeDataPtr->getData().size());
+                WRITE_AND_VERIFY(snapshot.nativeData->getDataPtr(), snapshot.nativeData->getData().size());
              }
              else
              {
-                 for(int i = 0; i < visualData.height(); i++)
-                    WRITE_AND_VERIFY(visualData.scanLine(i), visualData.bytesPerLine());
+                 //Scanlines are written tile by tile.
+                 for(int i = 0; i < snapshot.visual.height(); i++)
+                     for(int col = 0; col < snapshot.visual.tileColumns(); col++)
+                     {
+                         const QImage &tile = snapshot.visual.tile(col, i/IMG_TILE_SIZE);
+                         WRITE_AND_VERIFY(tile.constScanLine(i%IMG_TILE_SIZE), tile.width()*4);
+                     }
              }
 
-             ofile.close();
              return RES_OK;
          __EXIT_WITH_ERROR:
-             ofile.close();
              return RES_ERROR;
          }
 
@@ -645,7 +1065,8 @@ public:
                                QString       notesStr,
                                const float   gain[4],
                                const float   bias[4],
-                               quint32       auxFilteringFlags)
+                               quint32       auxFilteringFlags,
+                               const CTiledImage *sharedVisualData = NULL)
         {
             iwidth = width;
             iheight = height;
@@ -659,28 +1080,69 @@ public:
             if(nativeDataPtr.isNull())
                 return RES_ERROR;
 
-            //Initialize a normalizator.
+            //A new decode, cancelled with the image or by a newer frame.
+            CCancelToken cancelToken;
+            cancelToken.linkTo(lifetimeToken);
+            {
+                THREAD_SAFE
+                decodeToken = cancelToken;
+            }
+            myNormalizator.setCancelToken(cancelToken);
+
+            //Initialize a normalizator; images sending the same format share one compiled plan.
 
-            CBitParser myFormatParser;
-            if(myFormatParser.parse(&myNormalizator, formatStr) != RES_OK)
+            QString                           parseLog;
+            QSharedPointer<const CDecodePlan> plan = CDecodePlan::compile(formatStr, &parseLog);
+            if(plan.isNull())
             {
                 myNotes = "Format string parsing error: \n";
-                myNotes += myFormatParser.lastLog;
+                myNotes += parseLog;
                 return RES_ERROR;
             }
             else
             {
+                plan->applyTo(myNormalizator);
+
                 //check buffer size
-                if((iwidth*iheight*myNormalizator.getEffectiveBitCount()+rowStrideInBits*iheight)/8 > quint32(nativeDataPtr->getData().size()))
+                quint64 declaredSize = ((quint64)iwidth*iheight*plan->getEffectiveBitCount()+(quint64)rowStrideInBits*iheight)/8;
+                if(declaredSize > quint64(nativeDataPtr->getData().size()))
                 {
-                    myNotes = "Error: Invalid native data block size. Declared: " + QString::number((iwidth*iheight*myNormalizator.getEffectiveBitCount()+rowStrideInBits*iheight)/8)\
+                    myNotes = "Error: Invalid native data block size. Declared: " + QString::number(declaredSize)\
                             + "B, received: " + QString::number(nativeDataPtr->getData().size()) + "B.";
                     return RES_ERROR;
                 }
 
+                //Decode in a helper process when enabled; it takes the crash of a bad payload.
+                CTiledImage helperVisualData;
+                float       helperGain[4], helperBias[4];
+                if((sharedVisualData == NULL)&&CDecodeHelpers::isEnabled())
+                {
+                    int helperRes = CDecodeHelpers::decode(formatStr, iwidth, iheight, rowStrideInBits, gain, bias, auxFilteringFlags,
+                                                           nativeDataPtr->getDataPtr(), nativeDataPtr->getData().size(),
+                                                           &helperVisualData, helperGain, helperBias, cancelToken);
+                    if(helperRes == DECODE_HELPER_CANCELLED)
+                    {
+                        setVisualData(CTiledImage());
+                        myNotes = "Decoding cancelled.";
+                        return RES_ERROR;
+                    }
+                    if(helperRes == DECODE_HELPER_CRASHED)
+                    {
+                        myNotes = "Error: the decoder crashed on this image (it has been retried).";
+                        return RES_ERROR;
+                    }
+                    if(helperRes == DECODE_HELPER_OK)
+                    {
+                        sharedVisualData = &helperVisualData;
+                        gain = helperGain;
+                        bias = helperBias;
+                        auxFilteringFlags &= ~FILTER_FLAG_AUTO_GAIN_BIAS;
+                    }
+                }
+
                 myNormalizator.setImageWidth(iwidth);
                 myNormalizator.setImageHeight(iheight);
-                myNormalizator.setNativeDataPtr(nativeDataPtr->getData().data());
+                myNormalizator.setNativeDataPtr(nativeDataPtr->getDataPtr());
                 myNormalizator.setRowStride(rowStrideInBits);
                 myNormalizator.setREDGain(gain[0]);
                 myNormalizator.setREDBias(bias[0]);
@@ -716,7 +1178,7 @@ public:
                    (myNormalizator.getChannelGain(B)!=1)||
                    (myNormalizator.getChannelGain(A)!=1))
                 {
-                        visualData = myNormalizator.getImageWithFiltering();
+                        setVisualData(sharedVisualData?*sharedVisualData:myNormalizator.getImageWithFiltering());
                         myNotes += "\n--------------------------------------------------\n";
                         myNotes += "###Pre-filters: Gain/Bias values###\n";
                         myNotes += "R: " + QString::number(pgain[0], 'g') + " / " + QString::number(pbias[0], 'g') +"\n";
@@ -726,7 +1188,16 @@ public:
                         myNotes += "--------------------------------------------------\n";
                 }
                    else
-                        visualData = myNormalizator.getImage();
+                        setVisualData(sharedVisualData?*sharedVisualData:myNormalizator.getImage());
+
+               progress.end();
+
+               if(cancelToken.isCancelled())
+               {
+                   setVisualData(CTiledImage());
+                   myNotes = "Decoding cancelled.";
+                   return RES_ERROR;
+               }
 
                need_renderData_refresh = true;
             }
@@ -740,21 +1211,163 @@ public:
         }
 
         /*!
-         * \brief Renderable data creator.
+         * \brief Loads a byte-identical copy of an already decoded image. The native and
+         *        visual data of the original are shared, nothing is decoded.
+         * \param original   image whose payload hashed to the same value
+         * \param headerRef  header of the new payload
+         * \param formatStr  pixel format of the new payload
+         * \param payloadPtr the new payload (headerRef.sizeInBytes bytes)
+         * \param nameStr    image name string
+         * \param notesStr   image notes string
+         *
+         * @return  RES_ERROR when the original holds different data or is no longer decoded
+         */
+
+        int loadAliasOf(const QSharedPointer<CImgContext> &original,
+                        const dHeader &headerRef,
+                        QString        formatStr,
+                        const char    *payloadPtr,
+                        QString        nameStr,
+                        QString        notesStr)
+        {
+            QSharedPointer<CNativeData> sharedNativeData;
+            CTiledImage                 sharedVisualData;
+            float                       gain[4];
+            float                       bias[4];
+
+            {
+                QMutexLocker lock(&original->internalLock);
+
+                if((original->myState != STATE_READY)||
+                   (original->nativeDataPtr.isNull())||
+                   (!original->frameSequencePtr.isNull()))
+                    return RES_ERROR;
+
+                if((original->iwidth != qint32(headerRef.width))||
+                   (original->iheight != qint32(headerRef.height))||
+                   (original->rowStrideInBits != headerRef.rowStrideInBits)||
+                   (original->myPixelFormat != formatStr))
+                    return RES_ERROR;
+
+                sharedNativeData = original->nativeDataPtr;
+                sharedVisualData = original->visualData;
+                memcpy(gain, original->pgain, sizeof(gain));
+                memcpy(bias, original->pbias, sizeof(bias));
+            }
+
+            //Equal hashes are not enough to show the data as the same.
+            if((sharedNativeData->getData().size() != int(headerRef.sizeInBytes))||
+               (memcmp(sharedNativeData->getData().constData(), payloadPtr, headerRef.sizeInBytes) != 0))
+                return RES_ERROR;
+
+            attachNativeData(sharedNativeData);
+            return loadFromNativeData(headerRef.width,
+                                      headerRef.height,
+                                      headerRef.rowStrideInBits,
+                                      formatStr,
+                                      nameStr,
+                                      notesStr,
+                                      gain,
+                                      bias,
+                                      headerRef.auxFiltering & ~FILTER_FLAG_AUTO_GAIN_BIAS,
+                                      &sharedVisualData);
+        }
+
+        /*!
+         * \brief Renderable data creator. Render tiles are made on demand, see CRenderCache.
          */
 
         void produceRenderableData()
         {
            THREAD_SAFE
-           if(renderDataPtr)
-               delete renderDataPtr;
-           renderDataPtr = new QPixmap();
-           renderDataPtr->convertFromImage(visualData);
+           CRenderCache::drop(myID);
+           renderActive = true;
            need_renderData_refresh = false;
-           applyPreFilters();
            applyOnTheFlyFilters();
         }
 
+        /*!
+         * \brief Returns the render level for a zoom factor; level L tiles hold every 2^L-th pixel.
+         */
+
+        static qint32 getRenderLevel(float zoomFactor)
+        {
+            qint32 level = 0;
+
+            while((level < RENDER_MAX_LEVEL)&&(zoomFactor*(2 << level) <= 1.0f))
+                level++;
+            return level;
+        }
+
+        /*!
+         * \brief Returns the area of the shown image covered by a render tile.
+         */
+
+        QRect getRenderTileRect(qint32 level, qint32 col, qint32 row)
+        {
+            qint32 span = IMG_TILE_SIZE << level;
+
+            return QRect(col*span, row*span, span, span).intersected(QRect(0, 0, iwidth, iheight));
+        }
+
+        /*!
+         * \brief  Makes a render tile of the shown (flipped and pre-filtered) image from the
+         *         visual data. GUI thread only, the tiles are kept by CRenderCache.
+         * \param  level render level (see getRenderLevel)
+         * \return a null pixmap when the image is not renderable or a writer holds its data
+         */
+
+        QPixmap makeRenderTile(qint32 level, qint32 col, qint32 row)
+        {
+            QPixmap tile;
+
+            //The data is being replaced; the tile is made on a later repaint.
+            if(!lockDataForRead())
+                return tile;
+
+            tile = renderTile(level, col, row);
+            unlockData();
+            return tile;
+        }
+
+    private:
+        QPixmap renderTile(qint32 level, qint32 col, qint32 row)
+        {
+            THREAD_SAFE
+            QPixmap tile;
+            QRect   shownRect, sourceRect;
+            QImage  workData;
+            qint32  scale = 1 << level;
+
+            if((!renderActive)||(visualData.isNull()))
+                return tile;
+
+            shownRect = getRenderTileRect(level, col, row);
+            if(shownRect.isEmpty())
+                return tile;
+
+            sourceRect = shownRect;
+            if(flag_bitfield & IMGCX_HORIZONTAL_FLIP_check)
+                sourceRect.moveLeft(iwidth - shownRect.right() - 1);
+            if(flag_bitfield & IMGCX_VERTICAL_FLIP_check)
+                sourceRect.moveTop(iheight - shownRect.bottom() - 1);
+
+            if(level == 0)
+                workData = visualData.copy(sourceRect);
+            else
+                workData = visualData.scaled(sourceRect, QSize((sourceRect.width() + scale - 1)/scale,
+                                                               (sourceRect.height() + scale - 1)/scale));
+            if(workData.isNull())
+                return tile;
+
+            prefilterPixels(workData);
+            tile.convertFromImage(workData.mirrored(flag_bitfield & IMGCX_HORIZONTAL_FLIP_check,
+                                                    flag_bitfield & IMGCX_VERTICAL_FLIP_check));
+            return tile;
+        }
+
+    public:
+
         /*!
          * \brief Visual data creator.
          */
@@ -766,12 +1379,12 @@ public:
 
             THREAD_SAFE
 
-            visualData = QImage(iwidth, iheight, QImage::Format_ARGB32);
-            visualData.fill(Qt::white);
+            QImage workData(iwidth, iheight, QImage::Format_ARGB32);
+            workData.fill(Qt::white);
 
             for(ih = 0; ih < iheight; ih++)
             {
-                line = (QRgb*)visualData.scanLine(ih);
+                line = (QRgb*)workData.scanLine(ih);
                 for(iw = 0; iw < iwidth; iw++)
                 {
                     *(line + iw) = qRgba(nativeDataPtr->getData()[4*(ih*iheight + iw)],
@@ -780,6 +1393,7 @@ public:
                                          nativeDataPtr->getData()[4*(ih*iheight + iw)+3]);
                 }
             }
+            visualData = CTiledImage::fromImage(workData);
             return RES_OK;
         }
 
@@ -883,27 +1497,29 @@ public:
        }
 
        /*!
-        * \brief Pre-filter trigger.
+        * \brief Pre-filter trigger. The render tiles are made again with the current flags.
         */
 
         void applyPreFilters()
         {
-            if(visualData.isNull())
-                return;
-
-            myState = STATE_BUSY;
+            CRenderCache::drop(myID);
+        }
 
-            QImage workData(visualData);
+       /*!
+        * \brief Applies the pre-filters to a part of the visual data (a render tile).
+        */
 
+        void prefilterPixels(QImage &workData)
+        {
             int     _rows, _cols;
             uchar* pixelPtr         = workData.bits();
             int    nBytesPerLine    = workData.bytesPerLine();
             uchar * scanLine;
 
-            for(_rows=0; _rows<iheight; _rows++)
+            for(_rows=0; _rows<workData.height(); _rows++)
             {
                 scanLine = pixelPtr+_rows*nBytesPerLine;
-                for(_cols=0; _cols<iwidth; _cols++)
+                for(_cols=0; _cols<workData.width(); _cols++)
                 {
                     if(!(flag_bitfield & IMGCX_ALPHA_check))
                        prefilter_alphaFiller_core(&((quint32*)scanLine)[_cols], ((quint32*)scanLine)[_cols]);
@@ -915,10 +1531,6 @@ public:
                        prefilter_YaXpB_core(&((quint32*)scanLine)[_cols], ((quint32*)scanLine)[_cols]);
                 }
             }
-            renderDataPtr->convertFromImage(workData.mirrored(flag_bitfield & IMGCX_HORIZONTAL_FLIP_check,
-                                                          flag_bitfield & IMGCX_VERTICAL_FLIP_check));
-
-            myState = STATE_READY;
         }
 
         /*!
@@ -934,15 +1546,6 @@ public:
                           0xFF);
          }
 
-       /*!
-        * \brief Render data handle getter.
-        */
-
-        QPixmap* getPixMap()
-        {
-            return renderDataPtr;
-        }
-
         //Image pre-filters.
 
        /*!
@@ -0,0 +1,95 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CIMGREGISTRY_H
+#define CIMGREGISTRY_H
+
+#include "CImgContext.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QHash>
+#include <QReadWriteLock>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CImgRegistry class.
+ * \section DESCRIPTION
+ *          The list of loaded images. Every image gets a stable ID on registration; IDs
+ *          grow monotonically, so the ordered index (newest first) is the display order.
+ *          Lookups by ID and by context (the thumbnail widgets point to their contexts)
+ *          are hashed. The name index follows renames through CImgContext::renameHook, as
+ *          names are changed by the loaders after registration. The content index maps payload hashes (see
+ *          contentHash64) to the newest image holding that payload.
+ *
+ *          All members are thread safe. The registry lock is a read/write lock held only
+ *          for the registry itself; callers iterate over snapshots.
+ */
+
+class CImgRegistry
+{
+public:
+                                         CImgRegistry();
+
+    /*! Registers an image and returns its new ID. */
+    quint32                              add(const QSharedPointer<CImgContext> &imgContextPtr);
+
+    /*! Unregisters an image. Returns false when it was not registered. */
+    bool                                 remove(const QSharedPointer<CImgContext> &imgContextPtr);
+
+    /*! Unregisters all images and returns them (newest first). */
+    QList<QSharedPointer<CImgContext> >  takeAll();
+
+    /*! Returns all registered images, newest first. */
+    QList<QSharedPointer<CImgContext> >  snapshot();
+
+    QSharedPointer<CImgContext>          findById(quint32 id);
+    QSharedPointer<CImgContext>          findByContext(const void *imgContextPtr);
+    /*! Returns the newest image named <name>. */
+    QSharedPointer<CImgContext>          findByName(const QString &name);
+    /*! Returns all images named <name>, newest first. */
+    QList<QSharedPointer<CImgContext> >  findAllByName(const QString &name);
+    /*! Returns the newest image whose payload hashed to <hash> (the bytes still have to be compared). */
+    QSharedPointer<CImgContext>          findByContentHash(quint64 hash);
+
+    /*! Sets the payload hash of an image and indexes it (a registered image only). */
+    void                                 setContentHash(const QSharedPointer<CImgContext> &imgContextPtr, quint64 hash);
+
+    /*! Moves an image to <newName> in the name index (a registered image only). */
+    void                                 rename(const void *imgContextPtr, const QString &newName);
+
+    int                                  count();
+
+private:
+    void                                 indexName(quint32 id, const QString &name);
+    void                                 unindexName(quint32 id);
+
+    QReadWriteLock                       registryLock;
+    quint32                              lastId;
+    QMap<quint32, QSharedPointer<CImgContext> >  byOrder;
+    QHash<quint32, QSharedPointer<CImgContext> > byId;
+    QHash<const void*, quint32>          byContext;
+    QHash<QString, QList<quint32> >      byName;
+    QHash<quint32, QString>              nameOf;
+    QHash<quint64, quint32>              byContent;
+};
+
+#endif // CIMGREGISTRY_H
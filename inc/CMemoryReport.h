@@ -0,0 +1,81 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CMEMORYREPORT_H
+#define CMEMORYREPORT_H
+
+#include "CImgContext.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QList>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * Memory usage of a single image.
+ */
+
+typedef struct
+{
+    quint32       id;
+    QString       name;
+    uint          state;
+    bool          pinned;
+    bool          toolOutput;
+    quint32       lastViewStamp;
+    dMemoryUsage  usage;
+}dImageMemoryEntry;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CMemoryReport class.
+ * \section DESCRIPTION
+ *          A snapshot of the memory held by AID: per image and per category (see
+ *          dMemoryUsage), the native buffer pool and the spill file. The image counters
+ *          are read from the images themselves when collected, so they always match what
+ *          the eviction (Globals::evictImages) sees. Blocks shared between images are
+ *          counted once, with the newest image holding them.
+ */
+
+class CMemoryReport
+{
+public:
+                                CMemoryReport();
+
+    /*! Takes a new snapshot. */
+    void                        collect();
+
+    /*! Returns the snapshot as a JSON document. */
+    QString                     toJson();
+
+    /*! Writes the snapshot as a JSON document. */
+    int                         dumpJson(const QString &fileName);
+
+    static quint64              getTotal(const dMemoryUsage &usage);
+
+    QList<dImageMemoryEntry>    images;             //Newest first.
+    dMemoryUsage                totals;
+    quint64                     toolOutputBytes;
+    quint64                     poolLiveBytes;
+    quint64                     poolCachedBytes;
+    quint64                     spillBytes;
+    quint64                     budgetBytes;
+};
+
+#endif // CMEMORYREPORT_H
@@ -21,6 +21,7 @@
 #define CNATIVEDATA_H
 
 #include <QObject>
+#include <QImage>
 
 class CNativeData : public QObject
 {
@@ -28,14 +29,27 @@ class CNativeData : public QObject
 public:
     explicit CNativeData(QObject *parent = 0);
     explicit CNativeData(const QByteArray &data, QObject *parent = 0);
+    /*! Takes ownership of a pooled buffer (see CBufferPool) holding a RIC container. */
     explicit CNativeData(const char* rawBufferDataWithHeader, QObject *parent = 0);
+    /*! Allocates a pooled payload of <sizeInBytes> bytes. */
+    explicit CNativeData(quint32 sizeInBytes, bool zeroFill, QObject *parent = 0);
+    /*! Views the pixels of a 32-bit image in place (B8G8R8A8); copies them only when the
+        normalizator would read past the end of the image buffer. */
+    explicit CNativeData(const QImage &image, QObject *parent = 0);
 
             ~CNativeData();
 
     QByteArray& getData(){return data;}
 
+    /*! Returns the payload pointer; unlike getData().data() it never detaches (copies) a pooled payload. */
+    char*       getDataPtr(){return (fromRAWBuffer||!viewedImage.isNull())?const_cast<char*>(data.constData()):data.data();}
+
+    /*! Returns true when the payload is the pixel buffer of an image, not a copy. */
+    bool        isView(){return !viewedImage.isNull();}
+
 private:
     char*        fromRAWBuffer;
+    QImage       viewedImage;
     QByteArray   data;
 };
 
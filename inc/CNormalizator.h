@@ -21,6 +21,9 @@
 #define CNORMALIZATOR_H
 
 #include "defines.h"
+#include "CTiledImage.h"
+#include "CCancelToken.h"
+#include "CProgress.h"
 
 #include<QVector>
 #include<QImage>
@@ -117,34 +120,44 @@ public:
     void                         setBLUEAbsValueFlag(bool value){this->absBLUEValueFlag = value;}
     void                         setALPHAAbsValueFlag(bool value){this->absALPHAValueFlag = value;}
 
-    /* Image context parent setter. */
-    void                         setMyParent(void* ptr){myParentPtr = ptr;}
+    /* Progress sink (the image context progress), may be NULL. */
+    void                         setProgress(CProgress* ptr){progressPtr = ptr;}
+
+    /* Cancellation token, checked once per row (a cancelled getImage returns a null image). */
+    void                         setCancelToken(const CCancelToken &token){cancelToken = token;}
+    bool                         isCancelled() const {return cancelToken.isCancelled();}
+
+    /* Preemptible decodes yield to the jobs in focus at tile boundaries (no locks may be held). */
+    void                         setPreemptible(bool value){preemptible = value;}
 
 
     /* An image calibration function. */
     void                         calibrate();
 
-    /* Returns a resulting image. */
-    QImage                       getImage();
+    /* Returns a resulting image (tiled, see CTiledImage). */
+    CTiledImage                  getImage();
 
     /* Returns a resulting image with the additional filtering applied. */
-    QImage                       getImageWithFiltering();
+    CTiledImage                  getImageWithFiltering();
 
     /* Returns a string representing a given pixel value. */
     QString                      getPixelValueStr(qint32 iw, qint32 ih, qint32 dispBase = 10);
 
-    /* Writes a normalized pixel value in the form of 32 bit float RGBA. <pixelValue> is a pointer to 4-elements float array. */
-    void                         getPixelValue(quint32 &bitCounter, float* pixelValue);
+    /* Writes a normalized pixel value in the form of 32 bit float RGBA. <pixelValue> is a pointer to 4-elements float array.
+       Read only, so one normalizator may serve many threads. */
+    void                         getPixelValue(quint64 &bitCounter, float* pixelValue) const;
 
     /* Other helpers. */
     void                         adjustCapacity();
-    quint8                       getColumnStride(){return columnStride;}
-    quint32                      getRowStride(){return rowStride;}
+    /* Copies the parsed format (masks, types and flags) of <source>, see CDecodePlan. */
+    void                         copyFormat(const CNormalizator &source);
+    quint8                       getColumnStride() const {return columnStride;}
+    quint32                      getRowStride() const {return rowStride;}
 
 private:
 
-    QRgb                         normSinglePixel(quint32 &bitCounter);
-    QRgb                         normSinglePixelWithFiltering(quint32 &bitCounter);
+    QRgb                         normSinglePixel(quint64 &bitCounter);
+    QRgb                         normSinglePixelWithFiltering(quint64 &bitCounter);
 
 
     vType                        mType[4];
@@ -164,7 +177,9 @@ private:
     quint8                       channelBitCount[4];
     float                        gain[4];
     float                        bias[4];
-    void*                        myParentPtr;
+    CProgress*                   progressPtr;
+    CCancelToken                 cancelToken;
+    bool                         preemptible;
     bool                         absREDValueFlag;
     bool                         absGREENValueFlag;
     bool                         absBLUEValueFlag;
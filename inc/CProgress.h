@@ -0,0 +1,98 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CPROGRESS_H
+#define CPROGRESS_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QString>
+
+/*!
+ * \brief The progressStage enum identifies the work reported by CProgress.
+ */
+enum progressStage{
+    PROGRESS_IDLE = 0,
+    PROGRESS_PRE_PARSING,
+    PROGRESS_PARSING,
+    PROGRESS_FILTERING,
+    PROGRESS_COMPARING,
+    PROGRESS_STATISTICS,
+    PROGRESS_RECASTING
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CProgress class.
+ * \section DESCRIPTION
+ *          Progress of the work on an image: a stage and done/total counters. Workers
+ *          update the atomic counters only (no allocation, safe from any thread); the GUI
+ *          formats them when it repaints (see format). The fields are independent, a
+ *          reader may see a stage with the counters of the previous one for a moment.
+ */
+
+class CProgress
+{
+public:
+    CProgress() : stage(PROGRESS_IDLE), done(0), total(0) {}
+
+    /*! Starts a stage of <totalSteps> steps. */
+    void          begin(progressStage stageId, quint32 totalSteps)
+                  {
+                      done.fetchAndStoreOrdered(0);
+                      total.fetchAndStoreOrdered((int)totalSteps);
+                      stage.fetchAndStoreOrdered(stageId);
+                  }
+
+    void          advance(quint32 doneSteps){done.fetchAndStoreRelaxed((int)doneSteps);}
+
+    void          end(){stage.fetchAndStoreOrdered(PROGRESS_IDLE);}
+
+    progressStage getStage() const {return (progressStage)stage.fetchAndAddOrdered(0);}
+
+    /*! Returns the progress as text, e.g. "Parsing: 42%" (GUI side). */
+    QString       format() const
+                  {
+                      QString stageName;
+                      quint32 doneSteps = (quint32)done.fetchAndAddOrdered(0);
+                      quint32 totalSteps = (quint32)total.fetchAndAddOrdered(0);
+
+                      switch(getStage())
+                      {
+                          case PROGRESS_PRE_PARSING: stageName = "Pre-parsing"; break;
+                          case PROGRESS_PARSING:     stageName = "Parsing"; break;
+                          case PROGRESS_FILTERING:   stageName = "Filtering"; break;
+                          case PROGRESS_COMPARING:   stageName = "Comparing"; break;
+                          case PROGRESS_STATISTICS:  stageName = "Statistics"; break;
+                          case PROGRESS_RECASTING:   stageName = "Recasting"; break;
+                          default:                   return QString();
+                      }
+
+                      if(totalSteps == 0)
+                          return stageName + "...";
+                      return stageName + ": " + QString::number((quint64)qMin(doneSteps, totalSteps)*100/totalSteps) + "%";
+                  }
+
+private:
+    mutable QAtomicInt stage;
+    mutable QAtomicInt done;
+    mutable QAtomicInt total;
+};
+
+#endif // CPROGRESS_H
@@ -0,0 +1,114 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CRENDERCACHE_H
+#define CRENDERCACHE_H
+
+#include <QtGlobal>
+#include <QPixmap>
+#include <QRect>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+
+class CImgContext;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The dRenderTileKey struct identifies a cached render tile.
+ */
+
+typedef struct
+{
+    quint32 imageID;        //Registry ID (see CImgRegistry).
+    quint32 zoomKey;        //Bits of the zoom factor; zero for the level tiles of the image.
+    qint32  level;          //Render level (see CImgContext::getRenderLevel).
+    qint32  col;
+    qint32  row;
+}dRenderTileKey;
+
+inline bool operator==(const dRenderTileKey &a, const dRenderTileKey &b)
+{
+    return (a.imageID == b.imageID)&&(a.zoomKey == b.zoomKey)&&(a.level == b.level)&&(a.col == b.col)&&(a.row == b.row);
+}
+
+inline uint qHash(const dRenderTileKey &key)
+{
+    return (key.imageID*31u + key.zoomKey)*31u + (uint(key.level) << 28) + (uint(key.row) << 14) + uint(key.col);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CRenderCache class.
+ * \section DESCRIPTION
+ *          The render tiles of shown images, shared by both panels. Two kinds of tiles are kept:
+ *          level tiles of an image (its flipped and pre-filtered data, see
+ *          CImgContext::makeRenderTile) and screen tiles, RENDER_TILE_SIZE squares of the
+ *          image already scaled to a zoom factor. A panel composes its view from screen tiles
+ *          without scaling; two panels showing the same image at the same zoom (e.g. with the
+ *          shared position and zoom) make every visible tile once.
+ *
+ *          Least recently used tiles are dropped beyond RENDER_CACHE_MAX_MB. Tiles are made
+ *          in the GUI thread only; the byte counters may be read from any thread.
+ */
+
+class CRenderCache
+{
+public:
+    /*! Returns the screen tile <col>, <row> of an image shown at <zoomFactor>, made on a miss. */
+    static QPixmap      getTile(CImgContext *imgContextPtr, float zoomFactor, qint32 col, qint32 row);
+
+    /*! Returns the area of a screen tile, in pixels of the image scaled by <zoomFactor>. */
+    static QRect        getTileRect(CImgContext *imgContextPtr, float zoomFactor, qint32 col, qint32 row);
+
+    /*! Drops all tiles of an image (its data or view flags changed). */
+    static void         drop(quint32 imageID);
+
+    /*! Returns the bytes held by the tiles of an image. */
+    static quint64      getImageBytes(quint32 imageID);
+
+    /*! Returns the bytes held by all tiles. */
+    static quint64      getTotalBytes();
+
+    /*! Drops all tiles. */
+    static void         clear();
+
+private:
+    static QPixmap      getLevelTile(CImgContext *imgContextPtr, qint32 level, qint32 col, qint32 row);
+    static QPixmap      lookup(const dRenderTileKey &key);
+    static void         store(const dRenderTileKey &key, const QPixmap &tile);
+
+    /*! A cached tile; keeps the per-image counters when the cache drops it. */
+    class CEntry
+    {
+    public:
+                        CEntry(quint32 imageID, const QPixmap &tile);
+                       ~CEntry();
+        QPixmap         pixmap;
+        quint32         imageID;
+        quint64         bytes;
+    };
+
+    static QMutex                        cacheLock;
+    static QCache<dRenderTileKey, CEntry> tiles;
+    static QHash<quint32, quint64>       bytesByImage;
+    static quint64                       totalBytes;
+};
+
+#endif // CRENDERCACHE_H
@@ -0,0 +1,74 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSESSION_H
+#define CSESSION_H
+
+#include "CImgContext.h"
+
+#include <QtGlobal>
+#include <QString>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * Session snapshot file layout (host byte order):
+ *
+ *   SESSION_MAGIC, dSessionHeader,
+ *   then <imageCount> times: dSessionRecord, PNG thumbnail, RIC container (see CImgContext::writeRIC).
+ *
+ * Records are stored from the newest (the list head) to the oldest image.
+ */
+
+typedef struct
+{
+    quint32 version;
+    quint32 imageCount;
+}dSessionHeader;
+
+typedef struct
+{
+    quint32 thumbnailSize;
+    quint32 payloadSize;
+    quint32 viewFlags;
+    float   zoomFactor;
+    qint32  imgOffset[2];
+    quint8  vmul[3];
+    quint8  vdiv[3];
+    quint8  vbias[3];
+    quint8  reserved[3];
+}dSessionRecord;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CSession class.
+ * \section DESCRIPTION
+ *          Session snapshot writer and reader. Both run in the calling thread.
+ *          The writer streams one image at a time into a temporary file, which replaces
+ *          the target file when complete. The reader maps the file, lists all images with
+ *          their stored thumbnails first and then decodes them in parallel.
+ */
+
+class CSession
+{
+public:
+    static int      save(const QString &fileName);
+    static int      restore(const QString &fileName);
+};
+
+#endif // CSESSION_H
@@ -0,0 +1,84 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSPILLSTORE_H
+#define CSPILLSTORE_H
+
+#include "CImgContext.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QFile>
+#include <QMutex>
+#include <QMap>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CSpillStore class.
+ * \section DESCRIPTION
+ *          The second tier for images evicted by the memory budget (see Globals::evictImages).
+ *          Payloads of cold images are appended to a single spill file as RIC containers
+ *          (see CImgContext::writeRIC); the images stay listed with their thumbnails and
+ *          view state in STATE_SPILLED. Selecting a spilled image maps its region of the
+ *          file and decodes it back into the same context.
+ *
+ *          Regions of images faulted back in or removed become holes; a new payload takes
+ *          the first hole it fits (the rest of the hole stays free), or is appended. Holes
+ *          are merged with their neighbours, a hole at the end of the file truncates it.
+ *          The file is removed on exit.
+ */
+
+class CSpillStore
+{
+public:
+    /*! Writes the image payload to the spill file and drops its data. Runs in the calling thread. */
+    static int          spill(const QSharedPointer<CImgContext> &imgContextPtr);
+
+    /*! Starts decoding a spilled image back into its context (the state goes BUSY, then READY). */
+    static void         faultIn(const QSharedPointer<CImgContext> &imgContextPtr);
+
+    /*! Decodes a spilled image back in the calling thread. Returns false when it was not spilled (e.g. already being faulted in). */
+    static bool         faultInNow(const QSharedPointer<CImgContext> &imgContextPtr);
+
+    /*! Copies the spilled RIC container of an image (<spillSize> bytes) to <dstPtr>. */
+    static int          readPayload(const QSharedPointer<CImgContext> &imgContextPtr, char *dstPtr);
+
+    /*! Marks the spill region of an image as free. */
+    static void         release(const QSharedPointer<CImgContext> &imgContextPtr);
+
+    /*! Removes the spill file. */
+    static void         clear();
+
+    /*! Returns the number of bytes held by spilled images. */
+    static quint64      getLiveBytes();
+
+private:
+    static int          openFile();
+    /*! Frees a region, merged with the adjacent holes. Called under the store lock. */
+    static void         addHole(qint64 offset, quint64 size);
+    /*! Moves a spilled image to STATE_BUSY, so only one fault-in takes it. */
+    static bool         claim(const QSharedPointer<CImgContext> &imgContextPtr);
+
+    static QMutex       storeLock;
+    static QFile        spillFile;
+    static quint64      liveBytes;
+    static QMap<qint64, quint64> holes;             //Offset, size.
+};
+
+#endif // CSPILLSTORE_H
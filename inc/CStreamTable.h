@@ -0,0 +1,77 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSTREAMTABLE_H
+#define CSTREAMTABLE_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CStreamTable class.
+ * \section DESCRIPTION
+ *          The "latest wins" streams (see Globals::streamMode). Frames received under the
+ *          same image name form a stream; each frame gets a ticket on arrival, and a frame
+ *          whose ticket is no longer the newest one of its stream is dropped before it is
+ *          decoded. Frames decoded on other threads may finish out of order: each stream
+ *          keeps the ticket of the newest frame published, an older frame finishing later
+ *          is dropped. A published frame replaces the older frames of its stream in the list.
+ *          Every stream counts the frames it skipped.
+ *
+ *          All members are thread safe.
+ */
+
+class CStreamTable
+{
+public:
+    /*! Registers a frame received under <name> and returns its ticket (never 0). */
+    static quint64      admit(const QString &name);
+
+    /*! Returns true when a newer frame than <ticket> has been received under <name>. */
+    static bool         isSuperseded(const QString &name, quint64 ticket);
+
+    /*! Marks a decoded frame as shown; false when a newer frame of <name> has been published already. */
+    static bool         publish(const QString &name, quint64 ticket);
+
+    /*! Counts a frame of <name> dropped in favour of a newer one. */
+    static void         addSkipped(const QString &name);
+
+    /*! Returns the number of frames of <name> skipped so far. */
+    static quint32      getSkipped(const QString &name);
+
+    /*! Forgets all streams. */
+    static void         clear();
+
+private:
+    typedef struct
+    {
+        quint64     lastTicket;
+        quint64     publishedTicket;
+        quint32     skipped;
+    }dStream;
+
+    static QMutex                    tableLock;
+    static QHash<QString, dStream>   streams;
+    static quint64                   lastTicket;
+};
+
+#endif // CSTREAMTABLE_H
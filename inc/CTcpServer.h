@@ -23,6 +23,7 @@
 #include "Threads.h"
 #include "globals.h"
 #include "commons.h"
+#include "CBufferPool.h"
 
 #include <QObject>
 #include <QMutex>
@@ -44,6 +45,7 @@ public:
 
     CSimpleDataContainer()
     {
+        ptrData = NULL;
         currentSize = 0;
         cursor = 0;
     }
@@ -54,7 +56,8 @@ public:
      */
     int init(ulong initSize)
     {
-        ptrData = (char*)malloc(initSize);
+        CBufferPool::release(ptrData);
+        ptrData = CBufferPool::acquire(initSize);
         if(!ptrData)
         {
            // Q_ASSERT(ptrData);
@@ -74,10 +77,11 @@ public:
     {
         if(cursor+size > currentSize)
         {
-            ptrData = (char*)realloc(ptrData, cursor+size);
-            if(!ptrData)
+            char* grownPtr = CBufferPool::grow(ptrData, cursor, cursor+size);
+            if(!grownPtr)
                 return RES_ERROR;
            // Q_ASSERT(ptrData);
+            ptrData = grownPtr;
             currentSize = cursor+size;
         }
 
@@ -90,12 +94,13 @@ public:
     {
         if(cursor+appendSize > currentSize)
         {
-            ptrData = (char*)realloc(ptrData, cursor+appendSize);
-            if(!ptrData)
+            char* grownPtr = CBufferPool::grow(ptrData, cursor, cursor+appendSize);
+            if(!grownPtr)
             {
                // Q_ASSERT(ptrData);
                 return NULL;
             }
+            ptrData = grownPtr;
             currentSize = cursor+appendSize;
         }
 
@@ -106,10 +111,20 @@ public:
 
     ~CSimpleDataContainer()
     {
-        //CNativeData takes ownership od the data buffer.
+        //Unless taken by CNativeData (see takeDataPtr).
+        CBufferPool::release(ptrData);
     }
 
     char* getDataPtr(){return ptrData;}
+
+    /*! Hands the buffer over (CNativeData takes ownership of it). */
+    char* takeDataPtr()
+    {
+        char* resPtr = ptrData;
+        ptrData = NULL;
+        currentSize = 0;
+        return resPtr;
+    }
     ulong getCursor(){return cursor;}
     ulong getAllocatedSpace(){return currentSize;}
 
@@ -0,0 +1,98 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CTILEDIMAGE_H
+#define CTILEDIMAGE_H
+
+#include "defines.h"
+
+#include <QtGlobal>
+#include <QImage>
+#include <QVector>
+#include <QRect>
+#include <QSize>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CTiledImage class.
+ * \section DESCRIPTION
+ *          Decoded (32 bits per pixel) image data kept in IMG_TILE_SIZE square tiles, in
+ *          row-major order; the tiles of the last column and row may be smaller. A single
+ *          QImage (and a QPixmap even more so) is limited in size by Qt and the windowing
+ *          system, tiles are not, and they can be processed and rendered one at a time.
+ *
+ *          An image made with fromImage keeps the source image and its tiles read it in
+ *          place (no copy); the tiles are valid as long as the tiled image is.
+ *          Copies are implicitly shared, as for QImage.
+ */
+
+class CTiledImage
+{
+public:
+                                 CTiledImage();
+                                 CTiledImage(qint32 width, qint32 height, QImage::Format format);
+
+    /*! Returns a tiled view of <image> (converted to ARGB32 unless it is 32 bits per pixel already). */
+    static CTiledImage           fromImage(const QImage &image);
+
+    bool                         isNull() const {return tiles.isEmpty();}
+    qint32                       width() const {return imgWidth;}
+    qint32                       height() const {return imgHeight;}
+    QImage::Format               format() const {return imgFormat;}
+    bool                         hasAlphaChannel() const {return (imgFormat != QImage::Format_RGB32);}
+
+    /* Tile grid access. */
+    qint32                       tileColumns() const {return tileCols;}
+    qint32                       tileRowCount() const {return tileRows;}
+    QRect                        tileRect(qint32 col, qint32 row) const;
+    const QImage&                tile(qint32 col, qint32 row) const {return tiles.at(row*tileCols + col);}
+    /*! Returns a writable tile (detaches it). */
+    QImage&                      tileRef(qint32 col, qint32 row) {return tiles[row*tileCols + col];}
+
+    QRgb                         pixel(qint32 x, qint32 y) const;
+
+    /*! Returns a copy of the given region (clipped to the image). */
+    QImage                       copy(const QRect &rect) const;
+
+    /*! Returns the given region scaled to <size> (nearest pixel), read tile by tile. */
+    QImage                       scaled(const QRect &rect, const QSize &size) const;
+
+    /*! Returns the whole image scaled to fit <width> x <height> (thumbnails). */
+    QImage                       scaled(qint32 width, qint32 height, Qt::AspectRatioMode mode) const;
+
+    /*! Returns the image as one QImage, a null image when Qt cannot hold it. */
+    QImage                       toImage() const;
+
+    /*! Returns the number of bytes held by the tiles. */
+    quint64                      getSizeInBytes() const;
+
+    /*! Returns an address identifying the pixel data (shared between copies), for the memory accounting. */
+    const void*                  getBlockKey() const;
+
+private:
+    qint32                       imgWidth;
+    qint32                       imgHeight;
+    QImage::Format               imgFormat;
+    qint32                       tileCols;
+    qint32                       tileRows;
+    QVector<QImage>              tiles;
+    QImage                       backing;
+};
+
+#endif // CTILEDIMAGE_H
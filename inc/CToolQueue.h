@@ -0,0 +1,89 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CTOOLQUEUE_H
+#define CTOOLQUEUE_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QDateTime>
+#include <QRunnable>
+
+class CWorker;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief A tool job as shown by the tool jobs panel.
+ */
+
+typedef struct
+{
+    quint32     id;
+    QString     description;
+    bool        running;
+    QDateTime   queuedAt;
+    QDateTime   startedAt;
+}dToolJob;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CToolQueue class.
+ * \section DESCRIPTION
+ *          The queue of the tools started by the user: comparisons, recasts and saves.
+ *          Tools run concurrently on the work pool (see CWorkPool), at most getLimit() at
+ *          a time; the rest waits in the queue in the submission order instead of being
+ *          rejected. Access to the images themselves is arbitrated by their data locks
+ *          (see CImgContext::lockDataForRead).
+ *
+ *          All members are thread safe.
+ */
+
+class CToolQueue
+{
+public:
+    /*! Queues a tool worker (created in the calling thread); it is started as soon as the cap allows. */
+    static void                    submit(CWorker *worker, const QString &description);
+
+    /*! Returns the running and the pending jobs, oldest first. */
+    static QList<dToolJob>         snapshot();
+
+    static int                     getRunningCount();
+    static int                     getPendingCount();
+
+    /*! Returns the concurrency cap: Globals::toolConcurrencyLimit, one per pool thread when 0. */
+    static int                     getLimit();
+
+    /*! Starts pending jobs up to the cap (e.g. after the cap has been raised). */
+    static void                    dispatch();
+
+private:
+    friend class CToolTask;
+
+    static void                    jobDone(quint32 id);
+
+    static QMutex                  queueLock;
+    static quint32                 lastId;
+    static QList<dToolJob>         jobs;
+    static QMap<quint32, QRunnable*> pendingTasks;
+};
+
+#endif // CTOOLQUEUE_H
@@ -0,0 +1,155 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CWORKPOOL_H
+#define CWORKPOOL_H
+
+#include "defines.h"
+
+#include <QtGlobal>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QList>
+#include <QVector>
+
+class CTaskGroup;
+class CWorkPoolThread;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CPrioritizedTask class.
+ *        A pool task with a priority (WORK_PRIORITY_*). The priority is asked again each time
+ *        the pool picks the next task, so it follows what the user is currently looking at.
+ */
+
+class CPrioritizedTask : public QRunnable
+{
+public:
+    /*! Called under the pool lock: must be cheap and must not start pool work. */
+    virtual int                        getPriority(){return WORK_PRIORITY_NORMAL;}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CWorkPool class.
+ * \section DESCRIPTION
+ *          The thread pool running all background work: CWorker jobs (see CWorker::selfStart)
+ *          and the subtasks they split into (see CTaskGroup). It has one thread per core,
+ *          started on first use and kept until the application exits.
+ *
+ *          Every pool thread owns a deque. Subtasks started from a pool thread go to its own
+ *          deque and are taken back newest first, while their data is still in the cache;
+ *          work started from other threads goes to a shared injection queue. An idle thread
+ *          takes from its deque, then from the injection queue, and then steals the oldest
+ *          task of another thread.
+ *
+ *          Queued jobs are taken by priority (see CPrioritizedTask), the oldest first among
+ *          equals. Background decodes also give way at tile boundaries: they run the queued
+ *          focus jobs in their own thread before going on (see yieldToFocus).
+ *
+ *          All members are thread safe.
+ */
+
+class CWorkPool
+{
+public:
+    /*! Queues a task. It is deleted after the run when autoDelete() is set. */
+    static void                        start(QRunnable *task);
+    static void                        start(CPrioritizedTask *task);
+
+    /*! Runs the queued WORK_PRIORITY_FOCUS jobs in the calling thread. Called by preemptible work (holding no locks). */
+    static void                        yieldToFocus();
+
+    /*! Returns the number of pool threads. */
+    static int                         getThreadCount();
+
+    /*! Stops the threads once their current tasks end (waits at most WORK_POOL_EXIT_WAIT_MS). Called on exit. */
+    static void                        shutdown();
+
+private:
+    friend class CTaskGroup;
+    friend class CWorkPoolThread;
+
+    typedef struct
+    {
+        QRunnable        *runnable;
+        CPrioritizedTask *prioritized;
+        CTaskGroup       *group;
+    }dPoolTask;
+
+    typedef struct
+    {
+        QMutex            lock;
+        QList<dPoolTask>  tasks;
+    }dTaskDeque;
+
+    static void                        ensureStarted();
+    static int                         currentIndex();
+    static void                        push(const dPoolTask &task);
+    static bool                        take(int index, const CTaskGroup *group, dPoolTask *task);
+    static bool                        takeFrom(QList<dPoolTask> &tasks, const CTaskGroup *group, bool newest, dPoolTask *task);
+    static int                         priorityOf(const dPoolTask &task);
+    static void                        run(const dPoolTask &task);
+    static void                        threadLoop(int index);
+
+    static QMutex                      poolLock;
+    static QWaitCondition              taskAvailable;
+    static QAtomicInt                  queuedCount;
+    static int                         sleepingCount;
+    static bool                        stopping;
+    static QList<dPoolTask>            injected;
+    static QVector<CWorkPoolThread*>   threads;
+    static QVector<dTaskDeque*>        deques;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CTaskGroup class.
+ * \section DESCRIPTION
+ *          A set of subtasks run on CWorkPool (e.g. the row bands of a decode). A thread
+ *          waiting for the group runs the queued tasks of the group itself, so splitting
+ *          work from inside a pool job never leaves the job blocking a pool thread, and
+ *          idle threads steal the rest. The destructor waits for the group.
+ */
+
+class CTaskGroup
+{
+public:
+                                       CTaskGroup();
+                                      ~CTaskGroup();
+
+    /*! Queues a subtask of the group (see CWorkPool::start). */
+    void                               run(QRunnable *task);
+
+    /*! Returns when all subtasks have finished. */
+    void                               wait();
+
+private:
+    friend class CWorkPool;
+
+    void                               taskDone();
+
+    QMutex                             groupLock;
+    QWaitCondition                     allDone;
+    int                                pending;
+};
+
+#endif // CWORKPOOL_H
@@ -21,9 +21,11 @@
 #define THREADS_H
 
 #include "CImgContext.h"
+#include "CWorkPool.h"
 
 #include <QThread>
 #include <QObject>
+#include <QStringList>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //Virtual class for a worker.
@@ -32,8 +34,19 @@ class CWorker : public QObject
     Q_OBJECT
 public:
     CWorker(const QObject* parent){informMeWhenFinished = const_cast<QObject*>(parent);}
+
+    /*! Queues process() on the work pool (see CWorkPool); the worker is deleted afterwards. */
     void         selfStart();
 
+    /*! Returns the pool task running process() (see selfStart), for the callers that schedule it themselves. */
+    CPrioritizedTask* makeTask();
+
+    /*! Prepares the worker to be run by pool threads (called by makeTask, or by the schedulers running it in stages). */
+    void         handOver();
+
+    /*! Pool priority of the job (WORK_PRIORITY_*), asked while it is queued (see CPrioritizedTask). */
+    virtual int  getPriority(){return WORK_PRIORITY_NORMAL;}
+
 public slots:
     virtual void process()=0;
 
@@ -54,13 +67,43 @@ class CWorker_loadFromNativeData : public CWorker
     CWorker_loadFromNativeData(const QObject *parent, const QByteArray &qba);
     CWorker_loadFromNativeData(const QObject *parent, const char *inBuffPtr, int inBuffLength);
     CWorker_loadFromNativeData(const QObject *parent, const QSharedPointer<CImgContext> &imgCtxPtr, uint iwidth, uint iheight, QString pixelFormatStr, uint rowStrideInBits, QString name, QString notes, const float gain[16], const float bias[16], quint32 auxFilteringFlags);
+    /*! Runs all the stages in the calling thread (see CDecodePipeline for the staged run). */
     virtual void               process();
 
+    /*! Validates the header and extracts the strings. RES_ERROR: rejected or superseded, the buffer is released. */
+    int                        parse();
+    /*! Creates (or fills) the context and decodes the payload; returns the image to publish. */
+    QSharedPointer<CImgContext> decode();
+    /*! Reports the end of the job to the listener. */
+    void                       finish();
+
+    /*! RES_OK when the image has been loaded (or skipped by its stream), RES_ERROR when it was rejected or went bad. */
+    int                        getResult(){return loadResult;}
+
+    /*! Treats the payload as a sequence of frames (see CFrameSequence). Zero values are derived from the header. */
+    void                       setFrameSequence(quint32 frameSize, quint32 frameStride, quint32 frameCount);
+
+    /*! Loads into an already listed context instead of creating a new one (used by the session restore). */
+    void                       setTargetContext(const QSharedPointer<CImgContext> &targetImgCtxPtr);
+
+    /*! Frames of the images in focus go first, the other new frames are background work. */
+    virtual int                getPriority();
+
  private:
+   /*! Stream frames: drops the older frames of the stream from the list, or this one when a newer frame is shown. */
+   void                        replaceStreamFrame(QSharedPointer<CImgContext> &newImgCtxPtr);
+
    bool                        reinterpretProcess;
+   int                         loadResult;
+   QString                     frameName;
+   quint64                     streamTicket;
    QSharedPointer<CImgContext> imgCtxPtr;
+   QSharedPointer<CImgContext> targetImgCtxPtr;
+   QSharedPointer<CImgContext> originalImgContextPtr;
+   dHeader                    *headerPtr;
+   const char                 *payloadPtr;
+   quint64                     contentHash;
    char*                       inBuffPtr;
-   QByteArray                  qba;
    int                         inBuffLength;
    QString                     name;
    QString                     notes;
@@ -71,6 +114,23 @@ class CWorker_loadFromNativeData : public CWorker
    float                       gain[4];
    float                       bias[4];
    quint32                     auxFilteringFlags;
+   bool                        sequenceMode;
+   quint32                     frameSize;
+   quint32                     frameStride;
+   quint32                     frameCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorker_decodeSequenceFrames : public CWorker
+{
+ public:
+    CWorker_decodeSequenceFrames(const QSharedPointer<CFrameSequence> &sequencePtr, const QList<qint32> &frameIndices);
+    virtual void                   process();
+
+ private:
+   QSharedPointer<CFrameSequence>  sequencePtr;
+   QList<qint32>                   frameIndices;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -82,10 +142,28 @@ class CWorker_loadFromRICFile : public CWorker
 
     virtual void process();
 
+    /*! Loads a single file with the native data path (in the calling thread). Returns RES_OK or RES_ERROR. */
+    static int   loadFile(const QString &fileName);
+
  private:
    QString       fileName;
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorker_ingestFiles : public CWorker
+{
+ public:
+    CWorker_ingestFiles(const QObject *parent, const QStringList &fileNames, int postAction, const QString &archivePath);
+
+    virtual void process();
+
+ private:
+   QStringList   fileNames;
+   int           postAction;
+   QString       archivePath;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 class CWorker_loadFromGraphicsFile : public CWorker
@@ -136,6 +214,99 @@ class CWorker_saveToRICFile : public CWorker
    QString                     fileName;
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorker_saveToFloatFile : public CWorker
+{
+ Q_OBJECT
+ public:
+
+   /*! Writes decoded float planes (see CFloatExport). The format is chosen by the suffix: pfm or atf. */
+   CWorker_saveToFloatFile(QSharedPointer<CImgContext> _imgContextPtr,
+                           QString _fileName);
+
+   virtual void                process();
+
+ private:
+   QSharedPointer<CImgContext> imgContextPtr;
+   QString                     fileName;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorker_batchExport : public CWorker
+{
+ Q_OBJECT
+ public:
+
+   /*!
+    * \brief Exports all loaded images matching <nameFilter> (wildcard) to <directory>.
+    * \param format one of EXPORT_FORMATS
+    */
+   CWorker_batchExport(const QString &directory, const QString &format, const QString &nameFilter);
+
+   virtual void                process();
+
+   /*! Runs the export in the calling thread, images are saved in parallel. Returns the number of images not exported (failed or skipped). */
+   static int                  exportImages(const QString &directory, const QString &format, const QString &nameFilter);
+
+ private:
+   QString                     directory;
+   QString                     format;
+   QString                     nameFilter;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorker_session : public CWorker
+{
+ Q_OBJECT
+ public:
+
+   /*! Saves (<restore> == false) or restores the whole image list to/from a session file (see CSession). */
+   CWorker_session(const QString &fileName, bool restore);
+
+   virtual void                process();
+
+ private:
+   QString                     fileName;
+   bool                        restore;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorker_spillImage : public CWorker
+{
+ Q_OBJECT
+ public:
+
+   /*! Moves the image data to the spill file (see CSpillStore). The image is expected in STATE_BUSY. */
+   CWorker_spillImage(const QSharedPointer<CImgContext> &imgContextPtr);
+
+   virtual void                process();
+
+ private:
+   QSharedPointer<CImgContext> imgContextPtr;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorker_faultIn : public CWorker
+{
+ Q_OBJECT
+ public:
+
+   /*! Decodes a spilled image back into its context (see CSpillStore). The image is expected in STATE_BUSY.
+       The spill region is released only after a successful decode; otherwise the image returns to STATE_SPILLED. */
+   CWorker_faultIn(const QSharedPointer<CImgContext> &imgContextPtr);
+
+   virtual void                process();
+   virtual int                 getPriority();
+
+ private:
+   QSharedPointer<CImgContext> imgContextPtr;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 class CWorker_ImageComparator : public CWorker
@@ -23,6 +23,8 @@
 #include "qwDecoratedCanvas.h"
 #include "qwStatusBar.h"
 #include "CTcpServer.h"
+#include "CDirectoryWatcher.h"
+#include "CCommandQueue.h"
 
 #ifdef QT4_HEADERS
     #include <QMainWindow>
@@ -53,6 +55,9 @@ public:
 
     bool isServerWorking();
 
+    /*! Turns stream mode on or off, keeps the menu action in sync. */
+    void setStreamMode(bool enabled);
+
 public slots:
     void setSinglePanelMode();
     void setDualPanelVerticalMode();
@@ -62,22 +67,33 @@ public slots:
     void menuApp_LoadRAW();
     void menuApp_SaveAs(){menuApp_SaveAs(Globals::activePanel);}
     void menuApp_RemoveAll();
+    void menuApp_WatchDirectory();
+    void menuApp_ExportAll();
+    void menuApp_SaveSession();
+    void menuApp_RestoreSession();
 
     void menuView_sharedViewParams();
     void menuView_sharedPosition();
     void menuView_sharedZoom();
     void menuView_ChangeAutoScaleOnLoad();
     void menuView_ChangeImageCountLimit();
+    void menuView_ChangeMemoryBudget();
+    void menuView_ShowMemoryUsage();
     void menuView_HexValuesDisplay();
     void menuView_ShowToolbar();
 
     void menuNetwork_GoStop();
     void menuNetwork_ChangePortNumber();
     void menuNetwork_ChangeSocketTimeout();
+    void menuNetwork_StreamMode();
+    void menuNetwork_DecodeHelpers();
+    void menuNetwork_ShowDecodePipeline();
 
     void menuTools_ReinterpretData();
     void menuTools_RecastData();
     void menuTools_DataComparator();
+    void menuTools_ShowToolJobs();
+    void menuTools_ChangeToolConcurrency();
 
     void menuHelpAboutaid();
     void menuHelpAboutQt();
@@ -89,6 +105,7 @@ public slots:
 public slots:
     void refreshThumbnailsLists();
     void commandExecutor();
+    void retryDeferredCommands();
     void mimicMouseMoveOnTheOtherPanel(qwGridCanvas* submitter, QPoint p);
     void mimicWheelOnTheOtherPanel(qwGridCanvas* submitter, QWheelEvent *event);
 
@@ -106,7 +123,10 @@ private:
     QMenu        myMenu;
 
     CTcpServer   myTCPServer;
-    QTimer       commandQueuePoller;
+    CDirectoryWatcher myDirWatcher;
+
+    /* Commands on images locked by a worker, posted again after UI_COMMAND_RETRY_MS. */
+    QVector<cmdS> deferredCommands;
 
     void         loadFromFile();
     void         createMenu();
@@ -126,13 +146,19 @@ private:
     QAction     *actOpen;
     QAction     *actOpenRAW;
     QAction     *actSaveAs;
+    QAction     *actExportAll;
+    QAction     *actSaveSession;
+    QAction     *actRestoreSession;
     QAction     *actRemoveAll;
+    QAction     *actWatchDirectory;
     QAction     *actExit;
 
     //Tools
     QAction     *actReinterpretData;
     QAction     *actRecastData;
     QAction     *actDataComparator;
+    QAction     *actShowToolJobs;
+    QAction     *actChangeToolConcurrency;
 
     //Help
     QAction     *actHelp;
@@ -150,6 +176,8 @@ private:
     QAction     *actHexValuesDisplay;
 
     QAction     *actChangeMaxImagesNumber;
+    QAction     *actChangeMemoryBudget;
+    QAction     *actShowMemoryUsage;
 
     QAction     *actToolbarVisibility;
 
@@ -157,6 +185,9 @@ private:
     QAction     *actGoStop;
     QAction     *actChangePortNumber;
     QAction     *actChangeSocketTimeout;
+    QAction     *actStreamMode;
+    QAction     *actDecodeHelpers;
+    QAction     *actShowDecodePipeline;
 
     //About
     QAction     *actAboutaid;
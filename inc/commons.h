@@ -20,6 +20,8 @@
 #ifndef __COMMONS_H__
 #define __COMMONS_H__
 
+#include <string.h>
+
 /*!
  * Helper functions
  */
@@ -68,4 +70,85 @@ typedef struct
 const char magichars[] = "AID0";
 const unsigned int MAGIC_CHARS_SIZE = 4;
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * 64-bit content hash (the XXH64 algorithm). Used to detect resent payloads, the values
+ * are never stored outside the process.
+ */
+
+const unsigned long long HASH_PRIME64_1 = 11400714785074694791ULL;
+const unsigned long long HASH_PRIME64_2 = 14029467366897019727ULL;
+const unsigned long long HASH_PRIME64_3 = 1609587929392839161ULL;
+const unsigned long long HASH_PRIME64_4 = 9650029242287828579ULL;
+const unsigned long long HASH_PRIME64_5 = 2870177450012600261ULL;
+
+inline unsigned long long hashRotl64(unsigned long long x, int r){return (x << r) | (x >> (64 - r));}
+inline unsigned long long hashRead64(const unsigned char *p){unsigned long long v; memcpy(&v, p, 8); return v;}
+inline unsigned int       hashRead32(const unsigned char *p){unsigned int v; memcpy(&v, p, 4); return v;}
+
+inline unsigned long long hashRound(unsigned long long acc, unsigned long long input)
+{
+    acc += input * HASH_PRIME64_2;
+    acc  = hashRotl64(acc, 31);
+    return acc * HASH_PRIME64_1;
+}
+
+inline unsigned long long hashMergeRound(unsigned long long acc, unsigned long long val)
+{
+    acc ^= hashRound(0, val);
+    return acc * HASH_PRIME64_1 + HASH_PRIME64_4;
+}
+
+inline unsigned long long contentHash64(const void *dataPtr, unsigned long long length, unsigned long long seed = 0)
+{
+    const unsigned char *p = (const unsigned char*)dataPtr;
+    const unsigned char *end = p + length;
+    unsigned long long   h;
+
+    if(length >= 32)
+    {
+        const unsigned char *limit = end - 32;
+        unsigned long long   v1 = seed + HASH_PRIME64_1 + HASH_PRIME64_2;
+        unsigned long long   v2 = seed + HASH_PRIME64_2;
+        unsigned long long   v3 = seed;
+        unsigned long long   v4 = seed - HASH_PRIME64_1;
+
+        do
+        {
+            v1 = hashRound(v1, hashRead64(p)); p += 8;
+            v2 = hashRound(v2, hashRead64(p)); p += 8;
+            v3 = hashRound(v3, hashRead64(p)); p += 8;
+            v4 = hashRound(v4, hashRead64(p)); p += 8;
+        }
+        while(p <= limit);
+
+        h = hashRotl64(v1, 1) + hashRotl64(v2, 7) + hashRotl64(v3, 12) + hashRotl64(v4, 18);
+        h = hashMergeRound(h, v1);
+        h = hashMergeRound(h, v2);
+        h = hashMergeRound(h, v3);
+        h = hashMergeRound(h, v4);
+    }
+    else
+        h = seed + HASH_PRIME64_5;
+
+    h += length;
+
+    for(; p + 8 <= end; p += 8)
+        h = hashRotl64(h ^ hashRound(0, hashRead64(p)), 27) * HASH_PRIME64_1 + HASH_PRIME64_4;
+    if(p + 4 <= end)
+    {
+        h = hashRotl64(h ^ (hashRead32(p) * HASH_PRIME64_1), 23) * HASH_PRIME64_2 + HASH_PRIME64_3;
+        p += 4;
+    }
+    for(; p < end; p++)
+        h = hashRotl64(h ^ ((*p) * HASH_PRIME64_5), 11) * HASH_PRIME64_1;
+
+    h ^= h >> 33;
+    h *= HASH_PRIME64_2;
+    h ^= h >> 29;
+    h *= HASH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
 #endif // COMMONS_H
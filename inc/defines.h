@@ -36,6 +36,18 @@ const char    CL_GLOBAL_FLAGS[]                 ="-gflags";
 const char    CL_PANEL_HORIZONTAL[]             ="-panelh";
 const char    CL_PANEL_VERTICAL[]               ="-panelv";
 const char    CL_FONT_SCALE[]                   ="-fontscale";
+const char    CL_WATCH_DIR[]                    ="-watch";
+const char    CL_WATCH_DELETE[]                 ="-watchdel";
+const char    CL_WATCH_ARCHIVE[]                ="-watcharch";
+const char    CL_EXPORT[]                       ="-export";
+const char    CL_EXPORT_FILTER[]                ="-exportfilter";
+const char    CL_SESSION[]                      ="-session";
+const char    CL_MEMORY_BUDGET[]                ="-membudget";
+const char    CL_SPILL_DIR[]                    ="-spilldir";
+const char    CL_NO_SPILL[]                     ="-nospill";
+const char    CL_STREAM_MODE[]                  ="-stream";
+const char    CL_DECODE_HELPERS[]               ="-decodehelpers";
+const char    CL_DECODE_HELPER_PROCESS[]        ="-decodehelperprocess";
 
 
 
@@ -44,7 +56,7 @@ const char    CL_FONT_SCALE[]                   ="-fontscale";
 const int     COM_DEFAULT_PORT                  =5999;
 const int     COM_TIMER_INTERVAL_MS             =250;
 const int     COM_TIMEOUT_SEC                   =60;
-const int     COM_MAX_DATA_SIZE                 =0x10004000;
+const int     COM_MAX_DATA_SIZE                 =0x7FF04000;
 const int     COM_MAX_PENDING_CONNECTIONS       =30;
 const int     COM_MAX_PROCESSING_THREADS        =2;
 const int     COM_CACHE                         =0xA00000;
@@ -52,6 +64,13 @@ const int     COM_ALIGN_MARGIN_SIZE             =8;
 const char    COM_ALIGN_CHARS[]                 ="\0\0\0\0\0\0\0";
 const char    COM_ACK_CHAR[]                    = "$";
 
+/* Directory watch (file drop) ingest. */
+const int     WATCH_POST_KEEP                   =0x00;
+const int     WATCH_POST_DELETE                 =0x01;
+const int     WATCH_POST_ARCHIVE                =0x02;
+const int     WATCH_BATCH_SIZE                  =32;
+const char    WATCH_PARTIAL_SUFFIXES[]          ="part;tmp;partial";
+
 /* Header flags and limits. */
 const uint    MAX_FORMAT_STRING_LENGTH          =128;
 const uint    MAX_IMG_NAME_LENGTH               =128;
@@ -100,11 +119,104 @@ const uint    UI_TOOLBAR_ICON_SIZE              =24;
 const int     UI_NOTEBOX_MIN_WIDTH              =600;
 const int     UI_NOTEBOX_MIN_HEIGHT             =300;
 
-const uint    MAX_IMAGE_SIZE                    =2048;
-const uint    MAX_IMAGE_BLOCK_SIZE              =0x10000000;
+const uint    MAX_IMAGE_SIZE                    =65536;
+const uint    MAX_IMAGE_BLOCK_SIZE              =0x7FF00000;
+
+//Tiled image storage (see CTiledImage); decoded data and render pixmaps are kept in square tiles.
+const int     IMG_TILE_SIZE                     =1024;
+
+//Render tile cache shared by both panels (see CRenderCache); tiles are square in screen pixels.
+const int     RENDER_TILE_SIZE                  =256;
+const uint    RENDER_CACHE_MAX_MB               =256;
+
+//Frame sequences (multi-frame RAW files).
+const int     SEQ_PREFETCH_RADIUS               =4;
+const uint    SEQ_MAX_FRAME_COUNT               =100000;
+
+//Compiled pixel formats kept for reuse (see CDecodePlan).
+const int     DECODE_PLAN_CACHE_SIZE            =32;
+
+//Float export (PFM and the tiled float container).
+const int     FLOAT_EXPORT_TILE_SIZE            =64;
+const int     FLOAT_EXPORT_ROWS_PER_TASK        =32;
+const quint64 FLOAT_EXPORT_BAND_BYTES           =64*1024*1024;
+const char    FLOAT_EXPORT_TILED_MAGIC[]        ="AIDT";
+
+//Work pool (see CWorkPool).
+const int     WORK_POOL_MIN_THREADS             =2;
+const int     WORK_POOL_HELP_POLL_MS            =10;
+const int     WORK_POOL_EXIT_WAIT_MS            =2000;
+
+//Work pool priorities (see CPrioritizedTask): images in focus go first.
+const int     WORK_PRIORITY_BACKGROUND          =0;
+const int     WORK_PRIORITY_NORMAL              =1;
+const int     WORK_PRIORITY_FOCUS               =2;
+
+//Focus slots (see Globals::setFocusImage), the first two are the panels (panelID).
+const int     FOCUS_SLOT_HOVER                  =2;
+const int     FOCUS_SLOT_COUNT                  =3;
+
+//Decode pipeline stages (see CDecodePipeline) and the bounds of the queues in front of them.
+const int     PIPELINE_STAGE_RECEIVE            =0;
+const int     PIPELINE_STAGE_VALIDATE           =1;
+const int     PIPELINE_STAGE_DECODE             =2;
+const int     PIPELINE_STAGE_PUBLISH            =3;
+const int     PIPELINE_STAGE_COUNT              =4;
+const int     PIPELINE_VALIDATE_QUEUE_DEPTH     =64;
+const int     PIPELINE_DECODE_QUEUE_DEPTH       =16;
+const int     PIPELINE_PUBLISH_QUEUE_DEPTH      =32;
+
+//Out-of-process decoding (see CDecodeHelpers).
+const int     DECODE_HELPER_OK                  =0;
+const int     DECODE_HELPER_FAILED              =1;
+const int     DECODE_HELPER_CRASHED             =2;
+const int     DECODE_HELPER_UNAVAILABLE         =3;
+const int     DECODE_HELPER_CANCELLED           =4;
+const int     DECODE_HELPER_PENDING             =-1;
+const int     DECODE_HELPER_CMD_DECODE          =1;
+const int     DECODE_HELPER_CMD_QUIT            =2;
+const int     DECODE_HELPER_ATTEMPTS            =2;
+const int     DECODE_HELPER_MAX_COUNT           =64;
+const int     DECODE_HELPER_MAX_RESTARTS        =8;
+const int     DECODE_HELPER_START_WAIT_MS       =5000;
+const int     DECODE_HELPER_QUIT_WAIT_MS        =1000;
+const int     DECODE_HELPER_TIMEOUT_MS          =60000;
+const int     DECODE_HELPER_WATCHDOG_MS         =200;
+const int     DECODE_HELPER_CANCEL_POLL_MS      =100;
+
+//Tool jobs (see CToolQueue); a limit of 0 means one per pool thread.
+const uint    TOOL_CONCURRENCY_MAX              =64;
+
+//Batch export.
+const char    EXPORT_FORMATS[]                  ="png;jpg;bmp;ric;pfm;atf";
+
+//Memory budget for loaded images (MB).
+const uint    IMG_MEMORY_BUDGET_DEFAULT_MB      =1024;
+const uint    IMG_MEMORY_BUDGET_MAX_MB          =1048576;
+const uint    IMG_COUNT_LIMIT_MAX               =4096;
+const uint    IMG_COUNT_UNLIMITED               =0;
+
+//Native buffer pool (see CBufferPool).
+const uint    POOL_BLOCK_ALIGNMENT              =64;
+const uint    POOL_MIN_BLOCK_SIZE               =4096;
+const uint    POOL_HUGEPAGE_SIZE                =2097152;
+const uint    POOL_MAX_CACHED_MB                =256;
+
+//Spill file for images evicted by the memory budget.
+const char    SPILL_FILE_PREFIX[]               ="aid_spill_";
+
+//Session snapshots.
+const char    SESSION_MAGIC[]                   ="AIDS";
+const uint    SESSION_VERSION                   =1;
 
 //Thumbnail size.
 const int     UI_THUMBNAIL_SIZE                 =80;
+const int     UI_THUMBNAIL_PIN_MARK_SIZE        =8;
+const int     UI_MEMORY_PANEL_REFRESH_MS        =1000;
+const int     UI_TOOL_JOBS_REFRESH_MS           =500;
+const int     UI_IMAGE_LOCK_WAIT_MS             =5;
+const int     UI_COMMAND_RETRY_MS               =50;
+const int     UI_PIPELINE_REFRESH_MS            =500;
 
 //Status bar
 const int     UI_STATUS_TIP                     =0x01;
@@ -127,8 +239,10 @@ const int     CMD_SHOW_MSGBOX_SAVE_RIC_FAILED   =0x05;
 const int     CMD_CREATE_THUMBNAIL              =0x06;
 const int     CMD_ADD_STATUS_MESSAGE            =0x07;
 const int     CMD_REMOVE_ALL                    =0x08;
-const int     CMD_SHOW_MSGBOX_TOOL_SLOT_BUSY    =0x09;
+//const int     CMD_SHOW_MSGBOX_TOOL_SLOT_BUSY    =0x09;
 const int     CMD_REFRESH_VIEW_PANLES           =0x0A;
+const int     CMD_PUBLISH_IMAGES                =0x0B;
+const int     CMD_SHOW_DECODED_FRAMES           =0x0C;
 
 //Message status queue
 const int     MSG_STATUS_QUEUE_MAX              =20;
@@ -152,7 +266,7 @@ const int      GRID_WIDTH                       =1;
 const int      GRID_BOUND_WIDTH                 =2;
 const int      PIXEL_SELECT_WIDTH               =3;
 const int      PIXEL_SELECTOR_COL               =0xF0F0F0F0;
-const uint     MAX_IMG_SIZE                     =4096;
+const int      RENDER_MAX_LEVEL                 =8;
 const int      PRESS_THRESHOLD                  =2;
 const int      OFFSCREEN_RENDER_MARGIN          =20;
 const int      MESSAGE_FONT_SIZE                =10;
@@ -217,5 +331,6 @@ const char     TIP_MAIN_BCKGROUND_MODE[]        ="Background mode.";
 const char     TIP_MAIN_IMAGE_NOTES[]           ="Image notes.";
 const char     TIP_MAIN_DELETE[]                ="Delete current image.";
 const char     TIP_MAIN_SHOW_IPPBAR[]           ="Show/hide image pickup bar.";
+const char     TIP_MAIN_FRAME_SCRUBBER[]        ="Frame of the sequence.";
 
 #endif // DEFINES_H
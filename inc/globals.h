@@ -21,6 +21,8 @@
 #define GLOBAL_H
 
 #include "CImgContext.h"
+#include "CImgRegistry.h"
+#include "CCommandQueue.h"
 #include <QMutex>
 #include <QSemaphore>
 
@@ -58,18 +60,6 @@
 }
 
 
-///////////////////////////////////////////////////////////////////////////////////////////////////
-/*!
- * \brief The cmdS struct.
- *        An internal message-queue element structure.
- */
-
-struct cmdS
-{
-    int      commandID;
-    quintptr auxParam;
-};
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /*!
  * \brief The statusBarMsg struct.
@@ -87,10 +77,8 @@ struct statusBarMsg
 class Globals
 {
 public:
-    /*! The mutex for the local command queue. */
-    static QMutex                                    commandQueueLock;
-    /*! The local queue implementation. */
-    static QVector<cmdS>                             commandQueue;
+    /*! The local command queue (see CCommandQueue). */
+    static CCommandQueue                             commandQueue;
 
     /*! Thread count trimmer */
     static QSemaphore                                processingThreadTrimmer;
@@ -103,12 +91,16 @@ public:
     static QMainWindow                              *mainWindowPtr;
     static QApplication                             *myApp;
 
-    /*! The mutex, the head pointer and aux counters for the loaded images list. */
-    static QMutex                                    imgContextListLock;
-    static QSharedPointer<CImgContext>               imgListHeadPtr;
-    static quint32                                   imgCount;
+    /*! The loaded images (see CImgRegistry) and aux counters. */
+    static CImgRegistry                              imgRegistry;
     static quint32                                   imgCountAbs;
+    /*! Optional cap on the images held in memory (spilled ones excluded), IMG_COUNT_UNLIMITED by default. */
     static quint32                                   imgCountLimit;
+    /*! Memory budget for all loaded images (see evictImages). */
+    static quint32                                   imgMemoryBudgetMB;
+    /*! Spilling cold images to disk instead of dropping them (see CSpillStore). */
+    static bool                                      spillEnabled;
+    static QString                                   spillDirectory;
 
     /*! The base for a color representation. */
     static qint32                                    option_colorBase;
@@ -118,6 +110,19 @@ public:
     /*! Idle socket timeout */
     static quint32                                   idleSocketTimeoutInSecs;
 
+    /*! Directory watch ingest (see CDirectoryWatcher). */
+    static QString                                   watchDirectory;
+    static QString                                   watchArchiveDirectory;
+    static int                                       watchPostAction;
+
+    /*! Batch export on exit (see CWorker_batchExport). */
+    static QString                                   exportDirectory;
+    static QString                                   exportFormat;
+    static QString                                   exportFilter;
+
+    /*! Session file restored on start-up and saved on exit (see CSession). */
+    static QString                                   sessionFile;
+
     /*! Active panel. */
     static panelID                                   activePanel;
 
@@ -128,6 +133,12 @@ public:
     static bool                                      imageRecEnabled;
     static bool                                      autoScaleOnLoad;
 
+    /*! Frames received under the name of a listed image replace it, only the newest pending one is decoded (see CStreamTable). */
+    static bool                                      streamMode;
+
+    /*! The number of decode helper processes (see CDecodeHelpers), 0 to decode in process. */
+    static int                                       decodeHelperCount;
+
     /*! Shared view options. */
     static bool                                      sharedViewFlagsEnabled;
     static bool                                      sharedPositionEnabled;
@@ -143,11 +154,13 @@ public:
     /*! Font size multiplier */
     static int                                       fontSizeMul;
 
-    /*! Tool thread slot */
-    static QMutex                                    toolThreadSlot;
+    /*! The number of tools running at once (see CToolQueue), 0 for one per pool thread. */
+    static quint32                                   toolConcurrencyLimit;
 
-    /*! Aux image context hooks. */
-    static QMap<int, QSharedPointer<CImgContext> >   sharedPointerHooks;
+    /*! The images in focus (shown in a panel or hovered in the pick-up list), decoded first. */
+    static QMutex                                    focusLock;
+    static const void*                               focusContext[FOCUS_SLOT_COUNT];
+    static QString                                   focusName[FOCUS_SLOT_COUNT];
 
     /*! Adds a new image to the loaded images list. */
     static void addImage(const QSharedPointer<CImgContext> &newImage);
@@ -155,11 +168,16 @@ public:
     /*! Removes the image from the loaded images list. */
     static void removeImage(QSharedPointer<CImgContext> &anImage);
 
-    /*! Removes the last image in the queue. */
-    static void removeLastImage();
+    /*!
+     * Evicts the least recently viewed images until the list fits both the memory budget and
+     * the image count limit. Over the budget, images are spilled to disk first (when enabled)
+     * and dropped only when nothing is left to spill; over the count limit they are dropped.
+     * Pinned images, images being loaded, images shown in a panel and <keep> are never evicted.
+     */
+    static void evictImages(const QSharedPointer<CImgContext> &keep = QSharedPointer<CImgContext>());
 
     /*! Removes all images from the loaded images list. */
-    static void removeAll(QSharedPointer<CImgContext> &whereToStart);
+    static void removeAll();
 
     /*! Validates if <fileName> is a legal system filename. */
     static bool isValidName(QString fileName);
@@ -167,6 +185,16 @@ public:
     /*! Finds a CImgContext object by its widget item. */
     static QSharedPointer<CImgContext> findImgContextByWidget(QListWidgetItem* itemEdited);
 
+    /*!
+     * Sets the image in focus for <slot> (a panelID or FOCUS_SLOT_HOVER); a null pointer clears it.
+     * The name is captured now, so frames still in flight under that name are in focus too.
+     */
+    static void setFocusImage(int slot, const QSharedPointer<CImgContext> &imgPtr);
+
+    /*! Returns true when the image (or any image named <name>) is in focus. */
+    static bool isInFocus(const CImgContext *imgPtr);
+    static bool isInFocus(const QString &name);
+
     /*! Adds a new entry to the local command queue. */
     static void addCmdToLocalQueue(int cmdID, int auxParam=0);
     static void addCmdToLocalQueue(int cmdID, const QSharedPointer<CImgContext> &auxParam);
@@ -23,6 +23,10 @@
 #include "CImgContext.h"
 #include "Threads.h"
 #include "globals.h"
+#include "CBufferPool.h"
+#include "CMemoryReport.h"
+#include "CToolQueue.h"
+#include "CDecodePipeline.h"
 
 
 #include <QDoubleValidator>
@@ -34,6 +38,7 @@
 #include <QTextBrowser>
 #include <QCheckBox>
 #include <QMutex>
+#include <QTimer>
 
 #ifdef QT4_HEADERS
     #include <QWidgetAction>
@@ -50,6 +55,9 @@
     #include <QLabel>
     #include <QMessageBox>
     #include <QComboBox>
+    #include <QTableWidget>
+    #include <QHeaderView>
+    #include <QFileDialog>
 #elif QT5_HEADERS
     #include <QtWidgets/QWidgetAction>
     #include <QtWidgets/QButtonGroup>
@@ -65,6 +73,9 @@
     #include <QtWidgets/QLabel>
     #include <QtWidgets/QMessageBox>
     #include <QtWidgets/QComboBox>
+    #include <QtWidgets/QTableWidget>
+    #include <QtWidgets/QHeaderView>
+    #include <QtWidgets/QFileDialog>
 #endif
 
 
@@ -560,6 +571,8 @@ public:
 
         actRename = addAction(QIcon(":/icos/label.png"),"Rename");
         actSaveAs = addAction(QIcon(":/icos/save.png"),"Save as");
+        actPin = addAction("Pin (never evict)");
+        actPin->setCheckable(true);
         addSeparator();
         actDelete = addAction(QIcon(":/icos/trash.png"),"Delete");
 
@@ -568,6 +581,7 @@ public:
         connect(this, SIGNAL(popupRename()), parent, SLOT(popupRename()));
         connect(this, SIGNAL(popupSaveAs()), parent, SLOT(popupSaveAs()));
         connect(this, SIGNAL(popupDelete()), parent, SLOT(popupDelete()));
+        connect(this, SIGNAL(popupPin()), parent, SLOT(popupPin()));
     }
 
     void hideMe()
@@ -575,11 +589,17 @@ public:
         hide();
     }
 
+    void setPinChecked(bool value)
+    {
+        actPin->setChecked(value);
+    }
+
 
 signals:
     void popupRename();
     void popupSaveAs();
     void popupDelete();
+    void popupPin();
 
 private slots:
     void dispatch(QAction* actPtr)
@@ -587,12 +607,14 @@ private slots:
         if(actPtr == actRename) {emit popupRename();   return;}
         if(actPtr == actSaveAs) {emit popupSaveAs();   return;}
         if(actPtr == actDelete) {emit popupDelete();   return;}
+        if(actPtr == actPin)    {emit popupPin();      return;}
     }
 
 private:
     QAction* actRename;
     QAction* actSaveAs;
     QAction* actDelete;
+    QAction* actPin;
 
 };
 
@@ -646,6 +668,394 @@ private:
     QVBoxLayout myLayout;
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The qwMemoryDialog class.
+ *        Memory usage panel: totals by category and a sortable per-image table
+ *        (see CMemoryReport), refreshed while shown.
+ *
+ */
+
+class qwMemoryDialog : public QWidget
+{
+    Q_OBJECT
+public:
+
+    static qwMemoryDialog* myHandler;
+
+    qwMemoryDialog() : QWidget(0, Qt::Dialog)
+    {
+        QStringList headerLabels;
+
+        setMinimumWidth(720);
+        setMinimumHeight(420);
+        setWindowFlags(windowFlags()&~Qt::WindowContextHelpButtonHint);
+
+        setAttribute( Qt::WA_DeleteOnClose, true );
+
+        setWindowIcon(QIcon(":/icos/aid.png"));
+        setWindowTitle("Memory usage");
+
+        headerLabels << "Image" << "State" << "Native (KB)" << "Visual (KB)" << "Render (KB)" << "Sequence (KB)" << "Thumbnail (KB)" << "Total (KB)";
+        imagesTable.setColumnCount(headerLabels.size());
+        imagesTable.setHorizontalHeaderLabels(headerLabels);
+        imagesTable.setEditTriggers(QAbstractItemView::NoEditTriggers);
+        imagesTable.setSelectionBehavior(QAbstractItemView::SelectRows);
+        imagesTable.verticalHeader()->hide();
+        imagesTable.horizontalHeader()->setStretchLastSection(true);
+        imagesTable.setSortingEnabled(true);
+        imagesTable.sortByColumn(headerLabels.size() - 1, Qt::DescendingOrder);
+
+        dumpBtn.setText("Dump as JSON...");
+        dumpBtn.setFlat(true);
+        closeBtn.setText("Close");
+        closeBtn.setFlat(true);
+        connect(&dumpBtn, SIGNAL(clicked()), this, SLOT(dumpJson()));
+        connect(&closeBtn, SIGNAL(clicked()), this, SLOT(close()));
+        connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+        btnLayout.addWidget(&dumpBtn);
+        btnLayout.addWidget(&closeBtn);
+        myLayout.addWidget(&summaryLabel);
+        myLayout.addWidget(&imagesTable);
+        myLayout.addLayout(&btnLayout);
+        setLayout(&myLayout);
+
+        refresh();
+        refreshTimer.start(UI_MEMORY_PANEL_REFRESH_MS);
+    }
+
+public slots:
+    void refresh()
+    {
+        QString summary;
+
+        report.collect();
+
+        summary  = "<table cellspacing=\"4\">";
+        summary += "<tr><td>Native data:</td><td align=\"right\">" + formatSize(report.totals.nativeBytes) + "</td>";
+        summary += "<td>Buffer pool (live / cached):</td><td align=\"right\">" + formatSize(report.poolLiveBytes) + " / " + formatSize(report.poolCachedBytes) + "</td></tr>";
+        summary += "<tr><td>Visual data:</td><td align=\"right\">" + formatSize(report.totals.visualBytes) + "</td>";
+        summary += "<td>Spill file:</td><td align=\"right\">" + formatSize(report.spillBytes) + "</td></tr>";
+        summary += "<tr><td>Render data:</td><td align=\"right\">" + formatSize(report.totals.renderBytes) + "</td>";
+        summary += "<td>Tool outputs:</td><td align=\"right\">" + formatSize(report.toolOutputBytes) + "</td></tr>";
+        summary += "<tr><td>Sequence frames:</td><td align=\"right\">" + formatSize(report.totals.sequenceBytes) + "</td>";
+        summary += "<td>Images:</td><td align=\"right\">" + QString::number(report.images.size()) + "</td></tr>";
+        summary += "<tr><td>Thumbnails:</td><td align=\"right\">" + formatSize(report.totals.thumbnailBytes) + "</td></tr>";
+        summary += "<tr><td><b>Total:</b></td><td align=\"right\"><b>" + formatSize(CMemoryReport::getTotal(report.totals)) + "</b></td>";
+        summary += "<td><b>Budget:</b></td><td align=\"right\"><b>" + formatSize(report.budgetBytes) + "</b></td></tr>";
+        summary += "</table>";
+        summaryLabel.setText(summary);
+
+        imagesTable.setSortingEnabled(false);
+        imagesTable.setRowCount(report.images.size());
+        for(int i = 0; i < report.images.size(); i++)
+        {
+            const dImageMemoryEntry &next = report.images.at(i);
+            QString name = next.name;
+
+            if(next.pinned)
+                name += " [pinned]";
+            if(next.toolOutput)
+                name += " [tool]";
+
+            setCell(i, 0, name);
+            setCell(i, 1, stateText(next.state));
+            setCell(i, 2, next.usage.nativeBytes);
+            setCell(i, 3, next.usage.visualBytes);
+            setCell(i, 4, next.usage.renderBytes);
+            setCell(i, 5, next.usage.sequenceBytes);
+            setCell(i, 6, next.usage.thumbnailBytes);
+            setCell(i, 7, CMemoryReport::getTotal(next.usage));
+        }
+        imagesTable.setSortingEnabled(true);
+    }
+
+    void dumpJson()
+    {
+        QString fileName = QFileDialog::getSaveFileName(this, "Dump memory usage", "", "JSON (*.json)");
+
+        if(fileName.isEmpty())
+            return;
+
+        report.collect();
+        if(report.dumpJson(fileName) == RES_OK)
+            showStatusMessage("Memory usage has been written to " + fileName, UI_STATUS_INFO, true);
+        else
+            showStatusMessage("Error writing the memory usage file.", UI_STATUS_ERROR, true);
+    }
+
+protected:
+    void showEvent(QShowEvent *){if(myHandler) myHandler->close(); myHandler = this;}
+    void closeEvent(QCloseEvent *){refreshTimer.stop(); if(myHandler==this) myHandler=0;}
+
+private:
+    static QString formatSize(quint64 bytes)
+    {
+        if(bytes >= ((quint64)1 << 30))
+            return QString::number(bytes/1073741824.0, 'f', 2) + " GB";
+        if(bytes >= ((quint64)1 << 20))
+            return QString::number(bytes/1048576.0, 'f', 1) + " MB";
+        return QString::number(bytes/1024.0, 'f', 1) + " KB";
+    }
+
+    static QString stateText(uint state)
+    {
+        switch(state)
+        {
+            case STATE_READY:   return "Ready";
+            case STATE_BUSY:    return "Busy";
+            case STATE_BAD:     return "Bad";
+            case STATE_SPILLED: return "Spilled";
+        }
+        return "-";
+    }
+
+    void setCell(int row, int column, const QString &text)
+    {
+        QTableWidgetItem* item = imagesTable.item(row, column);
+
+        if(item == NULL)
+        {
+            item = new QTableWidgetItem();
+            imagesTable.setItem(row, column, item);
+        }
+        item->setData(Qt::DisplayRole, text);
+    }
+
+    void setCell(int row, int column, quint64 bytes)
+    {
+        QTableWidgetItem* item = imagesTable.item(row, column);
+
+        if(item == NULL)
+        {
+            item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            imagesTable.setItem(row, column, item);
+        }
+        //Numeric data keeps the sorting numeric.
+        item->setData(Qt::DisplayRole, (qulonglong)((bytes + 1023)/1024));
+    }
+
+    CMemoryReport report;
+    QLabel        summaryLabel;
+    QTableWidget  imagesTable;
+    QPushButton   dumpBtn;
+    QPushButton   closeBtn;
+    QHBoxLayout   btnLayout;
+    QVBoxLayout   myLayout;
+    QTimer        refreshTimer;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The qwToolJobsDialog class.
+ *        Tool jobs panel: the running and the queued tools (see CToolQueue), refreshed while shown.
+ *
+ */
+
+class qwToolJobsDialog : public QWidget
+{
+    Q_OBJECT
+public:
+
+    static qwToolJobsDialog* myHandler;
+
+    qwToolJobsDialog() : QWidget(0, Qt::Dialog)
+    {
+        QStringList headerLabels;
+
+        setMinimumWidth(560);
+        setMinimumHeight(260);
+        setWindowFlags(windowFlags()&~Qt::WindowContextHelpButtonHint);
+
+        setAttribute( Qt::WA_DeleteOnClose, true );
+
+        setWindowIcon(QIcon(":/icos/aid.png"));
+        setWindowTitle("Tool jobs");
+
+        headerLabels << "Tool" << "State" << "Queued at" << "Running for";
+        jobsTable.setColumnCount(headerLabels.size());
+        jobsTable.setHorizontalHeaderLabels(headerLabels);
+        jobsTable.setEditTriggers(QAbstractItemView::NoEditTriggers);
+        jobsTable.setSelectionBehavior(QAbstractItemView::SelectRows);
+        jobsTable.verticalHeader()->hide();
+        jobsTable.horizontalHeader()->setStretchLastSection(true);
+
+        closeBtn.setText("Close");
+        closeBtn.setFlat(true);
+        connect(&closeBtn, SIGNAL(clicked()), this, SLOT(close()));
+        connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+        myLayout.addWidget(&summaryLabel);
+        myLayout.addWidget(&jobsTable);
+        myLayout.addWidget(&closeBtn);
+        setLayout(&myLayout);
+
+        refresh();
+        refreshTimer.start(UI_TOOL_JOBS_REFRESH_MS);
+    }
+
+public slots:
+    void refresh()
+    {
+        QList<dToolJob> jobs = CToolQueue::snapshot();
+        QDateTime       now = QDateTime::currentDateTime();
+        int             running = 0;
+
+        jobsTable.setRowCount(jobs.size());
+        for(int i = 0; i < jobs.size(); i++)
+        {
+            const dToolJob &next = jobs.at(i);
+
+            setCell(i, 0, next.description);
+            setCell(i, 1, next.running?"Running":"Queued");
+            setCell(i, 2, next.queuedAt.toString("hh:mm:ss"));
+            setCell(i, 3, next.running?(QString::number(next.startedAt.secsTo(now)) + " s"):QString("-"));
+            if(next.running)
+                running++;
+        }
+
+        summaryLabel.setText("Running: " + QString::number(running) +
+                             "   Queued: " + QString::number(jobs.size() - running) +
+                             "   Limit: " + QString::number(CToolQueue::getLimit()));
+    }
+
+protected:
+    void showEvent(QShowEvent *){if(myHandler) myHandler->close(); myHandler = this;}
+    void closeEvent(QCloseEvent *){refreshTimer.stop(); if(myHandler==this) myHandler=0;}
+
+private:
+    void setCell(int row, int column, const QString &text)
+    {
+        QTableWidgetItem* item = jobsTable.item(row, column);
+
+        if(item == NULL)
+        {
+            item = new QTableWidgetItem();
+            jobsTable.setItem(row, column, item);
+        }
+        item->setData(Qt::DisplayRole, text);
+    }
+
+    QLabel        summaryLabel;
+    QTableWidget  jobsTable;
+    QPushButton   closeBtn;
+    QVBoxLayout   myLayout;
+    QTimer        refreshTimer;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The qwPipelineDialog class.
+ *        Decode pipeline panel: queue depths and timings of the stages (see CDecodePipeline),
+ *        refreshed while shown.
+ *
+ */
+
+class qwPipelineDialog : public QWidget
+{
+    Q_OBJECT
+public:
+
+    static qwPipelineDialog* myHandler;
+
+    qwPipelineDialog() : QWidget(0, Qt::Dialog)
+    {
+        QStringList headerLabels;
+
+        setMinimumWidth(640);
+        setMinimumHeight(220);
+        setWindowFlags(windowFlags()&~Qt::WindowContextHelpButtonHint);
+
+        setAttribute( Qt::WA_DeleteOnClose, true );
+
+        setWindowIcon(QIcon(":/icos/aid.png"));
+        setWindowTitle("Decode pipeline");
+
+        headerLabels << "Stage" << "Queued" << "Peak" << "Bound" << "Running" << "Done" << "Avg wait (ms)" << "Avg run (ms)" << "Stalls";
+        stagesTable.setColumnCount(headerLabels.size());
+        stagesTable.setHorizontalHeaderLabels(headerLabels);
+        stagesTable.setEditTriggers(QAbstractItemView::NoEditTriggers);
+        stagesTable.setSelectionBehavior(QAbstractItemView::SelectRows);
+        stagesTable.verticalHeader()->hide();
+        stagesTable.horizontalHeader()->setStretchLastSection(true);
+
+        closeBtn.setText("Close");
+        closeBtn.setFlat(true);
+        connect(&closeBtn, SIGNAL(clicked()), this, SLOT(close()));
+        connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+        myLayout.addWidget(&summaryLabel);
+        myLayout.addWidget(&stagesTable);
+        myLayout.addWidget(&closeBtn);
+        setLayout(&myLayout);
+
+        refresh();
+        refreshTimer.start(UI_PIPELINE_REFRESH_MS);
+    }
+
+public slots:
+    void refresh()
+    {
+        QList<dPipelineStage> stages = CDecodePipeline::snapshot();
+        QString               bottleneck;
+        int                   fullest = 0;
+
+        stagesTable.setRowCount(stages.size());
+        for(int i = 0; i < stages.size(); i++)
+        {
+            const dPipelineStage &next = stages.at(i);
+
+            setCell(i, 0, next.name);
+            setCell(i, 1, (next.bound > 0)?QString::number(next.queued):QString("-"));
+            setCell(i, 2, (next.bound > 0)?QString::number(next.peakQueued):QString("-"));
+            setCell(i, 3, (next.bound > 0)?QString::number(next.bound):QString("-"));
+            setCell(i, 4, QString::number(next.running));
+            setCell(i, 5, QString::number(next.done));
+            setCell(i, 6, next.done?QString::number(next.waitUs/1000.0/next.done, 'f', 2):QString("-"));
+            setCell(i, 7, (next.done && next.busyUs)?QString::number(next.busyUs/1000.0/next.done, 'f', 2):QString("-"));
+            setCell(i, 8, QString::number(next.stalls));
+
+            //The stage whose queue is the fullest (relative to its bound) holds the others back.
+            if((next.bound > 0)&&(next.queued*100/next.bound > fullest))
+            {
+                fullest = next.queued*100/next.bound;
+                bottleneck = next.name;
+            }
+        }
+
+        if(bottleneck.isEmpty())
+            summaryLabel.setText("Pool threads: " + QString::number(CWorkPool::getThreadCount()) + "   No backlog.");
+        else
+            summaryLabel.setText("Pool threads: " + QString::number(CWorkPool::getThreadCount()) +
+                                 "   Bottleneck: " + bottleneck + " (" + QString::number(fullest) + "% of its queue).");
+    }
+
+protected:
+    void showEvent(QShowEvent *){if(myHandler) myHandler->close(); myHandler = this;}
+    void closeEvent(QCloseEvent *){refreshTimer.stop(); if(myHandler==this) myHandler=0;}
+
+private:
+    void setCell(int row, int column, const QString &text)
+    {
+        QTableWidgetItem* item = stagesTable.item(row, column);
+
+        if(item == NULL)
+        {
+            item = new QTableWidgetItem();
+            stagesTable.setItem(row, column, item);
+        }
+        item->setData(Qt::DisplayRole, text);
+    }
+
+    QLabel        summaryLabel;
+    QTableWidget  stagesTable;
+    QPushButton   closeBtn;
+    QVBoxLayout   myLayout;
+    QTimer        refreshTimer;
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /*!
  * \brief The qwReinterpretDialog class.
@@ -1066,7 +1476,7 @@ public slots:
                                                                     name,
                                                                     imgCtx);
 
-       newWorker->selfStart();
+       CToolQueue::submit(newWorker, "Recast " + imgCtx->getMyName());
 
        close();
     }
@@ -1424,7 +1834,7 @@ public slots:
                                                                     swapImagesChkBox.isChecked()?imgA:imgB,
                                                                     swapImagesChkBox.isChecked()?imgB:imgA);
 
-        newWorker->selfStart();
+        CToolQueue::submit(newWorker, "Compare " + imgA->getMyName() + " / " + imgB->getMyName());
         close();
     }
 
@@ -1537,6 +1947,27 @@ public:
         dataSizeEdit.setDisabled(true);
         dataSizeEdit.setText(QString::number(rawFileInfo.size())+ "KB");
 
+        gLayout.addWidget(new QLabel("Frame sequence:"), 9, 0, Qt::AlignRight);
+        gLayout.addWidget(&sequenceChckBox, 9, 1);
+        sequenceChckBox.setChecked(sequenceMode);
+
+        gLayout.addWidget(new QLabel("Frame size in bytes (0=auto):"), 10, 0, Qt::AlignRight);
+        gLayout.addWidget(&frameSizeEdit, 10, 1);
+        frameSizeEdit.setText(QString::number(sequenceParams[0]));
+
+        gLayout.addWidget(new QLabel("Frame stride in bytes (0=size):"), 11, 0, Qt::AlignRight);
+        gLayout.addWidget(&frameStrideEdit, 11, 1);
+        frameStrideEdit.setText(QString::number(sequenceParams[1]));
+
+        gLayout.addWidget(new QLabel("Frame count (0=all):"), 12, 0, Qt::AlignRight);
+        gLayout.addWidget(&frameCountEdit, 12, 1);
+        frameCountEdit.setText(QString::number(sequenceParams[2]));
+
+        frameSizeEdit.setValidator(new QIntValidator(0, MAX_IMAGE_BLOCK_SIZE, this));
+        frameStrideEdit.setValidator(new QIntValidator(0, MAX_IMAGE_BLOCK_SIZE, this));
+        frameCountEdit.setValidator(new QIntValidator(0, SEQ_MAX_FRAME_COUNT, this));
+        sequenceModeChanged(sequenceMode);
+
         gainEdit[0].setText(QString::number(rawHeader.normGain[0]));
         gainEdit[1].setText(QString::number(rawHeader.normGain[1]));
         gainEdit[2].setText(QString::number(rawHeader.normGain[2]));
@@ -1580,12 +2011,20 @@ public:
 
         connect(&goBtn, SIGNAL(clicked()), this, SLOT(goPressed()));
         connect(&cancelBtn, SIGNAL(clicked()), this, SLOT(close()));
+        connect(&sequenceChckBox, SIGNAL(toggled(bool)), this, SLOT(sequenceModeChanged(bool)));
 
         pixelFormatEdit.setFocus();
     }
 
 
 public slots:
+    void sequenceModeChanged(bool enabled)
+    {
+        frameSizeEdit.setEnabled(enabled);
+        frameStrideEdit.setEnabled(enabled);
+        frameCountEdit.setEnabled(enabled);
+    }
+
     void goPressed()
     {
        QByteArray hrawBuff;
@@ -1651,10 +2090,25 @@ public slots:
 
        hrawBuff.append(qbuff);
 
-       char* rawBitsPtr = (char*)malloc(hrawBuff.size());
+       char* rawBitsPtr = CBufferPool::acquire(hrawBuff.size());
+       if(!rawBitsPtr)
+       {
+           showStatusMessage("No data has been loaded - out of memory.", UI_STATUS_ERROR, true);
+           rawFile.close();
+           close();
+           return;
+       }
        memcpy(rawBitsPtr, hrawBuff.data(), hrawBuff.size());
 
        CWorker_loadFromNativeData* newWorker = new CWorker_loadFromNativeData(NULL, rawBitsPtr, hrawBuff.size());
+
+       sequenceMode = sequenceChckBox.isChecked();
+       sequenceParams[0] = frameSizeEdit.text().toUInt();
+       sequenceParams[1] = frameStrideEdit.text().toUInt();
+       sequenceParams[2] = frameCountEdit.text().toUInt();
+       if(sequenceMode)
+           newWorker->setFrameSequence(sequenceParams[0], sequenceParams[1], sequenceParams[2]);
+
        newWorker->selfStart();
        rawFile.close();
        close();
@@ -1675,6 +2129,10 @@ private:
     QLineEdit       gainEdit[4];
     QLineEdit       biasEdit[4];
     QCheckBox       autoGainAndBiasChckBox;
+    QCheckBox       sequenceChckBox;
+    QLineEdit       frameSizeEdit;
+    QLineEdit       frameStrideEdit;
+    QLineEdit       frameCountEdit;
 
     QVBoxLayout     myLayout;
     QHBoxLayout     btnBox;
@@ -1684,6 +2142,8 @@ private:
 
     static  dHeader rawHeader;
     static  QString pixelFormatString;
+    static  bool    sequenceMode;
+    static  quint32 sequenceParams[3];
 };
 
 
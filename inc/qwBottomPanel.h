@@ -30,12 +30,14 @@
     #include <QHBoxLayout>
     #include <QGridLayout>
     #include <QWidget>
+    #include <QSlider>
 #elif QT5_HEADERS
     #include <QtWidgets/QPushButton>
     #include <QtWidgets/QVBoxLayout>
     #include <QtWidgets/QHBoxLayout>
     #include <QtWidgets/QGridLayout>
     #include <QtWidgets/QWidget>
+    #include <QtWidgets/QSlider>
 #endif
 
 #include "qwAuxDialogs.h"
@@ -78,6 +80,11 @@ public:
 
     QLabel                    infoBarString;
 
+    /* Frame scrubber - visible for frame sequences only. */
+    QPointer<QSlider>         frameSliderPtr;
+    QLabel                    frameInfoString;
+    QWidget                   frameScrubber;
+
     QFrame                    activePanelIndicator;
 
 private:
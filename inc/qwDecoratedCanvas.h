@@ -62,8 +62,10 @@ public:
 
     void                        setCurrentImage(const QSharedPointer<CImgContext> &imc);
     QSharedPointer<CImgContext> getCurrentImage(){return currentImgPtr;}
-    void                        refreshThumbnailsList(QSharedPointer<CImgContext> header);
+    void                        refreshThumbnailsList(const QList<QSharedPointer<CImgContext> > &images);
     void                        refreshViewPanel(){myGridCanvasPtr->refreshView();}
+    /*! Shows the requested frame of the current sequence once it has been decoded. */
+    void                        showPendingFrame();
 
     /*! Restores button states from the current image context. */
     void                        restoreSWButtonsState();
@@ -95,6 +97,7 @@ public slots:
     void                        saveImageAs();
     void                        childLostFocus();
     void                        childSetFocus(){focusInEvent(0);}
+    void                        showFrame(int index);
 
 
 protected:
@@ -108,6 +111,7 @@ private:
     void                        disableButtons();
     void                        enableButtons();
     void                        setSharedViewFlag(quint32 bitToSet, bool value);
+    void                        restoreFrameScrubber();
 
     panelID                     myID;
 
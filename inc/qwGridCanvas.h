@@ -104,7 +104,11 @@ private:
             QSharedPointer<CImgContext>   m_ImgContextPtr;
             QPixmap                 m_BkgTile;
 
-            QImage                  m_rollerW, m_rollerH;
+            QRect                   m_shownRect;
+            qint32                  m_shownOriginX;
+            qint32                  m_shownOriginY;
+            qint32                  m_shownW;
+            qint32                  m_shownH;
 
             qint32                  m_lastSourceX;
             qint32                  m_lastSourceY;
@@ -116,8 +120,6 @@ private:
 
             qint32                  clientW, clientH, sourceW, sourceH;
 
-    static  QImage                  s_rollerW;
-    static  QImage                  s_rollerH;
     static  quint32                 s_references;
     static  QPen                    s_gridPen;
     static  QPen                    s_gridPenT;
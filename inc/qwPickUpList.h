@@ -52,9 +52,12 @@ public slots:
     void      popupRename();
     void      popupSaveAs();
     void      popupDelete();
+    void      popupPin();
+    void      itemHovered(QListWidgetItem*);
 
 protected:
     void      focusInEvent(QFocusEvent*);
+    void      leaveEvent(QEvent*);
 
 private:
     QPointer<qwPopUpMenuThumbnailList> myPopUpMenuPtr;
@@ -0,0 +1,236 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CBufferPool.h"
+#include "./inc/defines.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef Q_OS_WIN
+    #include <malloc.h>
+#endif
+
+#ifdef Q_OS_LINUX
+    #include <sys/mman.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * Block header, kept in the first POOL_BLOCK_ALIGNMENT bytes of every allocation.
+ */
+
+typedef struct
+{
+    quint32 magic;
+    qint32  sizeClass;
+    quint64 classBytes;
+}dBlockHeader;
+
+const quint32 POOL_BLOCK_MAGIC = 0xA1DB10C5;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex                          CBufferPool::poolLock(QMutex::NonRecursive);
+QHash<int, QVector<char*> >     CBufferPool::freeLists;
+quint64                         CBufferPool::liveBytes = 0;
+quint64                         CBufferPool::cachedBytes = 0;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static inline dBlockHeader* blockHeader(const char *blockPtr)
+{
+    return (dBlockHeader*)(blockPtr - POOL_BLOCK_ALIGNMENT);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CBufferPool::sizeClass(quint64 sizeInBytes, quint64 *classBytes)
+{
+    quint64 bytes = POOL_MIN_BLOCK_SIZE;
+    quint64 octave = POOL_MIN_BLOCK_SIZE;
+    int     ret = 0;
+
+    //Four steps per power of two: at most 25% of a block is wasted.
+    while(bytes < sizeInBytes)
+    {
+        if(bytes >= 2*octave)
+            octave *= 2;
+        bytes += octave/4;
+        ret++;
+    }
+
+    *classBytes = bytes;
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+char* CBufferPool::allocateBlock(int sizeClass, quint64 classBytes)
+{
+    quint64 totalBytes = classBytes + POOL_BLOCK_ALIGNMENT;
+    quint64 alignment = (totalBytes >= POOL_HUGEPAGE_SIZE)?POOL_HUGEPAGE_SIZE:POOL_BLOCK_ALIGNMENT;
+    char*   rawPtr = NULL;
+
+    if(totalBytes != (quint64)(size_t)totalBytes)
+        return NULL;
+
+#ifdef Q_OS_WIN
+    rawPtr = (char*)_aligned_malloc((size_t)totalBytes, (size_t)alignment);
+#else
+    if(posix_memalign((void**)&rawPtr, (size_t)alignment, (size_t)totalBytes) != 0)
+        rawPtr = NULL;
+#endif
+    if(!rawPtr)
+        return NULL;
+
+#if defined(Q_OS_LINUX) && defined(MADV_HUGEPAGE)
+    if(alignment == POOL_HUGEPAGE_SIZE)
+        madvise(rawPtr, (size_t)(totalBytes/POOL_HUGEPAGE_SIZE*POOL_HUGEPAGE_SIZE), MADV_HUGEPAGE);
+#endif
+
+    ((dBlockHeader*)rawPtr)->magic = POOL_BLOCK_MAGIC;
+    ((dBlockHeader*)rawPtr)->sizeClass = sizeClass;
+    ((dBlockHeader*)rawPtr)->classBytes = classBytes;
+    return rawPtr + POOL_BLOCK_ALIGNMENT;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CBufferPool::freeBlock(char *blockPtr)
+{
+#ifdef Q_OS_WIN
+    _aligned_free(blockPtr - POOL_BLOCK_ALIGNMENT);
+#else
+    free(blockPtr - POOL_BLOCK_ALIGNMENT);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+char* CBufferPool::acquire(quint64 sizeInBytes)
+{
+    quint64 classBytes;
+    int     sClass = sizeClass(sizeInBytes, &classBytes);
+    char*   blockPtr = NULL;
+
+    {
+        QMutexLocker lock(&poolLock);
+        QHash<int, QVector<char*> >::iterator list = freeLists.find(sClass);
+
+        if((list != freeLists.end())&&(!list.value().isEmpty()))
+        {
+            blockPtr = list.value().last();
+            list.value().pop_back();
+            cachedBytes -= classBytes;
+        }
+        liveBytes += classBytes;
+    }
+
+    if(blockPtr)
+        return blockPtr;
+
+    blockPtr = allocateBlock(sClass, classBytes);
+    if(!blockPtr)
+    {
+        QMutexLocker lock(&poolLock);
+        liveBytes -= classBytes;
+    }
+    return blockPtr;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+char* CBufferPool::grow(char *blockPtr, quint64 usedBytes, quint64 sizeInBytes)
+{
+    char* newBlockPtr;
+
+    if(blockPtr == NULL)
+        return acquire(sizeInBytes);
+
+    if(getCapacity(blockPtr) >= sizeInBytes)
+        return blockPtr;
+
+    newBlockPtr = acquire(sizeInBytes);
+    if(!newBlockPtr)
+        return NULL;
+
+    memcpy(newBlockPtr, blockPtr, (size_t)qMin(usedBytes, getCapacity(blockPtr)));
+    release(blockPtr);
+    return newBlockPtr;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CBufferPool::release(char *blockPtr)
+{
+    dBlockHeader *headerPtr;
+    bool          keep;
+
+    if(blockPtr == NULL)
+        return;
+
+    headerPtr = blockHeader(blockPtr);
+    Q_ASSERT(headerPtr->magic == POOL_BLOCK_MAGIC);
+
+    {
+        QMutexLocker lock(&poolLock);
+
+        liveBytes -= headerPtr->classBytes;
+        keep = (cachedBytes + headerPtr->classBytes <= ((quint64)POOL_MAX_CACHED_MB << 20));
+        if(keep)
+        {
+            freeLists[headerPtr->sizeClass].append(blockPtr);
+            cachedBytes += headerPtr->classBytes;
+        }
+    }
+
+    if(!keep)
+        freeBlock(blockPtr);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CBufferPool::getCapacity(const char *blockPtr)
+{
+    if(blockPtr == NULL)
+        return 0;
+    return blockHeader(blockPtr)->classBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CBufferPool::trim()
+{
+    QHash<int, QVector<char*> > lists;
+
+    {
+        QMutexLocker lock(&poolLock);
+        lists.swap(freeLists);
+        cachedBytes = 0;
+    }
+
+    for(QHash<int, QVector<char*> >::iterator list = lists.begin(); list != lists.end(); ++list)
+        for(int i = 0; i < list.value().size(); i++)
+            freeBlock(list.value().at(i));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CBufferPool::getLiveBytes()
+{
+    QMutexLocker lock(&poolLock);
+    return liveBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CBufferPool::getCachedBytes()
+{
+    QMutexLocker lock(&poolLock);
+    return cachedBytes;
+}
@@ -0,0 +1,111 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CCommandQueue.h"
+
+#include <QMetaObject>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CCommandQueue::CCommandQueue() : head(NULL), wakePending(0)
+{
+    receiver = NULL;
+    method = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CCommandQueue::~CCommandQueue()
+{
+    dCommandNode *node = head.fetchAndStoreOrdered(NULL);
+
+    while(node)
+    {
+        dCommandNode *next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CCommandQueue::setReceiver(QObject *receiver, const char *method)
+{
+    this->receiver = receiver;
+    this->method = method;
+
+    //Commands posted before the consumer was set.
+    wakePending.fetchAndStoreOrdered(0);
+    if(head.fetchAndAddOrdered(0) != NULL)
+        wake();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CCommandQueue::post(const cmdS &cmd)
+{
+    dCommandNode *node = new dCommandNode;
+    dCommandNode *top;
+
+    node->cmd = cmd;
+    do
+    {
+        top = head.fetchAndAddOrdered(0);
+        node->next = top;
+    }
+    while(!head.testAndSetOrdered(top, node));
+
+    wake();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QVector<cmdS> CCommandQueue::takeAll()
+{
+    QVector<cmdS>  ret;
+    dCommandNode  *node;
+    dCommandNode  *reversed = NULL;
+
+    //Cleared first: commands posted from now on wake the consumer again.
+    wakePending.fetchAndStoreOrdered(0);
+    node = head.fetchAndStoreOrdered(NULL);
+
+    //The stack is newest first.
+    while(node)
+    {
+        dCommandNode *next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+    }
+
+    while(reversed)
+    {
+        dCommandNode *next = reversed->next;
+        ret.append(reversed->cmd);
+        delete reversed;
+        reversed = next;
+    }
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CCommandQueue::wake()
+{
+    if(receiver == NULL)
+        return;
+
+    if(wakePending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(receiver, method, Qt::QueuedConnection);
+}
@@ -0,0 +1,697 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CDecodeHelpers.h"
+#include "./inc/CNormalizator.h"
+#include "./inc/CDecodePlan.h"
+#include "./inc/commons.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QFile>
+#include <QMutexLocker>
+#include <stdio.h>
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The control block of a helper, at the start of its control segment.
+ */
+
+typedef struct
+{
+    qint32      command;
+    qint32      status;
+    quint32     jobSequence;        //The job posted last.
+    quint32     doneSequence;       //The job <status> answers.
+    char        jobKey[64];
+}dHelperControl;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The job block at the start of a job segment; the payload and the decoded pixels
+ *        (32 bits per pixel, <width> per row) follow at the given offsets.
+ */
+
+typedef struct
+{
+    quint32     width;
+    quint32     height;
+    quint32     rowStrideInBits;
+    quint32     auxFiltering;
+    float       gain[4];
+    float       bias[4];
+    quint32     formatLength;
+    char        format[MAX_FORMAT_STRING_LENGTH];
+    quint64     payloadOffset;
+    quint64     payloadSize;
+    quint64     pixelsOffset;
+    //Results.
+    qint32      imageFormat;
+    float       resultGain[4];
+    float       resultBias[4];
+}dHelperJob;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CParentWatch class.
+ *        Ends a helper process when the viewer closes its standard input (or dies).
+ */
+
+class CParentWatch : public QThread
+{
+protected:
+    void run()
+    {
+        QFile input;
+        char  nextChar;
+
+        if(input.open(stdin, QIODevice::ReadOnly))
+            while(input.read(&nextChar, 1) > 0);
+        ::exit(0);
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex                               CDecodeHelpers::helpersLock(QMutex::NonRecursive);
+QWaitCondition                       CDecodeHelpers::slotFreed;
+QVector<CDecodeHelpers::dHelperSlot> CDecodeHelpers::helperSlots;
+bool                                 CDecodeHelpers::running = false;
+quint32                              CDecodeHelpers::lastJobId = 0;
+quint32                              CDecodeHelpers::lastJobSequence = 0;
+quint32                              CDecodeHelpers::lastGeneration = 0;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CDecodeHelpers::CDecodeHelpers() : QObject(0)
+{
+    connect(&watchdogTimer, SIGNAL(timeout()), this, SLOT(watchdog()));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CDecodeHelpers* CDecodeHelpers::instance()
+{
+    //Created in the GUI thread by start(); it receives the signals of the helper processes.
+    static CDecodeHelpers* myInstance = new CDecodeHelpers();
+    return myInstance;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QString CDecodeHelpers::slotKey(int index, quint32 generation)
+{
+    return "aid_" + QString::number(QCoreApplication::applicationPid()) + "_decoder_" + QString::number(index)
+           + "_" + QString::number(generation);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodeHelpers::start(int count)
+{
+    int started = 0;
+
+    stop();
+
+    count = qBound(0, count, DECODE_HELPER_MAX_COUNT);
+    if(count == 0)
+        return;
+
+    {
+        QMutexLocker lock(&helpersLock);
+
+        helperSlots.resize(count);
+        for(int i = 0; i < count; i++)
+        {
+            dHelperSlot &next = helperSlots[i];
+
+            //Made by startSlot.
+            next.control = NULL;
+            next.request = NULL;
+            next.response = NULL;
+            next.generation = 0;
+            next.process = NULL;
+            next.alive = false;
+            next.busy = false;
+            next.cancelled = false;
+            next.restarts = 0;
+        }
+        running = true;
+    }
+
+    for(int i = 0; i < count; i++)
+        if(startSlot(i))
+            started++;
+
+    if(started == 0)
+    {
+        stop();
+        return;
+    }
+    instance()->watchdogTimer.start(DECODE_HELPER_WATCHDOG_MS);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodeHelpers::renewSlot(int index)
+{
+    //Called under the helpers lock. A decode still holding the slot deletes the old objects (see decodeOnce).
+    dHelperSlot    &next = helperSlots[index];
+    dHelperControl *controlPtr;
+
+    if(!next.busy)
+    {
+        delete next.control;
+        delete next.request;
+        delete next.response;
+    }
+
+    next.generation = ++lastGeneration;
+    next.control = new QSharedMemory(slotKey(index, next.generation));
+    next.request = new QSystemSemaphore(slotKey(index, next.generation) + "_req", 0, QSystemSemaphore::Create);
+    next.response = new QSystemSemaphore(slotKey(index, next.generation) + "_rsp", 0, QSystemSemaphore::Create);
+    if(!next.control->create(sizeof(dHelperControl)))
+        next.control->attach();
+
+    next.control->lock();
+    controlPtr = (dHelperControl*)next.control->data();
+    if(controlPtr)
+        memset(controlPtr, 0, sizeof(dHelperControl));
+    next.control->unlock();
+
+    next.busy = false;
+    next.jobToken = CCancelToken();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CDecodeHelpers::startSlot(int index)
+{
+    QProcess *process;
+    QString   key;
+    quint32   generation;
+    bool      started;
+
+    {
+        QMutexLocker lock(&helpersLock);
+
+        if((index >= helperSlots.size())||(helperSlots.at(index).process != NULL))
+            return false;
+        renewSlot(index);
+        generation = helperSlots.at(index).generation;
+        key = slotKey(index, generation);
+    }
+
+    process = new QProcess();
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(process, SIGNAL(finished(int, QProcess::ExitStatus)),
+            instance(), SLOT(helperFinished(int, QProcess::ExitStatus)));
+    process->start(QCoreApplication::applicationFilePath(), QStringList() << CL_DECODE_HELPER_PROCESS << key);
+    started = process->waitForStarted(DECODE_HELPER_START_WAIT_MS);
+
+    QMutexLocker lock(&helpersLock);
+
+    if((index >= helperSlots.size())||(helperSlots.at(index).process != NULL)||(helperSlots.at(index).generation != generation))
+    {
+        lock.unlock();
+        process->kill();
+        process->deleteLater();
+        return false;
+    }
+
+    helperSlots[index].process = process;
+    helperSlots[index].alive = started;
+    if(started)
+        slotFreed.wakeAll();
+    return started;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodeHelpers::stop()
+{
+    QVector<dHelperSlot> stopped;
+
+    instance()->watchdogTimer.stop();
+
+    {
+        QMutexLocker lock(&helpersLock);
+
+        running = false;
+        for(int i = 0; i < helperSlots.size(); i++)
+        {
+            if(helperSlots.at(i).busy)
+                postResult(i, DECODE_HELPER_CRASHED);
+            else if(helperSlots.at(i).alive)
+            {
+                helperSlots[i].control->lock();
+                ((dHelperControl*)helperSlots[i].control->data())->command = DECODE_HELPER_CMD_QUIT;
+                helperSlots[i].control->unlock();
+                helperSlots[i].request->release();
+            }
+            helperSlots[i].alive = false;
+        }
+        stopped = helperSlots;
+        helperSlots.clear();
+        slotFreed.wakeAll();
+    }
+
+    for(int i = 0; i < stopped.size(); i++)
+    {
+        if(stopped.at(i).process)
+        {
+            stopped.at(i).process->disconnect();
+            stopped.at(i).process->closeWriteChannel();
+            if(!stopped.at(i).process->waitForFinished(DECODE_HELPER_QUIT_WAIT_MS))
+                stopped.at(i).process->kill();
+            delete stopped.at(i).process;
+        }
+    }
+
+    //The decodes still holding a slot are left with their semaphores, see decodeOnce.
+    for(int i = 0; i < stopped.size(); i++)
+    {
+        if(!stopped.at(i).busy)
+        {
+            delete stopped.at(i).control;
+            delete stopped.at(i).request;
+            delete stopped.at(i).response;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CDecodeHelpers::isEnabled()
+{
+    QMutexLocker lock(&helpersLock);
+    return running;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CDecodeHelpers::getHelperCount()
+{
+    QMutexLocker lock(&helpersLock);
+    return helperSlots.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodeHelpers::postResult(int index, int status)
+{
+    //Called under the helpers lock, for a busy slot: wakes its decode unless the helper did.
+    dHelperSlot    &next = helperSlots[index];
+    dHelperControl *controlPtr;
+
+    next.control->lock();
+    controlPtr = (dHelperControl*)next.control->data();
+    if(controlPtr->status == DECODE_HELPER_PENDING)
+    {
+        controlPtr->status = status;
+        controlPtr->doneSequence = controlPtr->jobSequence;
+        next.response->release();
+    }
+    next.control->unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodeHelpers::helperFinished(int, QProcess::ExitStatus)
+{
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    int       index = -1;
+    bool      restart = false;
+
+    {
+        QMutexLocker lock(&helpersLock);
+
+        for(int i = 0; i < helperSlots.size(); i++)
+        {
+            if(helperSlots.at(i).process == process)
+            {
+                index = i;
+                break;
+            }
+        }
+
+        if(index >= 0)
+        {
+            dHelperSlot &next = helperSlots[index];
+
+            if(next.busy)
+                postResult(index, DECODE_HELPER_CRASHED);
+            next.alive = false;
+            next.process = NULL;
+
+            //Killed on a cancelled job, not a crash.
+            restart = running && (next.cancelled || (next.restarts++ < DECODE_HELPER_MAX_RESTARTS));
+            next.cancelled = false;
+            slotFreed.wakeAll();
+        }
+    }
+
+    if(process)
+        process->deleteLater();
+
+    if(restart)
+        startSlot(index);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodeHelpers::watchdog()
+{
+    QList<QProcess*> hung;
+    QDateTime        now = QDateTime::currentDateTime();
+
+    {
+        QMutexLocker lock(&helpersLock);
+
+        for(int i = 0; i < helperSlots.size(); i++)
+        {
+            dHelperSlot &next = helperSlots[i];
+
+            if(!next.busy || !next.alive || !next.process)
+                continue;
+
+            //The job is abandoned: its decode returns now, the helper still working on it
+            //is taken out of the pool until it has been restarted.
+            if(next.jobToken.isCancelled())
+            {
+                postResult(i, DECODE_HELPER_CANCELLED);
+                next.alive = false;
+                next.cancelled = true;
+                hung.append(next.process);
+            }
+            else if(next.jobStartedAt.msecsTo(now) > DECODE_HELPER_TIMEOUT_MS)
+                hung.append(next.process);
+        }
+    }
+
+    //A hung decoder is treated as a crashed one (see helperFinished).
+    for(int i = 0; i < hung.size(); i++)
+        hung.at(i)->kill();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CDecodeHelpers::decode(const QString &formatStr,
+                           quint32 width,
+                           quint32 height,
+                           quint32 rowStrideInBits,
+                           const float gain[4],
+                           const float bias[4],
+                           quint32 auxFilteringFlags,
+                           const char *payloadPtr,
+                           quint64 payloadSize,
+                           CTiledImage *visualData,
+                           float gainOut[4],
+                           float biasOut[4],
+                           const CCancelToken &cancelToken)
+{
+    QSharedMemory   job;
+    dHelperJob     *jobPtr;
+    QByteArray      formatBytes = formatStr.toLatin1();
+    quint64         pixelsOffset, jobSize;
+    int             res = DECODE_HELPER_UNAVAILABLE;
+
+    {
+        QMutexLocker lock(&helpersLock);
+        if(!running)
+            return DECODE_HELPER_UNAVAILABLE;
+        if(cancelToken.isCancelled())
+            return DECODE_HELPER_CANCELLED;
+        job.setKey("aid_" + QString::number(QCoreApplication::applicationPid()) + "_job_" + QString::number(++lastJobId));
+    }
+
+    //The payload and the pixels share one segment (kept for the retry); QSharedMemory takes int sizes.
+    pixelsOffset = (sizeof(dHelperJob) + payloadSize + 63) & ~quint64(63);
+    jobSize = pixelsOffset + (quint64)width*height*4;
+    if((formatBytes.size() > int(MAX_FORMAT_STRING_LENGTH))||(jobSize > 0x7FFFFFFF)||(!job.create(int(jobSize))))
+        return DECODE_HELPER_UNAVAILABLE;
+
+    jobPtr = (dHelperJob*)job.data();
+    jobPtr->width = width;
+    jobPtr->height = height;
+    jobPtr->rowStrideInBits = rowStrideInBits;
+    jobPtr->auxFiltering = auxFilteringFlags;
+    memcpy(jobPtr->gain, gain, sizeof(jobPtr->gain));
+    memcpy(jobPtr->bias, bias, sizeof(jobPtr->bias));
+    jobPtr->formatLength = formatBytes.size();
+    memcpy(jobPtr->format, formatBytes.constData(), formatBytes.size());
+    jobPtr->payloadOffset = sizeof(dHelperJob);
+    jobPtr->payloadSize = payloadSize;
+    jobPtr->pixelsOffset = pixelsOffset;
+    memcpy((char*)job.data() + jobPtr->payloadOffset, payloadPtr, payloadSize);
+
+    for(int attempt = 0; attempt < DECODE_HELPER_ATTEMPTS; attempt++)
+    {
+        int     index = -1;
+        quint32 generation, sequence;
+
+        {
+            QMutexLocker lock(&helpersLock);
+
+            while(running)
+            {
+                bool anyAlive = false;
+
+                for(int i = 0; (i < helperSlots.size())&&(index < 0); i++)
+                {
+                    anyAlive = anyAlive || helperSlots.at(i).alive;
+                    if(helperSlots.at(i).alive && !helperSlots.at(i).busy)
+                        index = i;
+                }
+                if((index >= 0)||(!anyAlive)||cancelToken.isCancelled())
+                    break;
+                slotFreed.wait(&helpersLock, DECODE_HELPER_CANCEL_POLL_MS);
+            }
+
+            if(cancelToken.isCancelled())
+                return DECODE_HELPER_CANCELLED;
+
+            //Stopped meanwhile: decode in process.
+            if(index < 0)
+                return (running && (res == DECODE_HELPER_CRASHED))?res:DECODE_HELPER_UNAVAILABLE;
+
+            //Pending from here on, so a crash of the helper is always posted (see postResult).
+            dHelperSlot &next = helperSlots[index];
+            dHelperControl *controlPtr;
+
+            next.control->lock();
+            controlPtr = (dHelperControl*)next.control->data();
+            sequence = ++lastJobSequence;
+            generation = next.generation;
+            controlPtr->command = DECODE_HELPER_CMD_DECODE;
+            controlPtr->status = DECODE_HELPER_PENDING;
+            controlPtr->jobSequence = sequence;
+            qstrncpy(controlPtr->jobKey, job.key().toLatin1().constData(), sizeof(controlPtr->jobKey));
+            next.control->unlock();
+            next.busy = true;
+            next.jobStartedAt = QDateTime::currentDateTime();
+            next.jobToken = cancelToken;
+        }
+
+        res = decodeOnce(index, generation, sequence, job, visualData, gainOut, biasOut);
+        if(res != DECODE_HELPER_CRASHED)
+            return res;
+    }
+    return res;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CDecodeHelpers::decodeOnce(int index, quint32 generation, quint32 sequence, QSharedMemory &job,
+                               CTiledImage *visualData, float gainOut[4], float biasOut[4])
+{
+    QSharedMemory       *control;
+    QSystemSemaphore    *request;
+    QSystemSemaphore    *response;
+    const dHelperJob    *jobPtr = (const dHelperJob*)job.constData();
+    int                  res;
+    bool                 answered;
+    bool                 released = false;
+
+    {
+        QMutexLocker lock(&helpersLock);
+        control = helperSlots.at(index).control;
+        request = helperSlots.at(index).request;
+        response = helperSlots.at(index).response;
+    }
+
+    //Posted by the helper, or by helperFinished (crashed) and the watchdog (cancelled).
+    request->release();
+    do
+    {
+        response->acquire();
+        control->lock();
+        answered = (((dHelperControl*)control->data())->doneSequence == sequence);
+        res = ((dHelperControl*)control->data())->status;
+        control->unlock();
+    }while(!answered);
+
+    if(res == DECODE_HELPER_OK)
+    {
+        const uchar *pixelsPtr = (const uchar*)job.constData() + jobPtr->pixelsOffset;
+
+        *visualData = CTiledImage(jobPtr->width, jobPtr->height, (QImage::Format)jobPtr->imageFormat);
+        for(qint32 row = 0; row < visualData->tileRowCount(); row++)
+        {
+            for(qint32 col = 0; col < visualData->tileColumns(); col++)
+            {
+                QRect   rect = visualData->tileRect(col, row);
+                QImage &tile = visualData->tileRef(col, row);
+
+                for(qint32 y = 0; y < rect.height(); y++)
+                    memcpy(tile.scanLine(y), pixelsPtr + ((quint64)(rect.y() + y)*jobPtr->width + rect.x())*4, rect.width()*4);
+            }
+        }
+        memcpy(gainOut, jobPtr->resultGain, sizeof(jobPtr->resultGain));
+        memcpy(biasOut, jobPtr->resultBias, sizeof(jobPtr->resultBias));
+    }
+    else if((res != DECODE_HELPER_CRASHED)&&(res != DECODE_HELPER_CANCELLED))
+        res = DECODE_HELPER_FAILED;
+
+    {
+        QMutexLocker lock(&helpersLock);
+
+        //The helpers have been stopped or this one restarted meanwhile: its semaphores are ours.
+        if((index < helperSlots.size())&&(helperSlots.at(index).generation == generation))
+        {
+            helperSlots[index].busy = false;
+            helperSlots[index].jobToken = CCancelToken();
+            released = true;
+        }
+        slotFreed.wakeAll();
+    }
+
+    if(!released)
+    {
+        delete control;
+        delete request;
+        delete response;
+    }
+    return res;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CDecodeHelpers::helperMain(const QString &slotKey)
+{
+    QSharedMemory       control(slotKey);
+    QSystemSemaphore    request(slotKey + "_req", 0, QSystemSemaphore::Open);
+    QSystemSemaphore    response(slotKey + "_rsp", 0, QSystemSemaphore::Open);
+    CParentWatch        parentWatch;
+    dHelperControl     *controlPtr;
+    QString             jobKey;
+    int                 command, status;
+    quint32             sequence;
+
+    if(!control.attach())
+        return RES_ERROR;
+
+    parentWatch.start();
+
+    while(request.acquire())
+    {
+        control.lock();
+        controlPtr = (dHelperControl*)control.data();
+        command = controlPtr->command;
+        sequence = controlPtr->jobSequence;
+        jobKey = QString::fromLatin1(controlPtr->jobKey, qstrnlen(controlPtr->jobKey, sizeof(controlPtr->jobKey)));
+        control.unlock();
+
+        if(command == DECODE_HELPER_CMD_QUIT)
+            break;
+
+        status = runJob(jobKey);
+
+        //Answered only while the job is still pending, the viewer may have given up on it.
+        control.lock();
+        controlPtr = (dHelperControl*)control.data();
+        if((controlPtr->status == DECODE_HELPER_PENDING)&&(controlPtr->jobSequence == sequence))
+        {
+            controlPtr->status = status;
+            controlPtr->doneSequence = sequence;
+            response.release();
+        }
+        control.unlock();
+    }
+
+    ::exit(0);
+    return RES_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CDecodeHelpers::runJob(const QString &jobKey)
+{
+    QSharedMemory    job(jobKey);
+    dHelperJob      *jobPtr;
+    CNormalizator    normalizator;
+    QSharedPointer<const CDecodePlan> plan;
+    CTiledImage      image;
+    uchar           *pixelsPtr;
+    bool             filtering;
+
+    if(!job.attach())
+        return DECODE_HELPER_FAILED;
+
+    jobPtr = (dHelperJob*)job.data();
+    if((jobPtr->formatLength > MAX_FORMAT_STRING_LENGTH)||
+       (jobPtr->payloadOffset + jobPtr->payloadSize > jobPtr->pixelsOffset)||
+       (jobPtr->pixelsOffset + (quint64)jobPtr->width*jobPtr->height*4 > (quint64)job.size()))
+        return DECODE_HELPER_FAILED;
+
+    //A helper decodes many images of the same format, it compiles it once.
+    plan = CDecodePlan::compile(QString::fromLatin1(jobPtr->format, jobPtr->formatLength));
+    if(plan.isNull())
+        return DECODE_HELPER_FAILED;
+    plan->applyTo(normalizator);
+
+    normalizator.setImageWidth(jobPtr->width);
+    normalizator.setImageHeight(jobPtr->height);
+    normalizator.setNativeDataPtr((char*)job.data() + jobPtr->payloadOffset);
+    normalizator.setRowStride(jobPtr->rowStrideInBits);
+    normalizator.setREDGain(jobPtr->gain[0]);
+    normalizator.setREDBias(jobPtr->bias[0]);
+    normalizator.setGREENGain(jobPtr->gain[1]);
+    normalizator.setGREENBias(jobPtr->bias[1]);
+    normalizator.setBLUEGain(jobPtr->gain[2]);
+    normalizator.setBLUEBias(jobPtr->bias[2]);
+    normalizator.setALPHAGain(jobPtr->gain[3]);
+    normalizator.setALPHABias(jobPtr->bias[3]);
+
+    if(jobPtr->auxFiltering & FILTER_FLAG_AUTO_GAIN_BIAS)
+        normalizator.calibrate();
+
+    //The same choice as CImgContext::loadFromNativeData.
+    filtering = false;
+    for(int ch = R; ch <= A; ch++)
+    {
+        jobPtr->resultGain[ch] = normalizator.getChannelGain((channel)ch);
+        jobPtr->resultBias[ch] = normalizator.getChannelBias((channel)ch);
+        filtering = filtering || (jobPtr->resultGain[ch] != 1) || (jobPtr->resultBias[ch] != 0);
+    }
+
+    image = filtering?normalizator.getImageWithFiltering():normalizator.getImage();
+    if(image.isNull())
+        return DECODE_HELPER_FAILED;
+
+    pixelsPtr = (uchar*)job.data() + jobPtr->pixelsOffset;
+    for(qint32 row = 0; row < image.tileRowCount(); row++)
+    {
+        for(qint32 col = 0; col < image.tileColumns(); col++)
+        {
+            QRect         rect = image.tileRect(col, row);
+            const QImage &tile = image.tile(col, row);
+
+            for(qint32 y = 0; y < rect.height(); y++)
+                memcpy(pixelsPtr + ((quint64)(rect.y() + y)*jobPtr->width + rect.x())*4, tile.constScanLine(y), rect.width()*4);
+        }
+    }
+    jobPtr->imageFormat = image.format();
+    return DECODE_HELPER_OK;
+}
@@ -0,0 +1,269 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CDecodePipeline.h"
+#include "./inc/CWorkPool.h"
+#include "./inc/Threads.h"
+#include "./inc/globals.h"
+
+#include <QMutexLocker>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CPipelineTask class.
+ *        Runs one stage of a pipeline job on the work pool.
+ */
+
+class CPipelineTask : public CPrioritizedTask
+{
+public:
+    CPipelineTask(int stage, const CDecodePipeline::dPipelineJob &job)
+    {
+        this->stage = stage;
+        this->job = job;
+    }
+
+    int getPriority(){return job.worker->getPriority();}
+
+    void run(){CDecodePipeline::runStage(stage, job);}
+
+private:
+    int                            stage;
+    CDecodePipeline::dPipelineJob  job;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static const char* stageNames[PIPELINE_STAGE_COUNT] = {"Receive", "Validate", "Decode", "Publish"};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex                                CDecodePipeline::pipelineLock(QMutex::NonRecursive);
+QElapsedTimer                         CDecodePipeline::clock;
+QList<CDecodePipeline::dPipelineJob>  CDecodePipeline::validateQueue;
+QList<CDecodePipeline::dPipelineJob>  CDecodePipeline::decodeQueue;
+QList<CDecodePipeline::dPipelineJob>  CDecodePipeline::publishQueue;
+dPipelineStage                        CDecodePipeline::stages[PIPELINE_STAGE_COUNT];
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+qint64 CDecodePipeline::now()
+{
+    //Called under the pipeline lock.
+    if(!clock.isValid())
+        clock.start();
+    return clock.nsecsElapsed()/1000;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodePipeline::enqueue(int stage, QList<dPipelineJob> &queue, dPipelineJob &job)
+{
+    job.queuedAtUs = now();
+    queue.append(job);
+    stages[stage].peakQueued = qMax(stages[stage].peakQueued, queue.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CDecodePipeline::dPipelineJob CDecodePipeline::dequeue(int stage, QList<dPipelineJob> &queue, int index)
+{
+    dPipelineJob job = queue.takeAt(index);
+
+    stages[stage].waitUs += now() - job.queuedAtUs;
+    return job;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodePipeline::submit(CWorker_loadFromNativeData *worker)
+{
+    dPipelineJob job;
+
+    worker->handOver();
+    job.worker = worker;
+
+    {
+        QMutexLocker lock(&pipelineLock);
+
+        stages[PIPELINE_STAGE_RECEIVE].done++;
+        enqueue(PIPELINE_STAGE_VALIDATE, validateQueue, job);
+    }
+
+    dispatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CDecodePipeline::isSaturated()
+{
+    QMutexLocker lock(&pipelineLock);
+
+    if(validateQueue.size() < PIPELINE_VALIDATE_QUEUE_DEPTH)
+        return false;
+
+    stages[PIPELINE_STAGE_RECEIVE].stalls++;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodePipeline::dispatch()
+{
+    QList<CPipelineTask*> toStart;
+    int                   limit = CWorkPool::getThreadCount();
+
+    {
+        QMutexLocker lock(&pipelineLock);
+
+        //The jobs being validated count against the decode queue, they end up there.
+        while((stages[PIPELINE_STAGE_VALIDATE].running < limit)&&(!validateQueue.isEmpty()))
+        {
+            if(decodeQueue.size() + stages[PIPELINE_STAGE_VALIDATE].running >= PIPELINE_DECODE_QUEUE_DEPTH)
+            {
+                stages[PIPELINE_STAGE_VALIDATE].stalls++;
+                break;
+            }
+            stages[PIPELINE_STAGE_VALIDATE].running++;
+            toStart.append(new CPipelineTask(PIPELINE_STAGE_VALIDATE, dequeue(PIPELINE_STAGE_VALIDATE, validateQueue, 0)));
+        }
+
+        //The highest priority first, the oldest among equals (as the pool does).
+        while((stages[PIPELINE_STAGE_DECODE].running < limit)&&(!decodeQueue.isEmpty()))
+        {
+            int best = 0;
+            int bestPriority = decodeQueue.at(0).worker->getPriority();
+
+            if(publishQueue.size() + stages[PIPELINE_STAGE_DECODE].running >= PIPELINE_PUBLISH_QUEUE_DEPTH)
+            {
+                stages[PIPELINE_STAGE_DECODE].stalls++;
+                break;
+            }
+
+            for(int i = 1; (i < decodeQueue.size())&&(bestPriority < WORK_PRIORITY_FOCUS); i++)
+            {
+                int priority = decodeQueue.at(i).worker->getPriority();
+                if(priority > bestPriority)
+                {
+                    best = i;
+                    bestPriority = priority;
+                }
+            }
+            stages[PIPELINE_STAGE_DECODE].running++;
+            toStart.append(new CPipelineTask(PIPELINE_STAGE_DECODE, dequeue(PIPELINE_STAGE_DECODE, decodeQueue, best)));
+        }
+    }
+
+    for(int i = 0; i < toStart.size(); i++)
+        CWorkPool::start(toStart.at(i));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDecodePipeline::runStage(int stage, dPipelineJob job)
+{
+    QElapsedTimer busyTimer;
+    bool          passed = false;
+    bool          wakePublisher = false;
+
+    busyTimer.start();
+    if(stage == PIPELINE_STAGE_VALIDATE)
+    {
+        passed = (job.worker->parse() == RES_OK);
+    }
+    else
+    {
+        job.image = job.worker->decode();
+        passed = true;
+    }
+
+    //The worker is done after the decode, or when it has been rejected.
+    if((stage == PIPELINE_STAGE_DECODE)||(!passed))
+    {
+        job.worker->finish();
+        job.worker->deleteLater();
+    }
+
+    {
+        QMutexLocker lock(&pipelineLock);
+
+        stages[stage].running--;
+        stages[stage].done++;
+        stages[stage].busyUs += busyTimer.nsecsElapsed()/1000;
+
+        if(passed && (stage == PIPELINE_STAGE_VALIDATE))
+            enqueue(PIPELINE_STAGE_DECODE, decodeQueue, job);
+
+        if(passed && (stage == PIPELINE_STAGE_DECODE))
+        {
+            //One command per batch, the GUI takes all the images queued by then.
+            wakePublisher = publishQueue.isEmpty();
+            enqueue(PIPELINE_STAGE_PUBLISH, publishQueue, job);
+        }
+    }
+
+    if(wakePublisher)
+        Globals::addCmdToLocalQueue(CMD_PUBLISH_IMAGES);
+
+    dispatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QList<QSharedPointer<CImgContext> > CDecodePipeline::takePublished()
+{
+    QList<QSharedPointer<CImgContext> > ret;
+
+    {
+        QMutexLocker lock(&pipelineLock);
+
+        while(!publishQueue.isEmpty())
+        {
+            ret.append(dequeue(PIPELINE_STAGE_PUBLISH, publishQueue, 0).image);
+            stages[PIPELINE_STAGE_PUBLISH].done++;
+        }
+    }
+
+    //Room for the decodes held back.
+    dispatch();
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QList<dPipelineStage> CDecodePipeline::snapshot()
+{
+    QMutexLocker          lock(&pipelineLock);
+    QList<dPipelineStage> ret;
+
+    for(int i = 0; i < PIPELINE_STAGE_COUNT; i++)
+    {
+        dPipelineStage next = stages[i];
+
+        next.name = stageNames[i];
+        next.queued = 0;
+        next.bound = 0;
+        if(i == PIPELINE_STAGE_VALIDATE)
+        {
+            next.queued = validateQueue.size();
+            next.bound = PIPELINE_VALIDATE_QUEUE_DEPTH;
+        }
+        else if(i == PIPELINE_STAGE_DECODE)
+        {
+            next.queued = decodeQueue.size();
+            next.bound = PIPELINE_DECODE_QUEUE_DEPTH;
+        }
+        else if(i == PIPELINE_STAGE_PUBLISH)
+        {
+            next.queued = publishQueue.size();
+            next.bound = PIPELINE_PUBLISH_QUEUE_DEPTH;
+        }
+        ret.append(next);
+    }
+    return ret;
+}
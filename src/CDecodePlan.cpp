@@ -0,0 +1,175 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CDecodePlan.h"
+#include "./inc/CBitParser.h"
+#include "./inc/CWorkPool.h"
+#include "./inc/commons.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QAtomicInt>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CBatchLane class.
+ *        Decodes the buffers of a batch, taking the next one until none is left. Every lane
+ *        has its own normalizator, set up once for the whole batch.
+ */
+
+class CBatchLane : public QRunnable
+{
+public:
+    CBatchLane(const CDecodePlan *planPtr, const dDecodeParams *paramsPtr, const char* const *buffersPtr,
+               CTiledImage *resultsPtr, int count, QAtomicInt *nextPtr, const CCancelToken &cancelToken)
+    {
+        this->planPtr = planPtr;
+        this->paramsPtr = paramsPtr;
+        this->buffersPtr = buffersPtr;
+        this->resultsPtr = resultsPtr;
+        this->count = count;
+        this->nextPtr = nextPtr;
+        this->cancelToken = cancelToken;
+    }
+
+    void run()
+    {
+        CNormalizator normalizator;
+        bool          filtering = false;
+        int           index;
+
+        //Lanes started after the last buffer has been taken return at once.
+        index = nextPtr->fetchAndAddOrdered(1);
+        if(index >= count)
+            return;
+
+        planPtr->applyTo(normalizator);
+        normalizator.setImageWidth(paramsPtr->width);
+        normalizator.setImageHeight(paramsPtr->height);
+        normalizator.setRowStride(paramsPtr->rowStrideInBits);
+        normalizator.setREDGain(paramsPtr->gain[0]);
+        normalizator.setREDBias(paramsPtr->bias[0]);
+        normalizator.setGREENGain(paramsPtr->gain[1]);
+        normalizator.setGREENBias(paramsPtr->bias[1]);
+        normalizator.setBLUEGain(paramsPtr->gain[2]);
+        normalizator.setBLUEBias(paramsPtr->bias[2]);
+        normalizator.setALPHAGain(paramsPtr->gain[3]);
+        normalizator.setALPHABias(paramsPtr->bias[3]);
+        normalizator.setCancelToken(cancelToken);
+
+        for(int i = 0; i < 4; i++)
+            filtering = filtering || (paramsPtr->gain[i] != 1.0f) || (paramsPtr->bias[i] != 0.0f);
+
+        for(; index < count; index = nextPtr->fetchAndAddOrdered(1))
+        {
+            if(cancelToken.isCancelled())
+                continue;
+            normalizator.setNativeDataPtr((void*)buffersPtr[index]);
+            resultsPtr[index] = filtering?normalizator.getImageWithFiltering():normalizator.getImage();
+        }
+    }
+
+private:
+    const CDecodePlan    *planPtr;
+    const dDecodeParams  *paramsPtr;
+    const char* const    *buffersPtr;
+    CTiledImage          *resultsPtr;
+    int                   count;
+    QAtomicInt           *nextPtr;
+    CCancelToken          cancelToken;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex                                                CDecodePlan::cacheLock(QMutex::NonRecursive);
+QHash<QString, QSharedPointer<const CDecodePlan> >    CDecodePlan::cache;
+QList<QString>                                        CDecodePlan::cacheOrder;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QSharedPointer<const CDecodePlan> CDecodePlan::compile(const QString &formatStr, QString *log)
+{
+    QSharedPointer<CDecodePlan> plan;
+    CBitParser                  formatParser;
+
+    {
+        QMutexLocker lock(&cacheLock);
+
+        if(cache.contains(formatStr))
+        {
+            //Most recently used last.
+            cacheOrder.removeOne(formatStr);
+            cacheOrder.append(formatStr);
+            return cache.value(formatStr);
+        }
+    }
+
+    plan = QSharedPointer<CDecodePlan>(new CDecodePlan());
+    if(formatParser.parse(&plan->prototype, formatStr) != RES_OK)
+    {
+        if(log)
+            *log = formatParser.lastLog;
+        return QSharedPointer<const CDecodePlan>();
+    }
+    plan->prototype.adjustCapacity();
+    plan->formatStr = formatStr;
+    plan->effectiveBitCount = plan->prototype.getEffectiveBitCount();
+    plan->columnStride = plan->prototype.getColumnStride();
+
+    {
+        QMutexLocker lock(&cacheLock);
+
+        //Compiled by another thread meanwhile: keep the cached one.
+        if(cache.contains(formatStr))
+            return cache.value(formatStr);
+
+        cache.insert(formatStr, plan);
+        cacheOrder.append(formatStr);
+        while(cacheOrder.size() > DECODE_PLAN_CACHE_SIZE)
+            cache.remove(cacheOrder.takeFirst());
+    }
+    return plan;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CDecodePlan::getBufferSize(const dDecodeParams &params) const
+{
+    return ((quint64)params.width*params.height*columnStride + (quint64)params.rowStrideInBits*params.height)/8;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QVector<CTiledImage> CDecodePlan::decodeBatch(const QSharedPointer<const CDecodePlan> &plan,
+                                              const dDecodeParams &params,
+                                              const QVector<const char*> &buffers,
+                                              const CCancelToken &cancelToken)
+{
+    QVector<CTiledImage> results(buffers.size());
+    QAtomicInt           next(0);
+    CTaskGroup           group;
+    int                  lanes;
+
+    if(plan.isNull()||buffers.isEmpty()||(params.width == 0)||(params.height == 0))
+        return results;
+
+    //Each lane handles many buffers; more lanes than threads would only set up more normalizators.
+    lanes = qMax(1, qMin(buffers.size(), CWorkPool::getThreadCount()));
+    for(int i = 0; i < lanes; i++)
+        group.run(new CBatchLane(plan.data(), &params, buffers.constData(), results.data(), buffers.size(), &next, cancelToken));
+    group.wait();
+
+    return results;
+}
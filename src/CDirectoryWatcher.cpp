@@ -0,0 +1,229 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CDirectoryWatcher.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#ifdef Q_OS_LINUX
+    #include <sys/inotify.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CDirectoryWatcher::CDirectoryWatcher(QObject *parent):
+    QObject(parent)
+{
+    postAction = WATCH_POST_KEEP;
+    activeWorkers = 0;
+    inotifyFd = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CDirectoryWatcher::~CDirectoryWatcher()
+{
+    stop();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CDirectoryWatcher::start(const QString &path, int postAction, const QString &archivePath)
+{
+    QFileInfo dirInfo(path);
+
+    stop();
+
+    if(!dirInfo.isDir())
+    {
+        showStatusMessage("Watched directory does not exist.", UI_STATUS_ERROR, true);
+        return RES_ERROR;
+    }
+
+    if(postAction == WATCH_POST_ARCHIVE)
+    {
+        if(!QFileInfo(archivePath).isDir())
+        {
+            showStatusMessage("Archive directory does not exist.", UI_STATUS_ERROR, true);
+            return RES_ERROR;
+        }
+        this->archivePath = QFileInfo(archivePath).absoluteFilePath();
+    }
+
+    this->postAction = postAction;
+    watchedPath = dirInfo.absoluteFilePath();
+
+#ifdef Q_OS_LINUX
+    inotifyFd = inotify_init();
+    if(inotifyFd >= 0)
+    {
+        fcntl(inotifyFd, F_SETFL, fcntl(inotifyFd, F_GETFL) | O_NONBLOCK);
+        fcntl(inotifyFd, F_SETFD, FD_CLOEXEC);
+
+        //Only completed files: closed after writing or renamed into the directory.
+        if(inotify_add_watch(inotifyFd, QFile::encodeName(watchedPath).constData(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+        {
+            inotifyNotifierPtr = QPointer<QSocketNotifier>(new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this));
+            connect(inotifyNotifierPtr, SIGNAL(activated(int)), this, SLOT(inotifyEvent()));
+        }
+        else
+        {
+            close(inotifyFd);
+            inotifyFd = -1;
+        }
+    }
+#endif
+
+    if(inotifyNotifierPtr.isNull())
+    {
+        fsWatcherPtr = QPointer<QFileSystemWatcher>(new QFileSystemWatcher(this));
+        fsWatcherPtr->addPath(watchedPath);
+        connect(fsWatcherPtr, SIGNAL(directoryChanged(QString)), this, SLOT(directoryChanged(QString)));
+    }
+
+    //Pick up files dropped before the watch was set up.
+    scanDirectory();
+
+    showStatusMessage("Watching the directory: " + watchedPath, UI_STATUS_NETWORK, true);
+    return RES_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDirectoryWatcher::stop()
+{
+    if(!inotifyNotifierPtr.isNull())
+        delete inotifyNotifierPtr;
+
+#ifdef Q_OS_LINUX
+    if(inotifyFd >= 0)
+        close(inotifyFd);
+#endif
+    inotifyFd = -1;
+
+    if(!fsWatcherPtr.isNull())
+        delete fsWatcherPtr;
+
+    //Files already handed over to workers are still loaded.
+    pendingFiles.clear();
+    knownFiles.clear();
+    watchedPath.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDirectoryWatcher::inotifyEvent()
+{
+#ifdef Q_OS_LINUX
+    char        buff[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t     len;
+    char       *ptr;
+    const struct inotify_event *event;
+
+    while((len = read(inotifyFd, buff, sizeof(buff))) > 0)
+    {
+        for(ptr = buff; ptr < buff + len; ptr += sizeof(struct inotify_event) + event->len)
+        {
+            event = (const struct inotify_event*)ptr;
+
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                //Events were dropped by the kernel, fall back to a single listing
+                //(with WATCH_POST_KEEP files still present may be loaded again).
+                scanDirectory();
+                continue;
+            }
+
+            if((event->len > 0)&&!(event->mask & IN_ISDIR))
+                enqueue(QFile::decodeName(event->name));
+        }
+    }
+
+    dispatch();
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDirectoryWatcher::directoryChanged(const QString &path)
+{
+    Q_UNUSED(path);
+    scanDirectory();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDirectoryWatcher::scanDirectory()
+{
+    QStringList   entries;
+    QSet<QString> present;
+
+    if(watchedPath.isEmpty())
+        return;
+
+    entries = QDir(watchedPath).entryList(QDir::Files, QDir::Time | QDir::Reversed);
+
+    for(int i = 0; i < entries.size(); i++)
+    {
+        present.insert(entries.at(i));
+        if(!knownFiles.contains(entries.at(i)))
+            enqueue(entries.at(i));
+    }
+
+    //Forget names which are gone, so a re-dropped file is picked up again.
+    knownFiles.intersect(present);
+    dispatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDirectoryWatcher::enqueue(const QString &fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+
+    if(fileName.startsWith("."))
+        return;
+
+    if(!suffix.isEmpty() && QString(WATCH_PARTIAL_SUFFIXES).split(";").contains(suffix))
+        return;
+
+    //Only the listing fallback needs to remember what has been seen already.
+    if(!fsWatcherPtr.isNull())
+        knownFiles.insert(fileName);
+    pendingFiles.append(watchedPath + "/" + fileName);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDirectoryWatcher::dispatch()
+{
+    QStringList batch;
+
+    //Files are handed over in batches, so bursts of small files do not spawn a thread per file.
+    while((activeWorkers < COM_MAX_PROCESSING_THREADS)&&!pendingFiles.isEmpty())
+    {
+        batch = pendingFiles.mid(0, WATCH_BATCH_SIZE);
+        pendingFiles = pendingFiles.mid(batch.size());
+
+        CWorker_ingestFiles* newWorker = new CWorker_ingestFiles(this, batch, postAction, archivePath);
+        activeWorkers++;
+        newWorker->selfStart();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CDirectoryWatcher::iAmDone()
+{
+    activeWorkers--;
+    dispatch();
+}
@@ -0,0 +1,243 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CFloatExport.h"
+#include "./inc/CWorkPool.h"
+#include "./inc/commons.h"
+
+#include <QFile>
+#include <QRunnable>
+#include <QtEndian>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CRowBandDecoder class.
+ *        Decodes a band of rows into RGBA floats. The normalizator is only read
+ *        (see CNormalizator::getPixelValue), so all bands may share it.
+ */
+
+class CRowBandDecoder : public QRunnable
+{
+public:
+    CRowBandDecoder(const CNormalizator *normalizatorPtr, float *dstPtr, quint32 width, quint32 firstRow, quint32 rowCount)
+    {
+        this->normalizatorPtr = normalizatorPtr;
+        this->dstPtr = dstPtr;
+        this->width = width;
+        this->firstRow = firstRow;
+        this->rowCount = rowCount;
+    }
+
+    void run()
+    {
+        quint64 bitCounter;
+        quint64 rowBits = normalizatorPtr->getRowStride() + normalizatorPtr->getColumnStride()*width;
+        float  *pixelPtr = dstPtr;
+
+        for(quint32 ih = firstRow; ih < firstRow + rowCount; ih++)
+        {
+            bitCounter = rowBits*ih;
+            for(quint32 iw = 0; iw < width; iw++)
+            {
+                normalizatorPtr->getPixelValue(bitCounter, pixelPtr);
+                bitCounter += normalizatorPtr->getColumnStride();
+                pixelPtr += 4;
+            }
+        }
+    }
+
+private:
+    const CNormalizator *normalizatorPtr;
+    float               *dstPtr;
+    quint32              width;
+    quint32              firstRow;
+    quint32              rowCount;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CFloatExport::CFloatExport(const QSharedPointer<CImgContext> &imgCtxPtr)
+{
+    this->imgCtxPtr = imgCtxPtr;
+    width = height = bandRows = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CFloatExport::setup()
+{
+    quint64 rowBytes;
+
+    if(imgCtxPtr.isNull())
+    {
+        lastLog = "Nothing to export.";
+        return RES_ERROR;
+    }
+
+    width = imgCtxPtr->getIWidth();
+    height = imgCtxPtr->getIHeight();
+    if((width == 0)||(height == 0))
+    {
+        lastLog = "Empty image.";
+        return RES_ERROR;
+    }
+
+    //A private reader, the image normalizator stays free for pixel picking.
+    if(imgCtxPtr->setupReader(normalizator, fileData, lastLog) != RES_OK)
+        return RES_ERROR;
+
+    //Whole tile rows, so a band covers a row of tiles of the tiled format.
+    rowBytes = 4*sizeof(float)*(quint64)width;
+    bandRows = quint32(qMax<quint64>(1, FLOAT_EXPORT_BAND_BYTES/(rowBytes*FLOAT_EXPORT_TILE_SIZE)))*FLOAT_EXPORT_TILE_SIZE;
+    bandRows = min(bandRows, height);
+    band.resize(int(4*(quint64)width*bandRows));
+
+    return RES_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CFloatExport::decodeBand(quint32 firstRow, quint32 rowCount)
+{
+    CTaskGroup group;
+
+    for(quint32 ih = firstRow; ih < firstRow + rowCount; ih += FLOAT_EXPORT_ROWS_PER_TASK)
+    {
+        group.run(new CRowBandDecoder(&normalizator,
+                                       band.data() + 4*(quint64)(ih - firstRow)*width,
+                                       width,
+                                       ih,
+                                       min(FLOAT_EXPORT_ROWS_PER_TASK, firstRow + rowCount - ih)));
+    }
+    group.wait();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CFloatExport::saveToPFMFile(const QString &fileName)
+{
+    QFile       ofile(fileName);
+    QByteArray  header;
+    QVector<float> row;
+    quint32     firstRow, rowCount;
+
+    if(setup() != RES_OK)
+        return RES_ERROR;
+
+    if(!ofile.open(QIODevice::WriteOnly))
+    {
+        lastLog = "Error opening the file.";
+        return RES_ERROR;
+    }
+
+    //A negative scale marks little-endian data.
+    header = "PF\n" + QByteArray::number(width) + " " + QByteArray::number(height) + "\n";
+    header += (Q_BYTE_ORDER == Q_LITTLE_ENDIAN)?"-1.0\n":"1.0\n";
+    if(ofile.write(header) != header.size())
+        goto __EXIT_WITH_ERROR;
+
+    //PFM stores rows bottom-to-top, so are the bands.
+    row.resize(3*width);
+    firstRow = ((height - 1)/bandRows)*bandRows;
+    for(;;)
+    {
+        rowCount = min(bandRows, height - firstRow);
+        decodeBand(firstRow, rowCount);
+
+        for(qint32 ib = rowCount - 1; ib >= 0; ib--)
+        {
+            const float* srcPtr = band.constData() + 4*(quint64)ib*width;
+            for(quint32 iw = 0; iw < width; iw++)
+            {
+                row[3*iw    ] = srcPtr[4*iw    ];
+                row[3*iw + 1] = srcPtr[4*iw + 1];
+                row[3*iw + 2] = srcPtr[4*iw + 2];
+            }
+            if(ofile.write((const char*)row.constData(), qint64(3*sizeof(float))*width) != qint64(3*sizeof(float))*width)
+                goto __EXIT_WITH_ERROR;
+        }
+
+        if(firstRow == 0)
+            break;
+        firstRow -= bandRows;
+    }
+
+    ofile.close();
+    return RES_OK;
+
+__EXIT_WITH_ERROR:
+    lastLog = "Error writing the file.";
+    ofile.close();
+    return RES_ERROR;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CFloatExport::saveToTiledFloatFile(const QString &fileName)
+{
+    QFile       ofile(fileName);
+    quint32     header[4];
+    quint32     tileWidth, tileHeight;
+    QVector<quint32> tileRow;
+
+    if(setup() != RES_OK)
+        return RES_ERROR;
+
+    if(!ofile.open(QIODevice::WriteOnly))
+    {
+        lastLog = "Error opening the file.";
+        return RES_ERROR;
+    }
+
+    header[0] = qToLittleEndian<quint32>(width);
+    header[1] = qToLittleEndian<quint32>(height);
+    header[2] = qToLittleEndian<quint32>(FLOAT_EXPORT_TILE_SIZE);
+    header[3] = qToLittleEndian<quint32>(4);
+
+    if(ofile.write(FLOAT_EXPORT_TILED_MAGIC, MAGIC_CHARS_SIZE) != MAGIC_CHARS_SIZE)
+        goto __EXIT_WITH_ERROR;
+    if(ofile.write((const char*)header, sizeof(header)) != sizeof(header))
+        goto __EXIT_WITH_ERROR;
+
+    tileRow.resize(4*FLOAT_EXPORT_TILE_SIZE);
+    for(quint32 ty = 0; ty < height; ty += FLOAT_EXPORT_TILE_SIZE)
+    {
+        tileHeight = min(FLOAT_EXPORT_TILE_SIZE, height - ty);
+
+        //Bands hold whole tile rows.
+        if((ty % bandRows) == 0)
+            decodeBand(ty, min(bandRows, height - ty));
+
+        for(quint32 tx = 0; tx < width; tx += FLOAT_EXPORT_TILE_SIZE)
+        {
+            tileWidth = min(FLOAT_EXPORT_TILE_SIZE, width - tx);
+            for(quint32 ih = ty; ih < ty + tileHeight; ih++)
+            {
+                const quint32* srcPtr = (const quint32*)(band.constData() + 4*((quint64)(ih % bandRows)*width + tx));
+                for(quint32 i = 0; i < 4*tileWidth; i++)
+                    tileRow[i] = qToLittleEndian<quint32>(srcPtr[i]);
+                if(ofile.write((const char*)tileRow.constData(), 4*tileWidth*sizeof(float)) != qint64(4*tileWidth*sizeof(float)))
+                    goto __EXIT_WITH_ERROR;
+            }
+        }
+    }
+
+    ofile.close();
+    return RES_OK;
+
+__EXIT_WITH_ERROR:
+    lastLog = "Error writing the file.";
+    ofile.close();
+    return RES_ERROR;
+}
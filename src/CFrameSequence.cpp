@@ -0,0 +1,243 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CFrameSequence.h"
+#include "./inc/commons.h"
+#include "./inc/CNormalizator.h"
+#include "./inc/Threads.h"
+
+#include <QMutexLocker>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CFrameSequence::CFrameSequence(const QSharedPointer<CNativeData> &nativeDataPtr)
+{
+    this->nativeDataPtr = nativeDataPtr;
+
+    frameSize = frameStride = 0;
+    frameCount = 0;
+    cursor = 0;
+
+    params.width = params.height = 0;
+    params.rowStrideInBits = 0;
+    params.gain[0] = params.gain[1] = params.gain[2] = params.gain[3] = 1.0f;
+    params.bias[0] = params.bias[1] = params.bias[2] = params.bias[3] = 0.0f;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CFrameSequence::setup(quint32       width,
+                          quint32       height,
+                          quint32       rowStrideInBits,
+                          QString       formatStr,
+                          const float   gain[4],
+                          const float   bias[4],
+                          quint32       frameSize,
+                          quint32       frameStride,
+                          quint32       frameCount)
+{
+    QSharedPointer<const CDecodePlan> newPlan;
+    quint64         minFrameSize;
+    quint32         dataSize;
+
+    if(nativeDataPtr.isNull())
+    {
+        lastLog = "No native data attached.";
+        return RES_ERROR;
+    }
+
+    newPlan = CDecodePlan::compile(formatStr, &lastLog);
+    if(newPlan.isNull())
+        return RES_ERROR;
+
+    minFrameSize = ((quint64)width*height*newPlan->getColumnStride() + (quint64)rowStrideInBits*height)/8;
+    dataSize = nativeDataPtr->getData().size();
+
+    if(minFrameSize > dataSize)
+    {
+        lastLog = "Invalid frame size/stride. Minimal frame size: " + QString::number(minFrameSize) + "B.";
+        return RES_ERROR;
+    }
+
+    if(frameSize == 0)
+        frameSize = minFrameSize;
+    if(frameStride == 0)
+        frameStride = frameSize;
+
+    if((frameSize < minFrameSize)||(frameStride < frameSize)||(frameSize > dataSize))
+    {
+        lastLog = "Invalid frame size/stride. Minimal frame size: " + QString::number(minFrameSize) + "B.";
+        return RES_ERROR;
+    }
+
+    //Frame count of 0 means "as many as fit".
+    if(frameCount == 0)
+        frameCount = (dataSize - frameSize)/frameStride + 1;
+
+    if(((quint64)(frameCount - 1)*frameStride + frameSize) > dataSize)
+    {
+        lastLog = "Declared frames exceed the data size (" + QString::number(dataSize) + "B).";
+        return RES_ERROR;
+    }
+
+    plan = newPlan;
+    params.width = width;
+    params.height = height;
+    params.rowStrideInBits = rowStrideInBits;
+    this->frameSize = frameSize;
+    this->frameStride = frameStride;
+    this->frameCount = frameCount;
+
+    for(int i = 0; i < 4; i++)
+    {
+        params.gain[i] = gain[i];
+        params.bias[i] = bias[i];
+    }
+
+    return RES_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+char* CFrameSequence::getFramePtr(qint32 index)
+{
+    index = max(0, min(index, frameCount - 1));
+    return nativeDataPtr->getDataPtr() + (quint64)index*frameStride;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CTiledImage CFrameSequence::decodeFrame(qint32 index)
+{
+    QVector<CTiledImage> frames = decodeFrames(QList<qint32>() << index);
+    return frames.isEmpty()?CTiledImage():frames.first();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QVector<CTiledImage> CFrameSequence::decodeFrames(const QList<qint32> &indices)
+{
+    QVector<const char*> buffers;
+
+    for(int i = 0; i < indices.size(); i++)
+    {
+        if((indices.at(i) < 0)||(indices.at(i) >= frameCount))
+            return QVector<CTiledImage>(indices.size());
+        buffers.append(getFramePtr(indices.at(i)));
+    }
+    return CDecodePlan::decodeBatch(plan, params, buffers);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CFrameSequence::getCachedFrame(qint32 index, CTiledImage &frame)
+{
+    QMutexLocker lock(&cacheLock);
+
+    if(!frameCache.contains(index))
+        return false;
+    frame = frameCache.value(index);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+qint32 CFrameSequence::getNearestCachedFrame(qint32 index, CTiledImage &frame)
+{
+    QMutexLocker lock(&cacheLock);
+    qint32       nearest = -1;
+
+    for(QMap<qint32, CTiledImage>::const_iterator i = frameCache.constBegin(); i != frameCache.constEnd(); ++i)
+        if((nearest < 0)||(qAbs(i.key() - index) < qAbs(nearest - index)))
+            nearest = i.key();
+
+    if(nearest >= 0)
+        frame = frameCache.value(nearest);
+    return nearest;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CFrameSequence::storeFrame(qint32 index, const CTiledImage &frame)
+{
+    QMutexLocker lock(&cacheLock);
+
+    pendingFrames.remove(index);
+
+    //The cursor might have moved away while the frame was being decoded.
+    if(qAbs(index - cursor) > SEQ_PREFETCH_RADIUS)
+        return;
+    if(!frame.isNull())
+        frameCache.insert(index, frame);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CFrameSequence::getCacheSizeInBytes()
+{
+    QMutexLocker lock(&cacheLock);
+    quint64      bytes = 0;
+
+    for(QMap<qint32, CTiledImage>::const_iterator i = frameCache.constBegin(); i != frameCache.constEnd(); ++i)
+        bytes += i.value().getSizeInBytes();
+    return bytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CFrameSequence::setCursor(qint32 index)
+{
+    QMutexLocker lock(&cacheLock);
+    QMap<qint32, CTiledImage>::iterator i;
+
+    cursor = index;
+
+    i = frameCache.begin();
+    while(i != frameCache.end())
+    {
+        if(qAbs(i.key() - cursor) > SEQ_PREFETCH_RADIUS)
+            i = frameCache.erase(i);
+        else
+            ++i;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CFrameSequence::prefetch(const QSharedPointer<CFrameSequence> &sequencePtr, qint32 index)
+{
+    QList<qint32> toDecode;
+    qint32        candidate;
+
+    if(sequencePtr.isNull())
+        return;
+
+    sequencePtr->cacheLock.lock();
+    //The frame at the cursor, then the frames ahead of it first, then behind it.
+    for(int d = 0; d <= SEQ_PREFETCH_RADIUS; d++)
+    {
+        for(int dir = 1; dir >= ((d == 0)?1:-1); dir -= 2)
+        {
+            candidate = index + dir*d;
+            if((candidate < 0)||(candidate >= sequencePtr->frameCount))
+                continue;
+            if(sequencePtr->frameCache.contains(candidate)||sequencePtr->pendingFrames.contains(candidate))
+                continue;
+            sequencePtr->pendingFrames.insert(candidate);
+            toDecode.append(candidate);
+        }
+    }
+    sequencePtr->cacheLock.unlock();
+
+    //One batch: the frames share the format, the lanes set it up once.
+    if(!toDecode.isEmpty())
+    {
+        CWorker_decodeSequenceFrames* newWorker = new CWorker_decodeSequenceFrames(sequencePtr, toDecode);
+        newWorker->selfStart();
+    }
+}
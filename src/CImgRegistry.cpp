@@ -0,0 +1,206 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CImgRegistry.h"
+
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CImgRegistry::CImgRegistry()
+{
+    lastId = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint32 CImgRegistry::add(const QSharedPointer<CImgContext> &imgContextPtr)
+{
+    QWriteLocker lock(&registryLock);
+    quint32      id = ++lastId;
+
+    imgContextPtr->setMyID(id);
+    byOrder.insert(id, imgContextPtr);
+    byId.insert(id, imgContextPtr);
+    byContext.insert(imgContextPtr.data(), id);
+    indexName(id, imgContextPtr->getMyName());
+    return id;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CImgRegistry::remove(const QSharedPointer<CImgContext> &imgContextPtr)
+{
+    QWriteLocker lock(&registryLock);
+    quint32      id;
+
+    if(!byContext.contains(imgContextPtr.data()))
+        return false;
+
+    id = byContext.take(imgContextPtr.data());
+    byOrder.remove(id);
+    byId.remove(id);
+    unindexName(id);
+    if(byContent.value(imgContextPtr->getContentHash()) == id)
+        byContent.remove(imgContextPtr->getContentHash());
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QList<QSharedPointer<CImgContext> > CImgRegistry::takeAll()
+{
+    QList<QSharedPointer<CImgContext> > ret = snapshot();
+    QWriteLocker lock(&registryLock);
+
+    byOrder.clear();
+    byId.clear();
+    byContext.clear();
+    byName.clear();
+    nameOf.clear();
+    byContent.clear();
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QList<QSharedPointer<CImgContext> > CImgRegistry::snapshot()
+{
+    QReadLocker                         lock(&registryLock);
+    QList<QSharedPointer<CImgContext> > ret;
+
+    ret.reserve(byOrder.size());
+    for(QMap<quint32, QSharedPointer<CImgContext> >::const_iterator i = byOrder.constEnd(); i != byOrder.constBegin();)
+    {
+        --i;
+        ret.append(i.value());
+    }
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QSharedPointer<CImgContext> CImgRegistry::findById(quint32 id)
+{
+    QReadLocker lock(&registryLock);
+    return byId.value(id);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QSharedPointer<CImgContext> CImgRegistry::findByContext(const void *imgContextPtr)
+{
+    QReadLocker lock(&registryLock);
+
+    if(!byContext.contains(imgContextPtr))
+        return QSharedPointer<CImgContext>();
+    return byId.value(byContext.value(imgContextPtr));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QSharedPointer<CImgContext> CImgRegistry::findByName(const QString &name)
+{
+    QReadLocker                                      lock(&registryLock);
+    QHash<QString, QList<quint32> >::const_iterator  i = byName.constFind(name);
+
+    if(i == byName.constEnd())
+        return QSharedPointer<CImgContext>();
+    return byId.value(i.value().last());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QList<QSharedPointer<CImgContext> > CImgRegistry::findAllByName(const QString &name)
+{
+    QReadLocker                         lock(&registryLock);
+    QList<QSharedPointer<CImgContext> > ret;
+    QList<quint32>                      ids = byName.value(name);
+
+    for(int i = ids.size() - 1; i >= 0; i--)
+        ret.append(byId.value(ids.at(i)));
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QSharedPointer<CImgContext> CImgRegistry::findByContentHash(quint64 hash)
+{
+    QReadLocker lock(&registryLock);
+
+    if(!byContent.contains(hash))
+        return QSharedPointer<CImgContext>();
+    return byId.value(byContent.value(hash));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CImgRegistry::setContentHash(const QSharedPointer<CImgContext> &imgContextPtr, quint64 hash)
+{
+    QWriteLocker lock(&registryLock);
+    quint32      id;
+
+    imgContextPtr->setContentHash(hash);
+    if(!byContext.contains(imgContextPtr.data()))
+        return;
+
+    id = byContext.value(imgContextPtr.data());
+    if(byContent.value(hash) < id)
+        byContent.insert(hash, id);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CImgRegistry::rename(const void *imgContextPtr, const QString &newName)
+{
+    QWriteLocker lock(&registryLock);
+    quint32      id;
+
+    if(!byContext.contains(imgContextPtr))
+        return;
+
+    id = byContext.value(imgContextPtr);
+    if(nameOf.value(id) == newName)
+        return;
+
+    unindexName(id);
+    indexName(id, newName);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CImgRegistry::count()
+{
+    QReadLocker lock(&registryLock);
+    return byOrder.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CImgRegistry::indexName(quint32 id, const QString &name)
+{
+    QList<quint32> &ids = byName[name];
+
+    //Kept in ID order, so the newest image wins a name clash.
+    ids.insert(std::lower_bound(ids.begin(), ids.end(), id) - ids.begin(), id);
+    nameOf.insert(id, name);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CImgRegistry::unindexName(quint32 id)
+{
+    QString                                    name = nameOf.take(id);
+    QHash<QString, QList<quint32> >::iterator  i = byName.find(name);
+
+    if(i == byName.end())
+        return;
+
+    i.value().removeOne(id);
+    if(i.value().isEmpty())
+        byName.erase(i);
+}
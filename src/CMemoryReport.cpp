@@ -0,0 +1,177 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CMemoryReport.h"
+#include "./inc/CBufferPool.h"
+#include "./inc/CSpillStore.h"
+#include "./inc/globals.h"
+
+#include <QFile>
+#include <QSet>
+#include <QDateTime>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static QString jsonString(const QString &value)
+{
+    QString ret = "\"";
+
+    for(int i = 0; i < value.size(); i++)
+    {
+        QChar c = value.at(i);
+
+        if(c == '"')
+            ret += "\\\"";
+        else if(c == '\\')
+            ret += "\\\\";
+        else if(c.unicode() < 0x20)
+            ret += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        else
+            ret += c;
+    }
+    return ret + "\"";
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static QString jsonUsage(const dMemoryUsage &usage)
+{
+    return QString("{\"native\": %1, \"visual\": %2, \"render\": %3, \"sequence\": %4, \"thumbnail\": %5, \"total\": %6}")
+            .arg(usage.nativeBytes)
+            .arg(usage.visualBytes)
+            .arg(usage.renderBytes)
+            .arg(usage.sequenceBytes)
+            .arg(usage.thumbnailBytes)
+            .arg(CMemoryReport::getTotal(usage));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static const char* stateName(uint state)
+{
+    switch(state)
+    {
+        case STATE_READY:       return "ready";
+        case STATE_BUSY:        return "busy";
+        case STATE_BAD:         return "bad";
+        case STATE_DELETE_MARK: return "deleted";
+        case STATE_SPILLED:     return "spilled";
+    }
+    return "unknown";
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CMemoryReport::CMemoryReport()
+{
+    memset(&totals, 0, sizeof(totals));
+    toolOutputBytes = poolLiveBytes = poolCachedBytes = spillBytes = budgetBytes = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CMemoryReport::getTotal(const dMemoryUsage &usage)
+{
+    return usage.nativeBytes + usage.visualBytes + usage.renderBytes + usage.sequenceBytes + usage.thumbnailBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CMemoryReport::collect()
+{
+    QList<QSharedPointer<CImgContext> > snapshot = Globals::imgRegistry.snapshot();
+    QSet<const void*>                   countedBlocks;
+    dImageMemoryEntry                   entry;
+
+    images.clear();
+    memset(&totals, 0, sizeof(totals));
+    toolOutputBytes = 0;
+
+    for(int i = 0; i < snapshot.size(); i++)
+    {
+        const QSharedPointer<CImgContext> &next = snapshot.at(i);
+
+        entry.id = next->getMyID();
+        entry.name = next->getMyName();
+        entry.state = next->getMyState();
+        entry.pinned = next->isPinned();
+        entry.toolOutput = next->isToolOutput();
+        entry.lastViewStamp = next->getLastViewStamp();
+        entry.usage = next->getMemoryUsage(&countedBlocks);
+        images.append(entry);
+
+        totals.nativeBytes    += entry.usage.nativeBytes;
+        totals.visualBytes    += entry.usage.visualBytes;
+        totals.renderBytes    += entry.usage.renderBytes;
+        totals.sequenceBytes  += entry.usage.sequenceBytes;
+        totals.thumbnailBytes += entry.usage.thumbnailBytes;
+        if(entry.toolOutput)
+            toolOutputBytes += getTotal(entry.usage);
+    }
+
+    poolLiveBytes = CBufferPool::getLiveBytes();
+    poolCachedBytes = CBufferPool::getCachedBytes();
+    spillBytes = CSpillStore::getLiveBytes();
+    budgetBytes = (quint64)Globals::imgMemoryBudgetMB << 20;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QString CMemoryReport::toJson()
+{
+    QString ret;
+
+    ret  = "{\n";
+    ret += "  \"time\": " + jsonString(QDateTime::currentDateTime().toString(Qt::ISODate)) + ",\n";
+    ret += "  \"budget\": " + QString::number(budgetBytes) + ",\n";
+    ret += "  \"totals\": " + jsonUsage(totals) + ",\n";
+    ret += "  \"toolOutputs\": " + QString::number(toolOutputBytes) + ",\n";
+    ret += "  \"pool\": {\"live\": " + QString::number(poolLiveBytes) + ", \"cached\": " + QString::number(poolCachedBytes) + "},\n";
+    ret += "  \"spill\": " + QString::number(spillBytes) + ",\n";
+    ret += "  \"images\": [";
+
+    for(int i = 0; i < images.size(); i++)
+    {
+        const dImageMemoryEntry &next = images.at(i);
+
+        ret += (i == 0)?"\n":",\n";
+        ret += "    {\"id\": " + QString::number(next.id);
+        ret += ", \"name\": " + jsonString(next.name);
+        ret += ", \"state\": " + jsonString(stateName(next.state));
+        ret += ", \"pinned\": " + QString(next.pinned?"true":"false");
+        ret += ", \"toolOutput\": " + QString(next.toolOutput?"true":"false");
+        ret += ", \"lastView\": " + QString::number(next.lastViewStamp);
+        ret += ", \"usage\": " + jsonUsage(next.usage) + "}";
+    }
+
+    ret += "\n  ]\n}\n";
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CMemoryReport::dumpJson(const QString &fileName)
+{
+    QFile      ofile(fileName);
+    QByteArray json = toJson().toUtf8();
+
+    if(!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return RES_ERROR;
+
+    if(ofile.write(json) != json.size())
+    {
+        ofile.close();
+        return RES_ERROR;
+    }
+
+    ofile.close();
+    return RES_OK;
+}
@@ -20,7 +20,11 @@
 #include<QDebug>
 
 #include "./inc/CNativeData.h"
+#include "./inc/CBufferPool.h"
 #include "./inc/commons.h"
+#include "./inc/defines.h"
+
+#include <string.h>
 
 CNativeData::CNativeData(QObject *parent):
     QObject(parent)
@@ -52,10 +56,45 @@ CNativeData::CNativeData(const char* rawBufferDataWithHeader, QObject *parent):
     data.setRawData(fromRAWBuffer + offset, ((dHeader*)(rawBufferDataWithHeader + MAGIC_CHARS_SIZE))->sizeInBytes);
 }
 
+CNativeData::CNativeData(quint32 sizeInBytes, bool zeroFill, QObject *parent):
+    QObject(parent)
+{
+    fromRAWBuffer = CBufferPool::acquire(sizeInBytes);
+    if(fromRAWBuffer)
+    {
+        if(zeroFill)
+            memset(fromRAWBuffer, 0, sizeInBytes);
+        data.setRawData(fromRAWBuffer, sizeInBytes);
+    }
+}
+
+CNativeData::CNativeData(const QImage &image, QObject *parent):
+    QObject(parent)
+{
+    quint64 sizeInBytes = (quint64)image.bytesPerLine()*image.height();
+
+    fromRAWBuffer = NULL;
+
+    //The normalizator reads whole 64-bit words.
+    if((sizeInBytes % sizeof(quint64)) == 0)
+    {
+        viewedImage = image;
+        data.setRawData((const char*)viewedImage.constBits(), sizeInBytes);
+    }
+    else
+    {
+        data.reserve(sizeInBytes + COM_ALIGN_MARGIN_SIZE);
+        for(int i = 0; i < image.height(); i++)
+            data.append((const char*)image.constScanLine(i), image.bytesPerLine());
+        data.append(COM_ALIGN_CHARS, COM_ALIGN_MARGIN_SIZE);
+    }
+}
+
 CNativeData::~CNativeData()
 {
     if(fromRAWBuffer)
     {
-        delete fromRAWBuffer;
+        data.clear();
+        CBufferPool::release(fromRAWBuffer);
     }
 }
@@ -20,6 +20,7 @@
 #include "./inc/CNormalizator.h"
 #include "./inc/CImgContext.h"
 #include "./inc/globals.h"
+#include "./inc/CWorkPool.h"
 
 #include <QImage>
 #include <math.h>
@@ -416,6 +417,8 @@ CNormalizator::CNormalizator()
     mType[0]= mType[1] = mType[2] = mType[3] = NORM_EMPTY;
 
     width = height = 0;
+    progressPtr = NULL;
+    preemptible = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -483,6 +486,33 @@ void CNormalizator::adjustCapacity()
     channelAbsCapacity[3] = (quint32)pow(2.0f, (int)channelBitCount[3])-1;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CNormalizator::copyFormat(const CNormalizator &source)
+{
+    //The mask vectors stay implicitly shared with <source>: the decode paths only read them
+    //through at(), so they are never detached, even when many threads read one plan.
+    myREDBitsIndices = source.myREDBitsIndices;
+    myGREENBitsIndices = source.myGREENBitsIndices;
+    myBLUEBitsIndices = source.myBLUEBitsIndices;
+    myALPHABitsIndices = source.myALPHABitsIndices;
+    effectivePixelBitsCount = source.effectivePixelBitsCount;
+    dummyBitsCount = source.dummyBitsCount;
+
+    for(int i = 0; i < 4; i++)
+    {
+        mType[i] = source.mType[i];
+        channelBitPattern[i] = source.channelBitPattern[i];
+        channelBitCount[i] = source.channelBitCount[i];
+    }
+
+    absREDValueFlag = source.absREDValueFlag;
+    absGREENValueFlag = source.absGREENValueFlag;
+    absBLUEValueFlag = source.absBLUEValueFlag;
+    absALPHAValueFlag = source.absALPHAValueFlag;
+
+    adjustCapacity();
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CNormalizator::setNativeDataPtr(void *ptr)
 {
@@ -507,7 +537,7 @@ void CNormalizator::setImageHeight(quint32 h)
 void CNormalizator::calibrate()
 {
     quint32 iw, ih;
-    quint32 bitCounter = 0;
+    quint64 bitCounter = 0;
     float minV[4], maxV[4];
     int   tmpV[4];
     float ftmp;
@@ -519,6 +549,9 @@ void CNormalizator::calibrate()
     maxV[0] = maxV[1] = maxV[2] = maxV[3] = -MAX_FLOAT;
     minV[0] = minV[1] = minV[2] = minV[3] = MAX_FLOAT;
 
+    if(progressPtr)
+        progressPtr->begin(PROGRESS_PRE_PARSING, width);
+
     for(iw = 0; iw < width; iw++)
     {
         for(ih = 0; ih < height; ih++)
@@ -538,7 +571,10 @@ void CNormalizator::calibrate()
             bitCounter += columnStride;
         }
         bitCounter += rowStride;
-        (reinterpret_cast<CImgContext*>(myParentPtr))->auxInfo = "Pre-parsing: " + QString::number((ulong)iw*100/width) + "%";
+        if(cancelToken.isCancelled())
+            return;
+        if(progressPtr)
+            progressPtr->advance(iw + 1);
     }
 
 
@@ -551,7 +587,7 @@ void CNormalizator::calibrate()
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-inline QRgb CNormalizator::normSinglePixel(quint32 &bitCounter)
+inline QRgb CNormalizator::normSinglePixel(quint64 &bitCounter)
 {
     quint32 channelBits[] = {0,0,0,0};
     quint32 fragBitsCount;
@@ -567,13 +603,13 @@ inline QRgb CNormalizator::normSinglePixel(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myREDBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myREDBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myREDBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[0] |= (ltmp << fragBitsCount);
-        fragBitsCount += myREDBitsIndices[ib].bitsCount;
+        fragBitsCount += myREDBitsIndices.at(ib).bitsCount;
     }
 
     switch(mType[0])
@@ -605,13 +641,13 @@ inline QRgb CNormalizator::normSinglePixel(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myGREENBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myGREENBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myGREENBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[1] |= (ltmp << fragBitsCount);
-        fragBitsCount += myGREENBitsIndices[ib].bitsCount;
+        fragBitsCount += myGREENBitsIndices.at(ib).bitsCount;
     }
     switch(mType[1])
     {
@@ -642,13 +678,13 @@ inline QRgb CNormalizator::normSinglePixel(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myBLUEBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myBLUEBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myBLUEBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[2] |= (ltmp << fragBitsCount);
-        fragBitsCount += myBLUEBitsIndices[ib].bitsCount;
+        fragBitsCount += myBLUEBitsIndices.at(ib).bitsCount;
     }
     switch(mType[2])
     {
@@ -679,13 +715,13 @@ inline QRgb CNormalizator::normSinglePixel(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myALPHABitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myALPHABitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myALPHABitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[3] |= (ltmp << fragBitsCount);
-        fragBitsCount += myALPHABitsIndices[ib].bitsCount;
+        fragBitsCount += myALPHABitsIndices.at(ib).bitsCount;
     }
     switch(mType[3])
     {
@@ -715,7 +751,7 @@ inline QRgb CNormalizator::normSinglePixel(quint32 &bitCounter)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-inline QRgb CNormalizator::normSinglePixelWithFiltering(quint32 &bitCounter)
+inline QRgb CNormalizator::normSinglePixelWithFiltering(quint64 &bitCounter)
 {
     quint32 channelBits[] = {0,0,0,0};
     quint32 fragBitsCount;
@@ -729,13 +765,13 @@ inline QRgb CNormalizator::normSinglePixelWithFiltering(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myREDBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myREDBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myREDBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[0] |= (ltmp << fragBitsCount);
-        fragBitsCount += myREDBitsIndices[ib].bitsCount;
+        fragBitsCount += myREDBitsIndices.at(ib).bitsCount;
     }
 
     switch(mType[0])
@@ -767,13 +803,13 @@ inline QRgb CNormalizator::normSinglePixelWithFiltering(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myGREENBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myGREENBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myGREENBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[1] |= (ltmp << fragBitsCount);
-        fragBitsCount += myGREENBitsIndices[ib].bitsCount;
+        fragBitsCount += myGREENBitsIndices.at(ib).bitsCount;
     }
     switch(mType[1])
     {
@@ -804,13 +840,13 @@ inline QRgb CNormalizator::normSinglePixelWithFiltering(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myBLUEBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myBLUEBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myBLUEBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[2] |= (ltmp << fragBitsCount);
-        fragBitsCount += myBLUEBitsIndices[ib].bitsCount;
+        fragBitsCount += myBLUEBitsIndices.at(ib).bitsCount;
     }
     switch(mType[2])
     {
@@ -841,13 +877,13 @@ inline QRgb CNormalizator::normSinglePixelWithFiltering(quint32 &bitCounter)
     fragBitsCount = 0;
     for(ib=0; ib < myALPHABitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myALPHABitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myALPHABitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[3] |= (ltmp << fragBitsCount);
-        fragBitsCount += myALPHABitsIndices[ib].bitsCount;
+        fragBitsCount += myALPHABitsIndices.at(ib).bitsCount;
     }
     switch(mType[3])
     {
@@ -886,7 +922,7 @@ QString CNormalizator::getPixelValueStr(qint32 iw, qint32 ih, int dispBase)
     quint64 ltmp;
     unsigned int fragBase;
     unsigned int fragOffset;
-    quint32  bitCounter = columnStride*iw + (rowStride + columnStride*width)*ih;
+    quint64  bitCounter = (quint64)columnStride*iw + ((quint64)rowStride + (quint64)columnStride*width)*ih;
     QString pixelValueStr;
     QString prefixStr;
 
@@ -903,13 +939,13 @@ QString CNormalizator::getPixelValueStr(qint32 iw, qint32 ih, int dispBase)
     fragBitsCount = 0;
     for(ib=0; ib < myREDBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myREDBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myREDBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[0] |= (ltmp << fragBitsCount);
-        fragBitsCount += myREDBitsIndices[ib].bitsCount;
+        fragBitsCount += myREDBitsIndices.at(ib).bitsCount;
     }
 
     switch(mType[0])
@@ -941,13 +977,13 @@ QString CNormalizator::getPixelValueStr(qint32 iw, qint32 ih, int dispBase)
     fragBitsCount = 0;
     for(ib=0; ib < myGREENBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myGREENBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myGREENBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[1] |= (ltmp << fragBitsCount);
-        fragBitsCount += myGREENBitsIndices[ib].bitsCount;
+        fragBitsCount += myGREENBitsIndices.at(ib).bitsCount;
     }
     switch(mType[1])
     {
@@ -978,13 +1014,13 @@ QString CNormalizator::getPixelValueStr(qint32 iw, qint32 ih, int dispBase)
     fragBitsCount = 0;
     for(ib=0; ib < myBLUEBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myBLUEBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myBLUEBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[2] |= (ltmp << fragBitsCount);
-        fragBitsCount += myBLUEBitsIndices[ib].bitsCount;
+        fragBitsCount += myBLUEBitsIndices.at(ib).bitsCount;
     }
     switch(mType[2])
     {
@@ -1015,13 +1051,13 @@ QString CNormalizator::getPixelValueStr(qint32 iw, qint32 ih, int dispBase)
     fragBitsCount = 0;
     for(ib=0; ib < myALPHABitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myALPHABitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myALPHABitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[3] |= (ltmp << fragBitsCount);
-        fragBitsCount += myALPHABitsIndices[ib].bitsCount;
+        fragBitsCount += myALPHABitsIndices.at(ib).bitsCount;
     }
     switch(mType[3])
     {
@@ -1051,7 +1087,7 @@ QString CNormalizator::getPixelValueStr(qint32 iw, qint32 ih, int dispBase)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-inline void CNormalizator::getPixelValue(quint32 &bitCounter, float* pixelValue)
+void CNormalizator::getPixelValue(quint64 &bitCounter, float* pixelValue) const
 {
     quint32 channelBits[] = {0,0,0,0};
     quint32 fragBitsCount;
@@ -1065,13 +1101,13 @@ inline void CNormalizator::getPixelValue(quint32 &bitCounter, float* pixelValue)
     fragBitsCount = 0;
     for(ib=0; ib < myREDBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myREDBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myREDBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myREDBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[0] |= (ltmp << fragBitsCount);
-        fragBitsCount += myREDBitsIndices[ib].bitsCount;
+        fragBitsCount += myREDBitsIndices.at(ib).bitsCount;
     }
 
     switch(mType[0])
@@ -1103,13 +1139,13 @@ inline void CNormalizator::getPixelValue(quint32 &bitCounter, float* pixelValue)
     fragBitsCount = 0;
     for(ib=0; ib < myGREENBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myGREENBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myGREENBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myGREENBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[1] |= (ltmp << fragBitsCount);
-        fragBitsCount += myGREENBitsIndices[ib].bitsCount;
+        fragBitsCount += myGREENBitsIndices.at(ib).bitsCount;
     }
     switch(mType[1])
     {
@@ -1140,13 +1176,13 @@ inline void CNormalizator::getPixelValue(quint32 &bitCounter, float* pixelValue)
     fragBitsCount = 0;
     for(ib=0; ib < myBLUEBitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myBLUEBitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myBLUEBitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myBLUEBitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[2] |= (ltmp << fragBitsCount);
-        fragBitsCount += myBLUEBitsIndices[ib].bitsCount;
+        fragBitsCount += myBLUEBitsIndices.at(ib).bitsCount;
     }
     switch(mType[2])
     {
@@ -1177,13 +1213,13 @@ inline void CNormalizator::getPixelValue(quint32 &bitCounter, float* pixelValue)
     fragBitsCount = 0;
     for(ib=0; ib < myALPHABitsIndices.count(); ib++)
     {
-        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)/64);
-        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices[ib].bitIndex)%64);
-        ltmp = MASK(fragOffset, myALPHABitsIndices[ib].bitsCount);
+        fragBase = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)/64);
+        fragOffset = (unsigned int)((bitCounter+myALPHABitsIndices.at(ib).bitIndex)%64);
+        ltmp = MASK(fragOffset, myALPHABitsIndices.at(ib).bitsCount);
         ltmp &= *(quint64*)(framePtr + fragBase);
         ltmp >>= fragOffset;
         channelBits[3] |= (ltmp << fragBitsCount);
-        fragBitsCount += myALPHABitsIndices[ib].bitsCount;
+        fragBitsCount += myALPHABitsIndices.at(ib).bitsCount;
     }
     switch(mType[3])
     {
@@ -1211,49 +1247,85 @@ inline void CNormalizator::getPixelValue(quint32 &bitCounter, float* pixelValue)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-QImage CNormalizator::getImage()
+CTiledImage CNormalizator::getImage()
 {
-    quint32 iw, ih;
-    quint32 bitCounter = 0;
+    quint32 iw, ih, iwEnd, tileBase;
+    quint64 bitCounter = 0;
+    QRgb*   line;
+    QRgb    alphaFill = (channelAbsCapacity[3]>0)?0x00000000:0xFF000000;
 
     adjustCapacity();
 
-    QImage resImage(width, height, (channelAbsCapacity[3]>0)?QImage::Format_ARGB32:QImage::Format_RGB32);
+    CTiledImage resImage(width, height, (channelAbsCapacity[3]>0)?QImage::Format_ARGB32:QImage::Format_RGB32);
+    if(resImage.isNull())
+        return resImage;
+
+    if(progressPtr)
+        progressPtr->begin(PROGRESS_PARSING, height);
 
+    //Row by row through the native data, one tile row segment at a time.
     for(ih = 0; ih < height; ih++)
     {
-        for(iw = 0; iw < width; iw++)
+        for(iw = 0; iw < width; iw = iwEnd)
         {
-            resImage.setPixel(iw, ih, normSinglePixel(bitCounter));
-            bitCounter += columnStride;
+            tileBase = (iw/IMG_TILE_SIZE)*IMG_TILE_SIZE;
+            iwEnd = min(width, tileBase + IMG_TILE_SIZE);
+            line = (QRgb*)resImage.tileRef(iw/IMG_TILE_SIZE, ih/IMG_TILE_SIZE).scanLine(ih%IMG_TILE_SIZE);
+            for(; iw < iwEnd; iw++)
+            {
+                line[iw - tileBase] = normSinglePixel(bitCounter)|alphaFill;
+                bitCounter += columnStride;
+            }
         }
         bitCounter += rowStride;
+        if(cancelToken.isCancelled())
+            return CTiledImage();
+        if(preemptible && ((ih + 1)%IMG_TILE_SIZE == 0))
+            CWorkPool::yieldToFocus();
         //progress update by ih coordinate
-        (reinterpret_cast<CImgContext*>(myParentPtr))->auxInfo = "Parsing: " + QString::number((ulong)ih*100/height) + "%";
+        if(progressPtr)
+            progressPtr->advance(ih + 1);
     }
   return resImage;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-QImage CNormalizator::getImageWithFiltering()
+CTiledImage CNormalizator::getImageWithFiltering()
 {
-    quint32 iw, ih;
-    quint32 bitCounter = 0;
+    quint32 iw, ih, iwEnd, tileBase;
+    quint64 bitCounter = 0;
+    QRgb*   line;
 
     adjustCapacity();
 
-    QImage resImage(width, height, QImage::Format_ARGB32);
+    CTiledImage resImage(width, height, QImage::Format_ARGB32);
+    if(resImage.isNull())
+        return resImage;
+
+    if(progressPtr)
+        progressPtr->begin(PROGRESS_FILTERING, height);
 
     for(ih = 0; ih < height; ih++)
     {
-        for(iw = 0; iw < width; iw++)
+        for(iw = 0; iw < width; iw = iwEnd)
         {
-            resImage.setPixel(iw, ih,normSinglePixelWithFiltering(bitCounter));
-            bitCounter += columnStride;
+            tileBase = (iw/IMG_TILE_SIZE)*IMG_TILE_SIZE;
+            iwEnd = min(width, tileBase + IMG_TILE_SIZE);
+            line = (QRgb*)resImage.tileRef(iw/IMG_TILE_SIZE, ih/IMG_TILE_SIZE).scanLine(ih%IMG_TILE_SIZE);
+            for(; iw < iwEnd; iw++)
+            {
+                line[iw - tileBase] = normSinglePixelWithFiltering(bitCounter);
+                bitCounter += columnStride;
+            }
         }
         bitCounter += rowStride;
+        if(cancelToken.isCancelled())
+            return CTiledImage();
+        if(preemptible && ((ih + 1)%IMG_TILE_SIZE == 0))
+            CWorkPool::yieldToFocus();
         //progress update by ih coordinate
-        (reinterpret_cast<CImgContext*>(myParentPtr))->auxInfo = "Filtering: " + QString::number((ulong)ih*100/height) + "%";
+        if(progressPtr)
+            progressPtr->advance(ih + 1);
     }
   return resImage;
 }
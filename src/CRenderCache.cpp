@@ -0,0 +1,205 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CRenderCache.h"
+#include "./inc/CImgContext.h"
+#include "./inc/defines.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <QPainter>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//The counters are updated by the entries, they are defined (and destroyed) around the cache.
+QMutex                           CRenderCache::cacheLock(QMutex::NonRecursive);
+QHash<quint32, quint64>          CRenderCache::bytesByImage;
+quint64                          CRenderCache::totalBytes = 0;
+QCache<dRenderTileKey, CRenderCache::CEntry> CRenderCache::tiles(RENDER_CACHE_MAX_MB*1024);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CRenderCache::CEntry::CEntry(quint32 imageID, const QPixmap &tile)
+{
+    this->imageID = imageID;
+    pixmap = tile;
+    bytes = (quint64)tile.width()*tile.height()*tile.depth()/8;
+
+    bytesByImage[imageID] += bytes;
+    totalBytes += bytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CRenderCache::CEntry::~CEntry()
+{
+    //Dropped by the cache, the cache lock is held.
+    bytesByImage[imageID] -= qMin(bytesByImage[imageID], bytes);
+    if(bytesByImage[imageID] == 0)
+        bytesByImage.remove(imageID);
+    totalBytes -= qMin(totalBytes, bytes);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QPixmap CRenderCache::lookup(const dRenderTileKey &key)
+{
+    QMutexLocker lock(&cacheLock);
+    CEntry      *entry = tiles.object(key);
+
+    return entry?entry->pixmap:QPixmap();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CRenderCache::store(const dRenderTileKey &key, const QPixmap &tile)
+{
+    QMutexLocker lock(&cacheLock);
+    CEntry      *entry;
+
+    //Images not registered (yet) share ID zero, their tiles are not kept.
+    if((key.imageID == 0)||(tile.isNull()))
+        return;
+
+    entry = new CEntry(key.imageID, tile);
+    tiles.insert(key, entry, max(1, (int)(entry->bytes >> 10)));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QRect CRenderCache::getTileRect(CImgContext *imgContextPtr, float zoomFactor, qint32 col, qint32 row)
+{
+    QRect zoomedImage(0, 0, (qint32)ceil(imgContextPtr->getIWidth()*zoomFactor), (qint32)ceil(imgContextPtr->getIHeight()*zoomFactor));
+
+    return QRect(col*RENDER_TILE_SIZE, row*RENDER_TILE_SIZE, RENDER_TILE_SIZE, RENDER_TILE_SIZE).intersected(zoomedImage);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QPixmap CRenderCache::getLevelTile(CImgContext *imgContextPtr, qint32 level, qint32 col, qint32 row)
+{
+    dRenderTileKey key = {imgContextPtr->getMyID(), 0, level, col, row};
+    QPixmap        tile = lookup(key);
+
+    if(!tile.isNull())
+        return tile;
+
+    //Made without the cache lock, the image context takes its own.
+    tile = imgContextPtr->makeRenderTile(level, col, row);
+    store(key, tile);
+    return tile;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QPixmap CRenderCache::getTile(CImgContext *imgContextPtr, float zoomFactor, qint32 col, qint32 row)
+{
+    dRenderTileKey key = {imgContextPtr->getMyID(), 0, 0, col, row};
+    QPixmap        tile;
+    QRect          zoomedRect, sourceRect, levelRect, part;
+    QPixmap        levelTile;
+    qint32         level, span;
+    qreal          tx, ty;
+    bool           complete = true;
+
+    memcpy(&key.zoomKey, &zoomFactor, sizeof(key.zoomKey));
+    level = CImgContext::getRenderLevel(zoomFactor);
+    key.level = level;
+
+    tile = lookup(key);
+    if(!tile.isNull())
+        return tile;
+
+    zoomedRect = getTileRect(imgContextPtr, zoomFactor, col, row);
+    if((zoomedRect.isEmpty())||(!imgContextPtr->isRenderable()))
+        return tile;
+
+    //Image pixels under the tile.
+    sourceRect.setCoords((qint32)floor(zoomedRect.left()/zoomFactor),
+                         (qint32)floor(zoomedRect.top()/zoomFactor),
+                         (qint32)ceil((zoomedRect.right() + 1)/zoomFactor) - 1,
+                         (qint32)ceil((zoomedRect.bottom() + 1)/zoomFactor) - 1);
+    sourceRect = sourceRect.intersected(QRect(0, 0, imgContextPtr->getIWidth(), imgContextPtr->getIHeight()));
+    if(sourceRect.isEmpty())
+        return tile;
+
+    tile = QPixmap(zoomedRect.size());
+    tile.fill(Qt::transparent);
+
+    QPainter painter(&tile);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    span = IMG_TILE_SIZE << level;
+    for(qint32 levelRow = sourceRect.top()/span; levelRow <= sourceRect.bottom()/span; levelRow++)
+        for(qint32 levelCol = sourceRect.left()/span; levelCol <= sourceRect.right()/span; levelCol++)
+        {
+            levelRect = imgContextPtr->getRenderTileRect(level, levelCol, levelRow);
+            part = levelRect.intersected(sourceRect);
+            if(part.isEmpty())
+                continue;
+
+            levelTile = getLevelTile(imgContextPtr, level, levelCol, levelRow);
+            if(levelTile.isNull())
+            {
+                complete = false;
+                continue;
+            }
+
+            tx = (qreal)levelTile.width()/levelRect.width();
+            ty = (qreal)levelTile.height()/levelRect.height();
+            painter.drawPixmap(QRectF(part.x()*zoomFactor - zoomedRect.x(), part.y()*zoomFactor - zoomedRect.y(),
+                                      part.width()*zoomFactor, part.height()*zoomFactor),
+                               levelTile,
+                               QRectF((part.x() - levelRect.x())*tx, (part.y() - levelRect.y())*ty,
+                                      part.width()*tx, part.height()*ty));
+        }
+    painter.end();
+
+    if(complete)
+        store(key, tile);
+    return tile;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CRenderCache::drop(quint32 imageID)
+{
+    QMutexLocker          lock(&cacheLock);
+    QList<dRenderTileKey> keys;
+
+    if(!bytesByImage.contains(imageID))
+        return;
+
+    keys = tiles.keys();
+    for(int i = 0; i < keys.size(); i++)
+        if(keys.at(i).imageID == imageID)
+            tiles.remove(keys.at(i));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CRenderCache::getImageBytes(quint32 imageID)
+{
+    QMutexLocker lock(&cacheLock);
+    return bytesByImage.value(imageID);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CRenderCache::getTotalBytes()
+{
+    QMutexLocker lock(&cacheLock);
+    return totalBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CRenderCache::clear()
+{
+    QMutexLocker lock(&cacheLock);
+    tiles.clear();
+}
@@ -0,0 +1,279 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CSession.h"
+#include "./inc/CSpillStore.h"
+#include "./inc/CBufferPool.h"
+#include "./inc/CWorkPool.h"
+#include "./inc/Threads.h"
+#include "./inc/globals.h"
+#include "./inc/commons.h"
+
+#include <QFile>
+#include <QBuffer>
+#include <QRunnable>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CSessionDecodeTask class.
+ *        Decodes a single RIC container of the mapped session file into a listed context.
+ */
+
+class CSessionDecodeTask : public QRunnable
+{
+public:
+    CSessionDecodeTask(const QSharedPointer<CImgContext> &imgContextPtr, const uchar *payloadPtr, quint32 payloadSize)
+    {
+        this->imgContextPtr = imgContextPtr;
+        this->payloadPtr = payloadPtr;
+        this->payloadSize = payloadSize;
+    }
+
+    void run()
+    {
+        //CNativeData takes ownership of the buffer, the mapping goes away after the restore.
+        char* inBuff = CBufferPool::acquire(payloadSize);
+
+        if(inBuff)
+        {
+            memcpy(inBuff, payloadPtr, payloadSize);
+
+            imgContextPtr->lockDataForWrite(-1);
+            CWorker_loadFromNativeData lnd(0, inBuff, payloadSize);
+            lnd.setTargetContext(imgContextPtr);
+            lnd.blockSignals(true);
+            lnd.process();
+            imgContextPtr->unlockData();
+        }
+
+        if(imgContextPtr->getMyState() == STATE_BUSY)
+        {
+            imgContextPtr->setMyState(STATE_BAD);
+            Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, imgContextPtr);
+        }
+        imgContextPtr->dropSnapshotThumbnail();
+    }
+
+private:
+    QSharedPointer<CImgContext> imgContextPtr;
+    const uchar                *payloadPtr;
+    quint32                     payloadSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#define WRITE_OR_FAIL(what, how_big)\
+    if(how_big != ofile.write((const char*)what, how_big))\
+       goto __EXIT_WITH_ERROR;
+
+int CSession::save(const QString &fileName)
+{
+    QList<QSharedPointer<CImgContext> > listed, images;
+    QSharedPointer<CImgContext>         next;
+    QFile                               ofile(fileName + ".tmp");
+    dSessionHeader                      header;
+    dSessionRecord                      record;
+    QByteArray                          thumbnail;
+    QByteArray                          spilledPayload;
+    qint64                              recordPos, payloadPos;
+    int                                 res;
+
+    //Take a snapshot of the list.
+    listed = Globals::imgRegistry.snapshot();
+    for(int i = 0; i < listed.size(); i++)
+    {
+        next = listed.at(i);
+        if(((next->getMyState() == STATE_READY)||(next->getMyState() == STATE_BAD))&&
+           ((next->imgSource == SOURCE_FILE)||(!next->nativeDataPtr.isNull())))
+            images.append(next);
+        else if(next->getMyState() == STATE_SPILLED)
+            images.append(next);
+    }
+
+    if(!ofile.open(QIODevice::WriteOnly))
+        return RES_ERROR;
+
+    header.version = SESSION_VERSION;
+    header.imageCount = 0;
+    WRITE_OR_FAIL(SESSION_MAGIC, MAGIC_CHARS_SIZE);
+    WRITE_OR_FAIL(&header, sizeof(dSessionHeader));
+
+    for(int i = 0; i < images.size(); i++)
+    {
+        thumbnail.clear();
+        {
+            QBuffer thumbnailBuffer(&thumbnail);
+            thumbnailBuffer.open(QIODevice::WriteOnly);
+            images.at(i)->getThumbnailImage().save(&thumbnailBuffer, "PNG");
+        }
+
+        memset(&record, 0, sizeof(dSessionRecord));
+        record.thumbnailSize = thumbnail.size();
+        record.viewFlags     = images.at(i)->getFlags();
+        record.zoomFactor    = images.at(i)->getZoomFactor();
+        record.imgOffset[0]  = images.at(i)->getImgOffset(axX);
+        record.imgOffset[1]  = images.at(i)->getImgOffset(axY);
+        for(int c = 0; c < 3; c++)
+        {
+            record.vmul[c]  = images.at(i)->getMul((channel)c);
+            record.vdiv[c]  = images.at(i)->getDiv((channel)c);
+            record.vbias[c] = images.at(i)->getBias((channel)c);
+        }
+
+        recordPos = ofile.pos();
+        WRITE_OR_FAIL(&record, sizeof(dSessionRecord));
+        WRITE_OR_FAIL(thumbnail.constData(), thumbnail.size());
+
+        payloadPos = ofile.pos();
+
+        //Shared access, the image may have been spilled or faulted in since the snapshot.
+        images.at(i)->lockDataForRead(-1);
+        if(images.at(i)->getMyState() == STATE_SPILLED)
+        {
+            //Copied as it is from the spill file.
+            spilledPayload.resize(images.at(i)->spillSize);
+            res = CSpillStore::readPayload(images.at(i), spilledPayload.data());
+            if((res == RES_OK)&&(ofile.write(spilledPayload.constData(), spilledPayload.size()) != spilledPayload.size()))
+                res = RES_ERROR;
+            spilledPayload.clear();
+        }
+        else
+            res = images.at(i)->writeRIC(ofile);
+        images.at(i)->unlockData();
+
+        if(res != RES_OK)
+            goto __EXIT_WITH_ERROR;
+
+        //Patch the payload size now that it is known.
+        record.payloadSize = ofile.pos() - payloadPos;
+        ofile.seek(recordPos);
+        WRITE_OR_FAIL(&record, sizeof(dSessionRecord));
+        ofile.seek(ofile.size());
+
+        header.imageCount++;
+    }
+
+    ofile.seek(MAGIC_CHARS_SIZE);
+    WRITE_OR_FAIL(&header, sizeof(dSessionHeader));
+    ofile.close();
+
+    QFile::remove(fileName);
+    if(!QFile::rename(fileName + ".tmp", fileName))
+        return RES_ERROR;
+    return RES_OK;
+
+__EXIT_WITH_ERROR:
+    ofile.close();
+    QFile::remove(fileName + ".tmp");
+    return RES_ERROR;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CSession::restore(const QString &fileName)
+{
+    QFile                               ifile(fileName);
+    QByteArray                          fallbackData;
+    const uchar                        *basePtr;
+    qint64                              fileSize, cursor;
+    dSessionHeader                      header;
+    dSessionRecord                      record;
+    dHeader                             ricHeader;
+    QList<QSharedPointer<CImgContext> > contexts;
+    QList<qint64>                       payloadOffsets;
+    QList<quint32>                      payloadSizes;
+    QSharedPointer<CImgContext>         newImgContextPtr;
+    CTaskGroup                          group;
+
+    if(!ifile.open(QIODevice::ReadOnly))
+        return RES_ERROR;
+
+    fileSize = ifile.size();
+    basePtr = ifile.map(0, fileSize);
+    if(!basePtr)
+    {
+        fallbackData = ifile.readAll();
+        basePtr = (const uchar*)fallbackData.constData();
+    }
+
+    if((fileSize < qint64(MAGIC_CHARS_SIZE + sizeof(dSessionHeader)))||
+       (memcmp(basePtr, SESSION_MAGIC, MAGIC_CHARS_SIZE) != 0))
+        return RES_ERROR;
+
+    memcpy(&header, basePtr + MAGIC_CHARS_SIZE, sizeof(dSessionHeader));
+    if(header.version != SESSION_VERSION)
+        return RES_ERROR;
+
+    //First pass: list every image with its stored thumbnail and view state.
+    cursor = MAGIC_CHARS_SIZE + sizeof(dSessionHeader);
+    for(quint32 i = 0; i < header.imageCount; i++)
+    {
+        if(cursor + qint64(sizeof(dSessionRecord)) > fileSize)
+            break;
+        memcpy(&record, basePtr + cursor, sizeof(dSessionRecord));
+        cursor += sizeof(dSessionRecord);
+
+        if((cursor + record.thumbnailSize + record.payloadSize > fileSize)||
+           (record.payloadSize < MAGIC_CHARS_SIZE + sizeof(dHeader)))
+            break;
+
+        newImgContextPtr = QSharedPointer<CImgContext>(new CImgContext());
+        newImgContextPtr->snapshotThumbnail.loadFromData(basePtr + cursor, record.thumbnailSize, "PNG");
+        cursor += record.thumbnailSize;
+
+        memcpy(&ricHeader, basePtr + cursor + MAGIC_CHARS_SIZE, sizeof(dHeader));
+        if((ricHeader.nameLength <= MAX_IMG_NAME_LENGTH)&&
+           (MAGIC_CHARS_SIZE + sizeof(dHeader) + ricHeader.formatStrLength + ricHeader.nameLength <= record.payloadSize))
+        {
+            newImgContextPtr->setMyName(QString::fromLatin1((const char*)basePtr + cursor + MAGIC_CHARS_SIZE + sizeof(dHeader) + ricHeader.formatStrLength,
+                                                            ricHeader.nameLength));
+        }
+
+        newImgContextPtr->setFlags(record.viewFlags);
+        newImgContextPtr->setZoomFactor(record.zoomFactor);
+        newImgContextPtr->setImgOffset(axX, record.imgOffset[0]);
+        newImgContextPtr->setImgOffset(axY, record.imgOffset[1]);
+        for(int c = 0; c < 3; c++)
+        {
+            newImgContextPtr->setMul((channel)c, record.vmul[c]);
+            newImgContextPtr->setDiv((channel)c, record.vdiv[c]);
+            newImgContextPtr->setBias((channel)c, record.vbias[c]);
+        }
+
+        contexts.append(newImgContextPtr);
+        payloadOffsets.append(cursor);
+        payloadSizes.append(record.payloadSize);
+        cursor += record.payloadSize;
+    }
+
+    //The list head is the newest image, so add the oldest one first.
+    for(int i = contexts.size() - 1; i >= 0; i--)
+    {
+        Globals::addImage(contexts.at(i));
+        Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, contexts.at(i));
+    }
+    showStatusMessage("Session: " + QString::number(contexts.size()) + " image(s) listed, decoding...", UI_STATUS_INFO, true);
+
+    //Second pass: decode the data.
+    for(int i = 0; i < contexts.size(); i++)
+        group.run(new CSessionDecodeTask(contexts.at(i), basePtr + payloadOffsets.at(i), payloadSizes.at(i)));
+    group.wait();
+
+    ifile.close();
+    showStatusMessage("Session has been restored.", UI_STATUS_INFO, true);
+    return RES_OK;
+}
@@ -0,0 +1,220 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CSpillStore.h"
+#include "./inc/Threads.h"
+#include "./inc/globals.h"
+#include "./inc/commons.h"
+
+#include <QDir>
+#include <QCoreApplication>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex      CSpillStore::storeLock(QMutex::NonRecursive);
+QFile       CSpillStore::spillFile;
+quint64     CSpillStore::liveBytes = 0;
+QMap<qint64, quint64> CSpillStore::holes;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CSpillStore::openFile()
+{
+    QString dirName = Globals::spillDirectory.isEmpty()?QDir::tempPath():Globals::spillDirectory;
+
+    if(spillFile.isOpen())
+        return RES_OK;
+
+    spillFile.setFileName(QDir(dirName).filePath(QString(SPILL_FILE_PREFIX) + QString::number(QCoreApplication::applicationPid()) + ".bin"));
+    if(!spillFile.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return RES_ERROR;
+
+    liveBytes = 0;
+    holes.clear();
+    return RES_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CSpillStore::spill(const QSharedPointer<CImgContext> &imgContextPtr)
+{
+    QMutexLocker                      lock(&storeLock);
+    dRICSnapshot                      snapshot;
+    quint64                           size, holeSize = 0;
+    qint64                            offset = -1;
+    QMap<qint64, quint64>::iterator   i;
+
+    if((openFile() != RES_OK)||(imgContextPtr->snapshotRIC(snapshot) != RES_OK))
+        return RES_ERROR;
+
+    //The first hole it fits, or the end of the file.
+    size = CImgContext::getRICSize(snapshot);
+    if(size > 0xFFFFFFFF)
+        return RES_ERROR;
+    for(i = holes.begin(); i != holes.end(); ++i)
+    {
+        if(i.value() >= size)
+        {
+            offset = i.key();
+            holeSize = i.value();
+            holes.erase(i);
+            break;
+        }
+    }
+    if(offset < 0)
+        offset = spillFile.size();
+
+    if((!spillFile.seek(offset))||(CImgContext::writeRIC(spillFile, snapshot) != RES_OK)||(!spillFile.flush()))
+    {
+        if(holeSize)
+            addHole(offset, holeSize);
+        else
+            spillFile.resize(offset);
+        return RES_ERROR;
+    }
+
+    if(holeSize > size)
+        addHole(offset + size, holeSize - size);
+
+    imgContextPtr->spillOffset = offset;
+    imgContextPtr->spillSize = quint32(size);
+    liveBytes += size;
+
+    imgContextPtr->dropSpilledData();
+    return RES_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CSpillStore::claim(const QSharedPointer<CImgContext> &imgContextPtr)
+{
+    QMutexLocker lock(&storeLock);
+
+    if(imgContextPtr->getMyState() != STATE_SPILLED)
+        return false;
+
+    imgContextPtr->setMyState(STATE_BUSY);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CSpillStore::faultIn(const QSharedPointer<CImgContext> &imgContextPtr)
+{
+    if(!claim(imgContextPtr))
+        return;
+
+    CWorker_faultIn* newWorker = new CWorker_faultIn(imgContextPtr);
+    newWorker->selfStart();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CSpillStore::faultInNow(const QSharedPointer<CImgContext> &imgContextPtr)
+{
+    if(!claim(imgContextPtr))
+        return false;
+
+    CWorker_faultIn worker(imgContextPtr);
+    worker.blockSignals(true);
+    worker.process();
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CSpillStore::readPayload(const QSharedPointer<CImgContext> &imgContextPtr, char *dstPtr)
+{
+    QMutexLocker lock(&storeLock);
+    uchar       *mapPtr;
+
+    if((!spillFile.isOpen())||(imgContextPtr->spillSize == 0))
+        return RES_ERROR;
+
+    mapPtr = spillFile.map(imgContextPtr->spillOffset, imgContextPtr->spillSize);
+    if(mapPtr)
+    {
+        memcpy(dstPtr, mapPtr, imgContextPtr->spillSize);
+        spillFile.unmap(mapPtr);
+        return RES_OK;
+    }
+
+    //No mapping available, read it.
+    if(!spillFile.seek(imgContextPtr->spillOffset))
+        return RES_ERROR;
+    if(spillFile.read(dstPtr, imgContextPtr->spillSize) != qint64(imgContextPtr->spillSize))
+        return RES_ERROR;
+    return RES_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CSpillStore::release(const QSharedPointer<CImgContext> &imgContextPtr)
+{
+    QMutexLocker lock(&storeLock);
+
+    if(imgContextPtr->spillSize == 0)
+        return;
+
+    liveBytes -= qMin(liveBytes, (quint64)imgContextPtr->spillSize);
+    if(spillFile.isOpen())
+        addHole(imgContextPtr->spillOffset, imgContextPtr->spillSize);
+    imgContextPtr->spillSize = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CSpillStore::addHole(qint64 offset, quint64 size)
+{
+    QMap<qint64, quint64>::iterator next = holes.lowerBound(offset);
+
+    if(next != holes.end() && (offset + qint64(size) == next.key()))
+    {
+        size += next.value();
+        next = holes.erase(next);
+    }
+    if(next != holes.begin())
+    {
+        QMap<qint64, quint64>::iterator previous = next - 1;
+        if(previous.key() + qint64(previous.value()) == offset)
+        {
+            offset = previous.key();
+            size += previous.value();
+            holes.erase(previous);
+        }
+    }
+
+    //The tail of the file is given back.
+    if(offset + qint64(size) >= spillFile.size())
+        spillFile.resize(offset);
+    else
+        holes.insert(offset, size);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CSpillStore::clear()
+{
+    QMutexLocker lock(&storeLock);
+
+    if(spillFile.isOpen())
+    {
+        spillFile.close();
+        spillFile.remove();
+    }
+    liveBytes = 0;
+    holes.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CSpillStore::getLiveBytes()
+{
+    QMutexLocker lock(&storeLock);
+    return liveBytes;
+}
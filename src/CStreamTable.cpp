@@ -0,0 +1,97 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CStreamTable.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex                                 CStreamTable::tableLock(QMutex::NonRecursive);
+QHash<QString, CStreamTable::dStream>  CStreamTable::streams;
+quint64                                CStreamTable::lastTicket = 0;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CStreamTable::admit(const QString &name)
+{
+    QMutexLocker lock(&tableLock);
+
+    if(!streams.contains(name))
+    {
+        dStream newStream;
+        newStream.lastTicket = 0;
+        newStream.publishedTicket = 0;
+        newStream.skipped = 0;
+        streams.insert(name, newStream);
+    }
+
+    //Tickets are global, so a stream removed and received again never reuses one.
+    streams[name].lastTicket = ++lastTicket;
+    return lastTicket;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CStreamTable::isSuperseded(const QString &name, quint64 ticket)
+{
+    QMutexLocker lock(&tableLock);
+
+    if(!streams.contains(name))
+        return false;
+    return streams.value(name).lastTicket > ticket;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CStreamTable::publish(const QString &name, quint64 ticket)
+{
+    QMutexLocker lock(&tableLock);
+
+    //A stream forgotten meanwhile (remove all) is not listed any more, nothing is newer.
+    if(!streams.contains(name))
+        return true;
+    if(streams.value(name).publishedTicket > ticket)
+        return false;
+
+    streams[name].publishedTicket = ticket;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CStreamTable::addSkipped(const QString &name)
+{
+    QMutexLocker lock(&tableLock);
+
+    if(streams.contains(name))
+        streams[name].skipped++;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint32 CStreamTable::getSkipped(const QString &name)
+{
+    QMutexLocker lock(&tableLock);
+
+    if(!streams.contains(name))
+        return 0;
+    return streams.value(name).skipped;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CStreamTable::clear()
+{
+    QMutexLocker lock(&tableLock);
+
+    //Frames still in flight keep their tickets, which stay valid against a fresh table.
+    streams.clear();
+}
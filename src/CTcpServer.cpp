@@ -21,6 +21,7 @@
 #include "./inc/defines.h"
 #include "./inc/globals.h"
 #include "./inc/aidMainWindow.h"
+#include "./inc/CDecodePipeline.h"
 
 #include <QString>
 #include <iostream>
@@ -70,7 +71,8 @@ void CSocketService::finishRead()
     dataReceived(false);
 
     newWorker = new CWorker_loadFromNativeData(this, inBuff.getDataPtr(), inBuff.getCursor());
-    newWorker->selfStart();
+    inBuff.takeDataPtr();
+    CDecodePipeline::submit(newWorker);
 
     goto __EXIT_POINT;
 
@@ -87,11 +89,16 @@ __EXIT_POINT:
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CSocketService::dataReceived(bool dataCache)
 {
-    int preSize;
+    quint64 preSize;
     char* buffPtr;
 
     if(wcounter>0) wcounter = Globals::idleSocketTimeoutInSecs*1000/COM_TIMER_INTERVAL_MS;
 
+    //The decode pipeline is full: the data is left in the socket, which holds the producer back.
+    //The timer reads it later (see poolClientState); the final read cannot wait.
+    if(dataCache && CDecodePipeline::isSaturated())
+        return;
+
     if(inBuff.getCursor() + mySocketPtr->bytesAvailable() > COM_MAX_DATA_SIZE)
     {
         goto __EXIT_WITH_OVERFLOW;
@@ -110,7 +117,7 @@ void CSocketService::dataReceived(bool dataCache)
         preSize += ((dHeader*)(tmpqa.data()+MAGIC_CHARS_SIZE))->notesLength;
         preSize += ((dHeader*)(tmpqa.data()+MAGIC_CHARS_SIZE))->sizeInBytes;
 
-        if(preSize > COM_MAX_DATA_SIZE)
+        if(preSize > (quint64)COM_MAX_DATA_SIZE)
         {
             goto __EXIT_WITH_OVERFLOW;
         }
@@ -145,6 +152,8 @@ int  CSocketService::poolClientState(bool decrementCounter)
     {
         if(mySocketPtr->state()!=QAbstractSocket::ConnectedState)
             finishRead();
+        else if((wcounter>0)&&(mySocketPtr->bytesAvailable()>=COM_CACHE))
+            dataReceived();
     }
 
 
@@ -244,7 +253,6 @@ void CTcpServer::processClientQueue(bool triggeredByTimer)
 {
     QList<CSocketService*>::iterator i;
 
-    Globals::imgContextListLock.lock();
     i = clientsList.begin();
 
     while (i!= clientsList.end())
@@ -264,7 +272,5 @@ void CTcpServer::processClientQueue(bool triggeredByTimer)
         if(clientsList.size() < COM_MAX_PROCESSING_THREADS)
             acceptConnection();
     }
-
-    Globals::imgContextListLock.unlock();
 }
 
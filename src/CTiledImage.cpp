@@ -0,0 +1,214 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CTiledImage.h"
+
+#include <string.h>
+
+#include <QPainter>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CTiledImage::CTiledImage()
+{
+    imgWidth = imgHeight = 0;
+    imgFormat = QImage::Format_ARGB32;
+    tileCols = tileRows = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CTiledImage::CTiledImage(qint32 width, qint32 height, QImage::Format format)
+{
+    imgWidth = width;
+    imgHeight = height;
+    imgFormat = format;
+    tileCols = (width + IMG_TILE_SIZE - 1)/IMG_TILE_SIZE;
+    tileRows = (height + IMG_TILE_SIZE - 1)/IMG_TILE_SIZE;
+
+    if((width <= 0)||(height <= 0))
+    {
+        imgWidth = imgHeight = 0;
+        tileCols = tileRows = 0;
+        return;
+    }
+
+    tiles.reserve(tileCols*tileRows);
+    for(qint32 row = 0; row < tileRows; row++)
+        for(qint32 col = 0; col < tileCols; col++)
+        {
+            QRect r = tileRect(col, row);
+            tiles.append(QImage(r.width(), r.height(), format));
+
+            //Out of memory, a null image as QImage does.
+            if(tiles.last().isNull())
+            {
+                *this = CTiledImage();
+                return;
+            }
+        }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CTiledImage CTiledImage::fromImage(const QImage &image)
+{
+    CTiledImage ret;
+    QImage      src = image;
+
+    if(src.isNull())
+        return ret;
+    if(src.depth() != 32)
+        src = src.convertToFormat(QImage::Format_ARGB32);
+
+    ret.imgWidth = src.width();
+    ret.imgHeight = src.height();
+    ret.imgFormat = src.format();
+    ret.tileCols = (ret.imgWidth + IMG_TILE_SIZE - 1)/IMG_TILE_SIZE;
+    ret.tileRows = (ret.imgHeight + IMG_TILE_SIZE - 1)/IMG_TILE_SIZE;
+    ret.backing = src;
+
+    ret.tiles.reserve(ret.tileCols*ret.tileRows);
+    for(qint32 row = 0; row < ret.tileRows; row++)
+        for(qint32 col = 0; col < ret.tileCols; col++)
+        {
+            QRect r = ret.tileRect(col, row);
+            ret.tiles.append(QImage(src.constScanLine(r.y()) + r.x()*4, r.width(), r.height(), src.bytesPerLine(), src.format()));
+        }
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QRect CTiledImage::tileRect(qint32 col, qint32 row) const
+{
+    QRect r(col*IMG_TILE_SIZE, row*IMG_TILE_SIZE, IMG_TILE_SIZE, IMG_TILE_SIZE);
+
+    return r.intersected(QRect(0, 0, imgWidth, imgHeight));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QRgb CTiledImage::pixel(qint32 x, qint32 y) const
+{
+    if((x < 0)||(y < 0)||(x >= imgWidth)||(y >= imgHeight))
+        return 0;
+
+    return tile(x/IMG_TILE_SIZE, y/IMG_TILE_SIZE).pixel(x%IMG_TILE_SIZE, y%IMG_TILE_SIZE);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QImage CTiledImage::copy(const QRect &rect) const
+{
+    QRect  r = rect.intersected(QRect(0, 0, imgWidth, imgHeight));
+    QImage ret;
+
+    if(r.isEmpty())
+        return ret;
+
+    ret = QImage(r.width(), r.height(), imgFormat);
+    if(ret.isNull())
+        return ret;
+
+    for(qint32 row = r.top()/IMG_TILE_SIZE; row <= r.bottom()/IMG_TILE_SIZE; row++)
+        for(qint32 col = r.left()/IMG_TILE_SIZE; col <= r.right()/IMG_TILE_SIZE; col++)
+        {
+            QRect         t = tileRect(col, row);
+            QRect         part = t.intersected(r);
+            const QImage &src = tile(col, row);
+
+            for(qint32 y = part.top(); y <= part.bottom(); y++)
+                memcpy(ret.scanLine(y - r.y()) + (part.x() - r.x())*4,
+                       src.constScanLine(y - t.y()) + (part.x() - t.x())*4,
+                       part.width()*4);
+        }
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QImage CTiledImage::scaled(const QRect &rect, const QSize &size) const
+{
+    QRect  r = rect.intersected(QRect(0, 0, imgWidth, imgHeight));
+    QImage ret;
+    qreal  sx, sy;
+
+    if(r.isEmpty()||size.isEmpty())
+        return ret;
+
+    ret = QImage(size, imgFormat);
+    if(ret.isNull())
+        return ret;
+    ret.fill(0);
+
+    sx = (qreal)size.width()/r.width();
+    sy = (qreal)size.height()/r.height();
+
+    QPainter painter(&ret);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for(qint32 row = r.top()/IMG_TILE_SIZE; row <= r.bottom()/IMG_TILE_SIZE; row++)
+        for(qint32 col = r.left()/IMG_TILE_SIZE; col <= r.right()/IMG_TILE_SIZE; col++)
+        {
+            QRect t = tileRect(col, row);
+            QRect part = t.intersected(r);
+
+            painter.drawImage(QRectF((part.x() - r.x())*sx, (part.y() - r.y())*sy, part.width()*sx, part.height()*sy),
+                              tile(col, row),
+                              QRectF(part.x() - t.x(), part.y() - t.y(), part.width(), part.height()));
+        }
+    painter.end();
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QImage CTiledImage::scaled(qint32 width, qint32 height, Qt::AspectRatioMode mode) const
+{
+    if(isNull())
+        return QImage();
+
+    return scaled(QRect(0, 0, imgWidth, imgHeight), QSize(imgWidth, imgHeight).scaled(width, height, mode));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QImage CTiledImage::toImage() const
+{
+    if(!backing.isNull())
+        return backing;
+    if(tiles.size() == 1)
+        return tiles.at(0);
+
+    return copy(QRect(0, 0, imgWidth, imgHeight));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+quint64 CTiledImage::getSizeInBytes() const
+{
+    quint64 bytes = 0;
+
+    if(!backing.isNull())
+        return (quint64)backing.bytesPerLine()*backing.height();
+
+    for(int i = 0; i < tiles.size(); i++)
+        bytes += (quint64)tiles.at(i).bytesPerLine()*tiles.at(i).height();
+    return bytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+const void* CTiledImage::getBlockKey() const
+{
+    if(!backing.isNull())
+        return backing.constBits();
+    if(tiles.isEmpty())
+        return NULL;
+    return tiles.at(0).constBits();
+}
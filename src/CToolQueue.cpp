@@ -0,0 +1,177 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CToolQueue.h"
+#include "./inc/CWorkPool.h"
+#include "./inc/Threads.h"
+#include "./inc/globals.h"
+#include "./inc/commons.h"
+
+#include <QMutexLocker>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CToolTask class.
+ *        Runs a queued tool and lets the next one start.
+ */
+
+class CToolTask : public QRunnable
+{
+public:
+    CToolTask(quint32 id, QRunnable *workerTask)
+    {
+        this->id = id;
+        this->workerTask = workerTask;
+    }
+
+    void run()
+    {
+        workerTask->run();
+        delete workerTask;
+        CToolQueue::jobDone(id);
+    }
+
+private:
+    quint32    id;
+    QRunnable *workerTask;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex                          CToolQueue::queueLock(QMutex::NonRecursive);
+quint32                         CToolQueue::lastId = 0;
+QList<dToolJob>                 CToolQueue::jobs;
+QMap<quint32, QRunnable*>       CToolQueue::pendingTasks;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CToolQueue::submit(CWorker *worker, const QString &description)
+{
+    dToolJob job;
+    int      pending;
+
+    {
+        QMutexLocker lock(&queueLock);
+
+        job.id = ++lastId;
+        job.description = description;
+        job.running = false;
+        job.queuedAt = QDateTime::currentDateTime();
+
+        //The task is made here, a worker is handed over to the GUI thread by its own thread.
+        jobs.append(job);
+        pendingTasks.insert(job.id, worker->makeTask());
+    }
+
+    dispatch();
+
+    {
+        QMutexLocker lock(&queueLock);
+        pending = pendingTasks.contains(job.id)?pendingTasks.size():0;
+    }
+
+    if(pending > 0)
+        showStatusMessage(description + " - queued, " + QString::number(pending) + " tool(s) waiting.", UI_STATUS_INFO, true);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CToolQueue::dispatch()
+{
+    QList<CToolTask*> toStart;
+    int               limit = getLimit();
+    int               running = 0;
+
+    {
+        QMutexLocker lock(&queueLock);
+
+        for(int i = 0; i < jobs.size(); i++)
+        {
+            if(jobs.at(i).running)
+                running++;
+        }
+
+        //Oldest first.
+        for(int i = 0; (i < jobs.size())&&(running < limit); i++)
+        {
+            if(jobs.at(i).running)
+                continue;
+
+            jobs[i].running = true;
+            jobs[i].startedAt = QDateTime::currentDateTime();
+            toStart.append(new CToolTask(jobs.at(i).id, pendingTasks.take(jobs.at(i).id)));
+            running++;
+        }
+    }
+
+    for(int i = 0; i < toStart.size(); i++)
+        CWorkPool::start(toStart.at(i));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CToolQueue::jobDone(quint32 id)
+{
+    {
+        QMutexLocker lock(&queueLock);
+
+        for(int i = 0; i < jobs.size(); i++)
+        {
+            if(jobs.at(i).id == id)
+            {
+                jobs.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    dispatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QList<dToolJob> CToolQueue::snapshot()
+{
+    QMutexLocker lock(&queueLock);
+    return jobs;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CToolQueue::getRunningCount()
+{
+    QMutexLocker lock(&queueLock);
+    int          ret = 0;
+
+    for(int i = 0; i < jobs.size(); i++)
+    {
+        if(jobs.at(i).running)
+            ret++;
+    }
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CToolQueue::getPendingCount()
+{
+    QMutexLocker lock(&queueLock);
+    return pendingTasks.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CToolQueue::getLimit()
+{
+    if(Globals::toolConcurrencyLimit > 0)
+        return Globals::toolConcurrencyLimit;
+    return CWorkPool::getThreadCount();
+}
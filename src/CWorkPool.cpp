@@ -0,0 +1,377 @@
+/*
+    This file is a part of the AID (Another Image Debugger) project.
+
+    Copyright (C) 2013  Olinski Krzysztof E.
+
+    This program is free software: you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3 of the License,
+    or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with this program.
+    If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "./inc/CWorkPool.h"
+#include "./inc/defines.h"
+
+#include <QThread>
+#include <QMutexLocker>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class CWorkPoolThread : public QThread
+{
+public:
+    CWorkPoolThread(int index){this->index = index;}
+
+protected:
+    void run(){CWorkPool::threadLoop(index);}
+
+private:
+    int  index;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QMutex                          CWorkPool::poolLock(QMutex::NonRecursive);
+QWaitCondition                  CWorkPool::taskAvailable;
+QAtomicInt                      CWorkPool::queuedCount(0);
+int                             CWorkPool::sleepingCount = 0;
+bool                            CWorkPool::stopping = false;
+QList<CWorkPool::dPoolTask>     CWorkPool::injected;
+QVector<CWorkPoolThread*>       CWorkPool::threads;
+QVector<CWorkPool::dTaskDeque*> CWorkPool::deques;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::ensureStarted()
+{
+    QMutexLocker lock(&poolLock);
+    int          count;
+
+    if(!threads.isEmpty()||stopping)
+        return;
+
+    count = qMax(QThread::idealThreadCount(), WORK_POOL_MIN_THREADS);
+
+    //Both vectors are complete before the first thread looks for work, they are read without the lock.
+    for(int i = 0; i < count; i++)
+    {
+        deques.append(new dTaskDeque);
+        threads.append(new CWorkPoolThread(i));
+    }
+    for(int i = 0; i < count; i++)
+        threads.at(i)->start();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorkPool::currentIndex()
+{
+    QThread *current = QThread::currentThread();
+
+    //The vector is only filled once, before the threads start.
+    for(int i = 0; i < threads.size(); i++)
+    {
+        if(threads.at(i) == current)
+            return i;
+    }
+    return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::start(QRunnable *task)
+{
+    dPoolTask poolTask;
+
+    poolTask.runnable = task;
+    poolTask.prioritized = NULL;
+    poolTask.group = NULL;
+    push(poolTask);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::start(CPrioritizedTask *task)
+{
+    dPoolTask poolTask;
+
+    poolTask.runnable = task;
+    poolTask.prioritized = task;
+    poolTask.group = NULL;
+    push(poolTask);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorkPool::priorityOf(const dPoolTask &task)
+{
+    return task.prioritized?task.prioritized->getPriority():WORK_PRIORITY_NORMAL;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::yieldToFocus()
+{
+    dPoolTask task;
+    bool      found;
+
+    //The decode loops call it often, the common case is an empty queue.
+    while(queuedCount.fetchAndAddOrdered(0) > 0)
+    {
+        found = false;
+        {
+            QMutexLocker lock(&poolLock);
+            for(int i = 0; i < injected.size(); i++)
+            {
+                if(priorityOf(injected.at(i)) >= WORK_PRIORITY_FOCUS)
+                {
+                    task = injected.takeAt(i);
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if(!found)
+            return;
+
+        queuedCount.deref();
+        run(task);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorkPool::getThreadCount()
+{
+    ensureStarted();
+    return threads.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::push(const dPoolTask &task)
+{
+    int index;
+
+    ensureStarted();
+    index = currentIndex();
+
+    if(index >= 0)
+    {
+        QMutexLocker dequeLock(&deques.at(index)->lock);
+        deques.at(index)->tasks.append(task);
+    }
+    else
+    {
+        QMutexLocker lock(&poolLock);
+        injected.append(task);
+    }
+
+    //Counted after the push, a sleeper checks the count under the pool lock.
+    queuedCount.ref();
+    QMutexLocker lock(&poolLock);
+    if(sleepingCount > 0)
+        taskAvailable.wakeOne();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CWorkPool::takeFrom(QList<dPoolTask> &tasks, const CTaskGroup *group, bool newest, dPoolTask *task)
+{
+    if(tasks.isEmpty())
+        return false;
+
+    if((group == NULL)&&newest)
+    {
+        *task = tasks.takeLast();
+        return true;
+    }
+
+    //The highest priority first, the oldest among equals.
+    if(group == NULL)
+    {
+        int best = 0;
+        int bestPriority = priorityOf(tasks.at(0));
+
+        for(int i = 1; (i < tasks.size())&&(bestPriority < WORK_PRIORITY_FOCUS); i++)
+        {
+            int priority = priorityOf(tasks.at(i));
+            if(priority > bestPriority)
+            {
+                best = i;
+                bestPriority = priority;
+            }
+        }
+        *task = tasks.takeAt(best);
+        return true;
+    }
+
+    for(int i = 0; i < tasks.size(); i++)
+    {
+        int at = newest?(tasks.size() - 1 - i):i;
+        if(tasks.at(at).group == group)
+        {
+            *task = tasks.takeAt(at);
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool CWorkPool::take(int index, const CTaskGroup *group, dPoolTask *task)
+{
+    bool found = false;
+
+    //Own deque first, newest first.
+    if(index >= 0)
+    {
+        QMutexLocker dequeLock(&deques.at(index)->lock);
+        found = takeFrom(deques.at(index)->tasks, group, true, task);
+    }
+
+    if(!found)
+    {
+        QMutexLocker lock(&poolLock);
+        found = takeFrom(injected, group, false, task);
+    }
+
+    //Steal the oldest task of another thread.
+    for(int i = 1; (!found)&&(i <= deques.size()); i++)
+    {
+        int victim = (index + i + deques.size()) % deques.size();
+        if(victim == index)
+            continue;
+
+        QMutexLocker dequeLock(&deques.at(victim)->lock);
+        found = takeFrom(deques.at(victim)->tasks, group, false, task);
+    }
+
+    if(found)
+        queuedCount.deref();
+    return found;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::run(const dPoolTask &task)
+{
+    bool autoDelete = task.runnable->autoDelete();
+
+    task.runnable->run();
+    if(autoDelete)
+        delete task.runnable;
+
+    //Last, the waiter may release the data the task has used.
+    if(task.group)
+        task.group->taskDone();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::threadLoop(int index)
+{
+    dPoolTask task;
+
+    while(true)
+    {
+        if(take(index, NULL, &task))
+        {
+            run(task);
+            continue;
+        }
+
+        poolLock.lock();
+        if(stopping)
+        {
+            poolLock.unlock();
+            break;
+        }
+        if(queuedCount.fetchAndAddOrdered(0) == 0)
+        {
+            sleepingCount++;
+            taskAvailable.wait(&poolLock);
+            sleepingCount--;
+        }
+        poolLock.unlock();
+
+        //Counted but not taken yet by another thread.
+        QThread::yieldCurrentThread();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorkPool::shutdown()
+{
+    poolLock.lock();
+    stopping = true;
+    taskAvailable.wakeAll();
+    poolLock.unlock();
+
+    //Threads still busy after the timeout are left to the process exit.
+    for(int i = 0; i < threads.size(); i++)
+        threads.at(i)->wait(WORK_POOL_EXIT_WAIT_MS);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CTaskGroup::CTaskGroup()
+{
+    pending = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CTaskGroup::~CTaskGroup()
+{
+    wait();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CTaskGroup::run(QRunnable *task)
+{
+    CWorkPool::dPoolTask poolTask;
+
+    groupLock.lock();
+    pending++;
+    groupLock.unlock();
+
+    poolTask.runnable = task;
+    poolTask.prioritized = NULL;
+    poolTask.group = this;
+    CWorkPool::push(poolTask);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CTaskGroup::wait()
+{
+    CWorkPool::dPoolTask task;
+    int                  index = CWorkPool::currentIndex();
+
+    while(true)
+    {
+        groupLock.lock();
+        if(pending == 0)
+        {
+            groupLock.unlock();
+            return;
+        }
+        groupLock.unlock();
+
+        //Help with the queued tasks of the group.
+        if(CWorkPool::take(index, this, &task))
+        {
+            CWorkPool::run(task);
+            continue;
+        }
+
+        //The rest is running; it may still split, so look again from time to time.
+        groupLock.lock();
+        if(pending > 0)
+            allDone.wait(&groupLock, WORK_POOL_HELP_POLL_MS);
+        groupLock.unlock();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CTaskGroup::taskDone()
+{
+    QMutexLocker lock(&groupLock);
+
+    if(--pending == 0)
+        allDone.wakeAll();
+}
@@ -20,6 +20,17 @@
 #include "./inc/Threads.h"
 #include "./inc/globals.h"
 #include "./inc/aidMainWindow.h"
+#include "./inc/CFloatExport.h"
+#include "./inc/CSession.h"
+#include "./inc/CSpillStore.h"
+#include "./inc/CBufferPool.h"
+#include "./inc/CWorkPool.h"
+#include "./inc/CStreamTable.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QCoreApplication>
+#include <QRunnable>
 
 #ifdef QT4_HEADERS
     #include <QInputDialog>
@@ -35,41 +46,114 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-void CWorker::selfStart()
+/*!
+ * \brief The CWorkerTask class.
+ *        Runs a CWorker on the work pool.
+ */
+
+class CWorkerTask : public CPrioritizedTask
 {
-    QThread* thread = new QThread;
-    moveToThread(thread);
-    connect(thread, SIGNAL(started()),  this,   SLOT(process()));
-    connect(this,   SIGNAL(finished()), thread, SLOT(quit()));
-    connect(this,   SIGNAL(finished()), this,   SLOT(deleteLater()));
-    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+public:
+    CWorkerTask(CWorker *workerPtr){this->workerPtr = workerPtr;}
+
+    int getPriority(){return workerPtr->getPriority();}
+
+    void run()
+    {
+        workerPtr->process();
+        workerPtr->deleteLater();
+    }
+
+private:
+    CWorker *workerPtr;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker::handOver()
+{
+    //Pool threads have no event loop: the worker is deleted in the GUI thread.
+    moveToThread(QCoreApplication::instance()->thread());
 
     if(informMeWhenFinished!=0)
-        connect(this, SIGNAL(iAmDone()), informMeWhenFinished, SLOT(iAmDone()));
-    thread->start();
+        connect(this, SIGNAL(iAmDone()), informMeWhenFinished, SLOT(iAmDone()), Qt::QueuedConnection);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
+CPrioritizedTask* CWorker::makeTask()
+{
+    handOver();
+    return new CWorkerTask(this);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker::selfStart()
+{
+    CWorkPool::start(makeTask());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * Returns the image name carried by a payload, empty when there is none or the header is invalid
+ * (process() validates it properly). Used to prioritize the frames before they are decoded.
+ */
+static QString peekPayloadName(const char *inBuffPtr, int inBuffLength)
+{
+    const dHeader *headerPtr;
+
+    if((inBuffPtr == NULL)||(inBuffLength < int(MAGIC_CHARS_SIZE + sizeof(dHeader))))
+        return QString();
+
+    headerPtr = (const dHeader*)(inBuffPtr + MAGIC_CHARS_SIZE);
+    if((headerPtr->nameLength == 0)||(headerPtr->nameLength > MAX_IMG_NAME_LENGTH)||
+       (headerPtr->formatStrLength > MAX_FORMAT_STRING_LENGTH)||
+       ((quint64)inBuffLength < (quint64)MAGIC_CHARS_SIZE + sizeof(dHeader) + headerPtr->formatStrLength + headerPtr->nameLength))
+        return QString();
 
+    return QString::fromLatin1(inBuffPtr + MAGIC_CHARS_SIZE + sizeof(dHeader) + headerPtr->formatStrLength, headerPtr->nameLength);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
 CWorker_loadFromNativeData::CWorker_loadFromNativeData(const QObject *parent, const QByteArray &qba) : CWorker(parent)
 {
-  this->qba = qba;
   reinterpretProcess = false;
-  this->inBuffPtr = const_cast<char*>(qba.data());
-  this->inBuffLength = qba.size();
+  loadResult = RES_ERROR;
+  sequenceMode = false;
+  headerPtr = NULL;
+  payloadPtr = NULL;
+  contentHash = 0;
+  //CNativeData takes ownership of the buffer, it has to come from the pool.
+  this->inBuffPtr = CBufferPool::acquire(qba.size());
+  this->inBuffLength = inBuffPtr?qba.size():0;
+  if(inBuffPtr)
+      memcpy(inBuffPtr, qba.constData(), qba.size());
+  frameName = peekPayloadName(inBuffPtr, inBuffLength);
+  streamTicket = (Globals::streamMode && !frameName.isEmpty())?CStreamTable::admit(frameName):0;
 }
 
 CWorker_loadFromNativeData::CWorker_loadFromNativeData(const QObject *parent, const char* inBuffPtr, int inBuffLength) : CWorker(parent)
 {
   reinterpretProcess = false;
+  loadResult = RES_ERROR;
+  sequenceMode = false;
+  headerPtr = NULL;
+  payloadPtr = NULL;
+  contentHash = 0;
   this->inBuffPtr = const_cast<char*>(inBuffPtr);
   this->inBuffLength = inBuffLength;
+  frameName = peekPayloadName(inBuffPtr, inBuffLength);
+  streamTicket = (Globals::streamMode && !frameName.isEmpty())?CStreamTable::admit(frameName):0;
 }
 
 CWorker_loadFromNativeData::CWorker_loadFromNativeData(const QObject *parent, const QSharedPointer<CImgContext> &imgCtxPtr, uint iwidth, uint iheight, QString pixelFormatStr, uint rowStrideInBits, QString name, QString notes, const float gain[16], const float bias[4], quint32 auxFilteringFlags) : CWorker(parent)
 {
   reinterpretProcess = true;
+  loadResult = RES_ERROR;
+  sequenceMode = false;
+  headerPtr = NULL;
+  payloadPtr = NULL;
+  contentHash = 0;
+  streamTicket = 0;
   this->imgCtxPtr = imgCtxPtr;
   this->name = name;
   this->notes = notes;
@@ -81,12 +165,109 @@ CWorker_loadFromNativeData::CWorker_loadFromNativeData(const QObject *parent, co
   memcpy(this->bias, bias, sizeof(float)*4);
   this->auxFilteringFlags = auxFilteringFlags;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorker_loadFromNativeData::getPriority()
+{
+  if(!targetImgCtxPtr.isNull())
+      return Globals::isInFocus(targetImgCtxPtr.data())?WORK_PRIORITY_FOCUS:WORK_PRIORITY_BACKGROUND;
+  if(reinterpretProcess)
+      return WORK_PRIORITY_NORMAL;
+  return (!frameName.isEmpty() && Globals::isInFocus(frameName))?WORK_PRIORITY_FOCUS:WORK_PRIORITY_BACKGROUND;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_loadFromNativeData::replaceStreamFrame(QSharedPointer<CImgContext> &newImgCtxPtr)
+{
+    QList<QSharedPointer<CImgContext> > listed;
+
+    if(!streamTicket)
+        return;
+
+    //Frames decoded on other threads may overtake each other, the newest one published stays listed.
+    if(!CStreamTable::publish(name, streamTicket))
+    {
+        CStreamTable::addSkipped(name);
+        Globals::removeImage(newImgCtxPtr);
+        return;
+    }
+
+    newImgCtxPtr->setStreamSkipped(CStreamTable::getSkipped(name));
+
+    //Looked up now, the frame listed when the decode started may be gone or overtaken.
+    //Removing a frame still decoding cancels it; it is counted as skipped by its own worker.
+    listed = Globals::imgRegistry.findAllByName(name);
+    for(int i = 0; i < listed.size(); i++)
+    {
+        QSharedPointer<CImgContext> &next = listed[i];
+
+        if((next != newImgCtxPtr) && !next->isPinned() && (next->getStreamTicket() < streamTicket))
+            Globals::removeImage(next);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_loadFromNativeData::setTargetContext(const QSharedPointer<CImgContext> &targetImgCtxPtr)
+{
+  this->targetImgCtxPtr = targetImgCtxPtr;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_loadFromNativeData::setFrameSequence(quint32 frameSize, quint32 frameStride, quint32 frameCount)
+{
+  sequenceMode = true;
+  this->frameSize = frameSize;
+  this->frameStride = frameStride;
+  this->frameCount = frameCount;
+}
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * Hashes everything that makes two payloads show the same image: the layout, the pre-filters,
+ * the pixel format and the data. The name and the notes are not part of it.
+ */
+static quint64 payloadContentHash(const dHeader *headerPtr, const char *formatPtr, const char *payloadPtr)
+{
+    quint32 layout[5] = {headerPtr->width,
+                         headerPtr->height,
+                         headerPtr->rowStrideInBits,
+                         headerPtr->sizeInBytes,
+                         headerPtr->auxFiltering};
+    quint64 hash;
+
+    hash = contentHash64(layout, sizeof(layout));
+    hash = contentHash64(headerPtr->normGain, sizeof(headerPtr->normGain), hash);
+    hash = contentHash64(headerPtr->normBias, sizeof(headerPtr->normBias), hash);
+    hash = contentHash64(formatPtr, headerPtr->formatStrLength, hash);
+    return contentHash64(payloadPtr, headerPtr->sizeInBytes, hash);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CWorker_loadFromNativeData::process()
 {
-    QSharedPointer<CImgContext>  newImgContextPtr;
-    dHeader                     *headerPtr = NULL;
-    QSharedPointer<CNativeData>  nativeDataPtr;
+    QSharedPointer<CImgContext> newImgContextPtr;
+
+    if(parse() == RES_OK)
+    {
+        newImgContextPtr = decode();
+        Globals::addCmdToLocalQueue(CMD_CREATE_RENDERABLE_DATA, newImgContextPtr);
+    }
+    finish();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_loadFromNativeData::finish()
+{
+    emit iAmDone();
+    emit finished();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorker_loadFromNativeData::parse()
+{
+    headerPtr = NULL;
+    payloadPtr = NULL;
+    contentHash = 0;
+    loadResult = RES_ERROR;
 
     if(!reinterpretProcess)
     {
@@ -127,6 +308,13 @@ void CWorker_loadFromNativeData::process()
         if(headerPtr->notesLength > MAX_IMG_NOTES_LENGTH)
             goto __EXIT_WITH_ERROR;
 
+        if((quint64)inBuffLength < (quint64)MAGIC_CHARS_SIZE + sizeof(dHeader)\
+                                   + headerPtr->formatStrLength \
+                                   + headerPtr->nameLength \
+                                   + headerPtr->notesLength \
+                                   + headerPtr->sizeInBytes)
+            goto __EXIT_WITH_ERROR;
+
         if(headerPtr->nameLength  ==0)
         {
             name = "img";
@@ -159,53 +347,166 @@ void CWorker_loadFromNativeData::process()
                                                       headerPtr->nameLength),
                                                       headerPtr->notesLength);
         }
+
+        //Stream mode: a frame superseded while it was queued is dropped undecoded.
+        if(streamTicket && CStreamTable::isSuperseded(name, streamTicket))
+            goto __EXIT_SUPERSEDED;
+
+        //Producers often resend the same buffer; a byte-identical payload shares the decoded image.
+        payloadPtr = inBuffPtr + MAGIC_CHARS_SIZE + sizeof(dHeader) + headerPtr->formatStrLength + headerPtr->nameLength + headerPtr->notesLength;
+        contentHash = payloadContentHash(headerPtr, inBuffPtr + MAGIC_CHARS_SIZE + sizeof(dHeader), payloadPtr);
+        if(targetImgCtxPtr.isNull() && !sequenceMode)
+            originalImgContextPtr = Globals::imgRegistry.findByContentHash(contentHash);
     }
+    return RES_OK;
+
+    __EXIT_SUPERSEDED:
+    CStreamTable::addSkipped(name);
+    CBufferPool::release(inBuffPtr);
+    //Valid data, only not shown.
+    loadResult = RES_OK;
+    return RES_ERROR;
+
+    __EXIT_WITH_ERROR:
+    //Only the header checks fail here, the buffer has not been handed over yet.
+    CBufferPool::release(inBuffPtr);
+    showStatusMessage("Image loading error.", UI_STATUS_ERROR, true);
+    return RES_ERROR;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+QSharedPointer<CImgContext> CWorker_loadFromNativeData::decode()
+{
+    QSharedPointer<CImgContext>  newImgContextPtr;
+    QSharedPointer<CNativeData>  nativeDataPtr;
+    QSharedPointer<CImgContext>  previousImgContextPtr;
+    bool                         skipped = false;
 
     //Create a new CNativeData object.
     if(!reinterpretProcess)
     {
         nativeDataPtr = QSharedPointer<CNativeData>(new CNativeData(inBuffPtr));
     }
-    else if(imgCtxPtr->imgSource == SOURCE_FILE)
-    {
-        nativeDataPtr = QSharedPointer<CNativeData>(new CNativeData(imgCtxPtr->getVisualData()));
-        nativeDataPtr->getData().append(COM_ALIGN_CHARS); // long long alignment
-    }
     else
     {
-        nativeDataPtr = imgCtxPtr->nativeDataPtr;
+        //The source is only read; the shared pointer keeps its data alive past the lock.
+        imgCtxPtr->lockDataForRead(-1);
+        if(imgCtxPtr->imgSource == SOURCE_FILE)
+            nativeDataPtr = imgCtxPtr->getVisualDataView();
+        else
+            nativeDataPtr = imgCtxPtr->nativeDataPtr;
+        imgCtxPtr->unlockData();
     }
 
-    //Create a new CImgContext object.
-    newImgContextPtr = QSharedPointer<CImgContext>(new CImgContext());
-    newImgContextPtr->pendingFlag(PENDING_FLAG_LOCKED); // must pass
+    //Create a new CImgContext object (or fill the one prepared by the caller).
+    if(targetImgCtxPtr.isNull())
+    {
+        newImgContextPtr = QSharedPointer<CImgContext>(new CImgContext());
+        newImgContextPtr->pendingFlag(PENDING_FLAG_LOCKED); // must pass
 
-    if(Globals::autoScaleOnLoad)
-       newImgContextPtr->setZoomFactor(0.0f);
+        if(Globals::autoScaleOnLoad)
+           newImgContextPtr->setZoomFactor(0.0f);
+    }
+    else
+    {
+        newImgContextPtr = targetImgCtxPtr;
+        newImgContextPtr->pendingFlag(PENDING_FLAG_LOCKED); // must pass
+    }
 
     newImgContextPtr->need_thumbnail_refresh = true;
     Globals::addCmdToLocalQueue(CMD_CREATE_RENDERABLE_DATA, newImgContextPtr);
 
     newImgContextPtr->attachNativeData(nativeDataPtr);
-    Globals::addImage(newImgContextPtr);
+    if(targetImgCtxPtr.isNull())
+    {
+        if(!reinterpretProcess)
+            previousImgContextPtr = Globals::imgRegistry.findByName(name);
+
+        //A frame still decoding under the same name is superseded, its result would be replaced anyway.
+        //Streams let it finish instead (see below), otherwise a fast producer would starve them.
+        if(!previousImgContextPtr.isNull() && !streamTicket)
+            previousImgContextPtr->cancelDecode();
+
+        //A stream frame replaces the previous one in the list and keeps its view.
+        newImgContextPtr->setStreamTicket(streamTicket);
+        if(!previousImgContextPtr.isNull() && streamTicket)
+            newImgContextPtr->adoptViewOf(previousImgContextPtr);
+
+        Globals::addImage(newImgContextPtr);
+
+        //Background frames give way to the frames in focus at tile boundaries.
+        if(!reinterpretProcess)
+            newImgContextPtr->setPreemptibleDecode(getPriority() == WORK_PRIORITY_BACKGROUND);
+    }
 
     //Load data.
     newImgContextPtr->setMyState(STATE_BUSY);
 
     if(!reinterpretProcess)
     {
-        if(newImgContextPtr->loadFromNativeData(*headerPtr,
-                                                pixelFormatStr,
-                                                name,
-                                                notes
-                                                ) == RES_ERROR)
+        if((!originalImgContextPtr.isNull())&&
+           (newImgContextPtr->loadAliasOf(originalImgContextPtr,
+                                          *headerPtr,
+                                          pixelFormatStr,
+                                          payloadPtr,
+                                          name,
+                                          notes
+                                          ) == RES_OK))
+        {
+            //The received buffer is released with nativeDataPtr.
+            newImgContextPtr->setMyState(STATE_READY);
+            Globals::imgRegistry.setContentHash(newImgContextPtr, contentHash);
+            replaceStreamFrame(newImgContextPtr);
+            showStatusMessage("New image has been loaded - identical to " + originalImgContextPtr->getMyName() + ", data shared.", UI_STATUS_INFO, true);
+        }
+        else if(newImgContextPtr->loadFromNativeData(*headerPtr,
+                                                     pixelFormatStr,
+                                                     name,
+                                                     notes
+                                                     ) == RES_ERROR)
         {
             newImgContextPtr->setMyState(STATE_BAD);
-            showStatusMessage("New image has been loaded - data corrupted or invalid format.", UI_STATUS_ERROR, true);
+            if(streamTicket && newImgContextPtr->getCancelToken().isCancelled() && CStreamTable::isSuperseded(name, streamTicket))
+            {
+                //Removed by a newer frame of its stream which finished first.
+                CStreamTable::addSkipped(name);
+                skipped = true;
+            }
+            else if(newImgContextPtr->isDecodeCancelled())
+                showStatusMessage("Decoding of " + name + " cancelled - removed or superseded by a newer frame.", UI_STATUS_INFO, false);
+            else
+                showStatusMessage("New image has been loaded - data corrupted or invalid format.", UI_STATUS_ERROR, true);
+        }
+        else if(sequenceMode)
+        {
+            QSharedPointer<CFrameSequence> sequencePtr = QSharedPointer<CFrameSequence>(new CFrameSequence(nativeDataPtr));
+
+            if(sequencePtr->setup(headerPtr->width,
+                                  headerPtr->height,
+                                  headerPtr->rowStrideInBits,
+                                  pixelFormatStr,
+                                  newImgContextPtr->pgain,
+                                  newImgContextPtr->pbias,
+                                  frameSize,
+                                  frameStride,
+                                  frameCount) == RES_ERROR)
+            {
+                newImgContextPtr->myNotes += "\nFrame sequence error: " + sequencePtr->lastLog;
+                newImgContextPtr->setMyState(STATE_BAD);
+                showStatusMessage("New sequence has been loaded - invalid frame layout.", UI_STATUS_ERROR, true);
+            }
+            else
+            {
+                newImgContextPtr->attachFrameSequence(sequencePtr);
+                newImgContextPtr->setMyState(STATE_READY);
+                showStatusMessage("New sequence of " + QString::number(sequencePtr->getFrameCount()) + " frames has been loaded.", UI_STATUS_INFO, true);
+            }
         }
         else
         {
             newImgContextPtr->setMyState(STATE_READY);
+            Globals::imgRegistry.setContentHash(newImgContextPtr, contentHash);
+            replaceStreamFrame(newImgContextPtr);
             showStatusMessage("New image has been loaded.", UI_STATUS_INFO, true);
         }
     }
@@ -223,7 +524,10 @@ void CWorker_loadFromNativeData::process()
                                                 ) == RES_ERROR)
         {
             newImgContextPtr->setMyState(STATE_BAD);
-            showStatusMessage("Data reinterpretation - data corrupted or invalid format.", UI_STATUS_ERROR, true);
+            if(newImgContextPtr->isDecodeCancelled())
+                showStatusMessage("Data reinterpretation cancelled.", UI_STATUS_INFO, false);
+            else
+                showStatusMessage("Data reinterpretation - data corrupted or invalid format.", UI_STATUS_ERROR, true);
         }
         else
         {
@@ -233,13 +537,35 @@ void CWorker_loadFromNativeData::process()
     }
 
     newImgContextPtr->need_thumbnail_refresh = true;
-    Globals::addCmdToLocalQueue(CMD_CREATE_RENDERABLE_DATA, newImgContextPtr);
-    emit iAmDone();
-    emit finished();
-    return;
+    loadResult = (skipped||(newImgContextPtr->getMyState() != STATE_BAD))?RES_OK:RES_ERROR;
+    return newImgContextPtr;
+}
 
-    __EXIT_WITH_ERROR:
-    showStatusMessage("Image loading error.", UI_STATUS_ERROR, true);
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CWorker_decodeSequenceFrames::CWorker_decodeSequenceFrames(const QSharedPointer<CFrameSequence> &sequencePtr,
+                                                           const QList<qint32> &frameIndices):CWorker(0)
+{
+    this->sequencePtr = sequencePtr;
+    this->frameIndices = frameIndices;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_decodeSequenceFrames::process()
+{
+    if(!sequencePtr.isNull())
+    {
+        QVector<CTiledImage> frames = sequencePtr->decodeFrames(frameIndices);
+
+        for(int i = 0; i < frameIndices.size(); i++)
+            sequencePtr->storeFrame(frameIndices.at(i), frames.at(i));
+
+        //The panels waiting for one of these frames swap it in.
+        Globals::addCmdToLocalQueue(CMD_SHOW_DECODED_FRAMES);
+    }
+
+    //Do not keep the frames alive longer than the image context does.
+    sequencePtr.clear();
     emit iAmDone();
     emit finished();
 }
@@ -253,31 +579,92 @@ CWorker_loadFromRICFile::CWorker_loadFromRICFile(const QString &fileName):CWorke
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CWorker_loadFromRICFile::process()
+{
+    if(loadFile(fileName) == RES_ERROR)
+        showStatusMessage("Error opening the file.", UI_STATUS_ERROR, true);
+
+    emit iAmDone();
+    emit finished();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorker_loadFromRICFile::loadFile(const QString &fileName)
 {
     QFile   ifile(fileName);
-    int     fileSize;
+    qint64  fileSize;
+    char*   inBuff;
 
     if(!ifile.open(QIODevice::ReadOnly))
-    {
-        showStatusMessage("Error opening the file.", UI_STATUS_ERROR, true);
-        emit finished();
-        return;
-    }
+        return RES_ERROR;
 
-    fileSize = ifile.bytesAvailable();
-    char* inBuff = (char*)malloc(fileSize);
+    fileSize = ifile.size();
+    if((fileSize <= 0)||(fileSize > COM_MAX_DATA_SIZE))
+        return RES_ERROR;
+
+    inBuff = CBufferPool::acquire(fileSize);
     if(!inBuff)
-        return;
-    ifile.read(inBuff, fileSize);
+        return RES_ERROR;
 
+    if(ifile.read(inBuff, fileSize) != fileSize)
+    {
+        CBufferPool::release(inBuff);
+        return RES_ERROR;
+    }
+    ifile.close();
+
+    //CNativeData takes ownership of the buffer.
     CWorker_loadFromNativeData lnd(0, inBuff, fileSize);
 
     lnd.blockSignals(true);
     lnd.process();
+    return lnd.getResult();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CWorker_ingestFiles::CWorker_ingestFiles(const QObject *parent,
+                                         const QStringList &fileNames,
+                                         int postAction,
+                                         const QString &archivePath):CWorker(parent)
+{
+    this->fileNames = fileNames;
+    this->postAction = postAction;
+    this->archivePath = archivePath;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_ingestFiles::process()
+{
+    QFileInfo   fileInfo;
+    QString     archivedName;
+
+    for(int i = 0; i < fileNames.size(); i++)
+    {
+        fileInfo.setFile(fileNames.at(i));
+
+        //A file which failed to load stays where it is, for a retry or an inspection.
+        if(CWorker_loadFromRICFile::loadFile(fileInfo.absoluteFilePath()) == RES_ERROR)
+        {
+            showStatusMessage("Watched directory: error loading " + fileInfo.fileName() + " - the file has been left in place.", UI_STATUS_ERROR, false);
+            continue;
+        }
+
+        if(postAction == WATCH_POST_DELETE)
+        {
+            QFile::remove(fileInfo.absoluteFilePath());
+        }
+        else if(postAction == WATCH_POST_ARCHIVE)
+        {
+            archivedName = archivePath + "/" + fileInfo.fileName();
+            if(QFile::exists(archivedName))
+                archivedName = archivePath + "/" + fileInfo.completeBaseName() + "_" +
+                               QString::number(QDateTime::currentMSecsSinceEpoch()) + "." + fileInfo.suffix();
+            QFile::rename(fileInfo.absoluteFilePath(), archivedName);
+        }
+    }
+
     emit iAmDone();
     emit finished();
-    ifile.close();
-    return;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -328,22 +715,11 @@ CWorker_saveToGraphicsFile::CWorker_saveToGraphicsFile(QSharedPointer<CImgContex
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CWorker_saveToGraphicsFile::process()
 {
-    if(!Globals::toolThreadSlot.tryLock())
-    {
-      Globals::addCmdToLocalQueue(CMD_SHOW_MSGBOX_TOOL_SLOT_BUSY);
-      return;
-    }
-
-    Globals::imgContextListLock.lock();
-
     if(!imgContextPtr.isNull())
     {
+        imgContextPtr->lockDataForRead(-1);
         if(imgContextPtr->getMyState() == STATE_READY)
         {
-            imgContextPtr->setMyState(STATE_BUSY);
-            Globals::imgContextListLock.unlock();
-            Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, imgContextPtr);
-            imgContextPtr->auxInfo = "Saving to a graphics file...";
             if(imgContextPtr->saveToGraphicsFile(fileName) == RES_ERROR)
             {
                 Globals::addCmdToLocalQueue(CMD_SHOW_MSGBOX_SAVE_GFILE_FAILED);
@@ -351,20 +727,11 @@ void CWorker_saveToGraphicsFile::process()
             }
             else
                 showStatusMessage("The image has been saved.", UI_STATUS_INFO, true);
-
-            imgContextPtr->auxInfo = "";
-            imgContextPtr->setMyState(STATE_READY);
         }
-        else
-            Globals::imgContextListLock.unlock();
-
-        Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, imgContextPtr);
+        imgContextPtr->unlockData();
     }
     else
-    {
         showStatusMessage("Nothing to save.", UI_STATUS_ERROR, true);
-        Globals::imgContextListLock.unlock();
-    }
 
     emit iAmDone();
     emit finished();
@@ -383,16 +750,11 @@ CWorker_saveToRICFile::CWorker_saveToRICFile(QSharedPointer<CImgContext> _imgCon
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CWorker_saveToRICFile::process()
 {
-    Globals::imgContextListLock.lock();
     if(!imgContextPtr.isNull())
     {
+        imgContextPtr->lockDataForRead(-1);
         if((imgContextPtr->getMyState() == STATE_READY)||(imgContextPtr->getMyState() == STATE_BAD))
         {
-            uint lastState = imgContextPtr->getMyState();
-            imgContextPtr->setMyState(STATE_BUSY);
-            Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, imgContextPtr);
-            imgContextPtr->auxInfo = "Saving to a RIC file...";
-            Globals::imgContextListLock.unlock();
             if(imgContextPtr->saveToRICFile(fileName) == RES_ERROR)
             {
                 Globals::addCmdToLocalQueue(CMD_SHOW_MSGBOX_SAVE_GFILE_FAILED);
@@ -400,25 +762,231 @@ void CWorker_saveToRICFile::process()
             }
             else
                 showStatusMessage("The image has been saved.", UI_STATUS_INFO, true);
-
-            imgContextPtr->auxInfo = "";
-            imgContextPtr->setMyState(lastState);
         }
-        else
-            Globals::imgContextListLock.unlock();
-
-        Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, imgContextPtr);
+        imgContextPtr->unlockData();
     }
     else
+        showStatusMessage("Nothing to save.", UI_STATUS_ERROR, true);
+
+    emit iAmDone();
+    emit finished();
+    Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CWorker_saveToFloatFile::CWorker_saveToFloatFile(QSharedPointer<CImgContext> _imgContextPtr,
+                                                 QString _fileName): CWorker(0)
+{
+    imgContextPtr = _imgContextPtr;
+    fileName = _fileName;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_saveToFloatFile::process()
+{
+    int res;
+
+    if(!imgContextPtr.isNull())
     {
+        imgContextPtr->lockDataForRead(-1);
+        if(imgContextPtr->getMyState() == STATE_READY)
+        {
+            CFloatExport floatExport(imgContextPtr);
+            if(QFileInfo(fileName).suffix().toLower() == "pfm")
+                res = floatExport.saveToPFMFile(fileName);
+            else
+                res = floatExport.saveToTiledFloatFile(fileName);
+
+            if(res == RES_ERROR)
+            {
+                Globals::addCmdToLocalQueue(CMD_SHOW_MSGBOX_SAVE_GFILE_FAILED);
+                showStatusMessage("Error saving the image: " + floatExport.lastLog, UI_STATUS_ERROR, true);
+            }
+            else
+                showStatusMessage("The image has been saved.", UI_STATUS_INFO, true);
+        }
+        imgContextPtr->unlockData();
+    }
+    else
         showStatusMessage("Nothing to save.", UI_STATUS_ERROR, true);
-        Globals::imgContextListLock.unlock();
+
+    emit iAmDone();
+    emit finished();
+    Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/*!
+ * \brief The CExportSummary struct.
+ *        Shared by the export tasks of one batch.
+ */
+
+struct CExportSummary
+{
+    QMutex       lock;
+    int          total;
+    int          saved;
+    QStringList  failed;
+    QStringList  skipped;      //!< Not loaded (busy or bad), nothing to export.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class CExportTask : public QRunnable
+{
+public:
+    CExportTask(const QSharedPointer<CImgContext> &imgContextPtr, const QString &fileName, CExportSummary *summaryPtr)
+    {
+        this->imgContextPtr = imgContextPtr;
+        this->fileName = fileName;
+        this->summaryPtr = summaryPtr;
     }
+
+    void run()
+    {
+        QString    suffix = QFileInfo(fileName).suffix().toLower();
+        QByteArray spilledPayload;
+        QFile      ofile;
+        int        res = RES_ERROR;
+        bool       skipped = false;
+
+        //The pixels of a spilled image are decoded back; it is spilled again by the memory budget.
+        if((suffix != "ric")&&(imgContextPtr->getMyState() == STATE_SPILLED))
+            CSpillStore::faultInNow(imgContextPtr);
+
+        //Shared access, the image may have been spilled since the snapshot.
+        imgContextPtr->lockDataForRead(-1);
+        if((suffix == "ric")&&(imgContextPtr->getMyState() == STATE_SPILLED))
+        {
+            //Copied as it is from the spill file (see CSession::save).
+            spilledPayload.resize(imgContextPtr->spillSize);
+            ofile.setFileName(fileName);
+            if((CSpillStore::readPayload(imgContextPtr, spilledPayload.data()) == RES_OK)&&
+               (ofile.open(QIODevice::WriteOnly))&&
+               (ofile.write(spilledPayload.constData(), spilledPayload.size()) == spilledPayload.size()))
+                res = RES_OK;
+        }
+        else if(imgContextPtr->getMyState() == STATE_READY)
+        {
+            if(suffix == "ric")
+                res = imgContextPtr->saveToRICFile(fileName);
+            else if((suffix == "pfm")||(suffix == "atf"))
+            {
+                CFloatExport floatExport(imgContextPtr);
+                res = (suffix == "pfm")?floatExport.saveToPFMFile(fileName):floatExport.saveToTiledFloatFile(fileName);
+            }
+            else
+                res = imgContextPtr->saveToGraphicsFile(fileName);
+        }
+        else
+            skipped = true;
+        imgContextPtr->unlockData();
+
+        summaryPtr->lock.lock();
+        if(res == RES_OK)
+            summaryPtr->saved++;
+        else if(skipped)
+            summaryPtr->skipped.append(imgContextPtr->getMyName());
+        else
+            summaryPtr->failed.append(imgContextPtr->getMyName());
+        showStatusMessage("Export: " + QString::number(summaryPtr->saved + summaryPtr->failed.size() + summaryPtr->skipped.size()) + "/" +
+                          QString::number(summaryPtr->total) + " (" + imgContextPtr->getMyName() + ")", UI_STATUS_INFO, false);
+        summaryPtr->lock.unlock();
+    }
+
+private:
+    QSharedPointer<CImgContext> imgContextPtr;
+    QString                     fileName;
+    CExportSummary             *summaryPtr;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CWorker_batchExport::CWorker_batchExport(const QString &directory,
+                                         const QString &format,
+                                         const QString &nameFilter): CWorker(0)
+{
+    this->directory = directory;
+    this->format = format;
+    this->nameFilter = nameFilter;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_batchExport::process()
+{
+    exportImages(directory, format, nameFilter);
+
     emit iAmDone();
     emit finished();
     Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorker_batchExport::exportImages(const QString &directory, const QString &format, const QString &nameFilter)
+{
+    QList<QSharedPointer<CImgContext> > listed, images;
+    QRegExp                             filter(nameFilter.isEmpty()?"*":nameFilter, Qt::CaseInsensitive, QRegExp::Wildcard);
+    QSet<QString>                       usedNames;
+    QString                             baseName, fileName;
+    CExportSummary                      summary;
+    CTaskGroup                          group;
+    QDir                                dir(directory);
+
+    if(!dir.exists()||!QString(EXPORT_FORMATS).split(";").contains(format.toLower()))
+    {
+        showStatusMessage("Export: invalid directory or format.", UI_STATUS_ERROR, true);
+        return -1;
+    }
+
+    //Take a snapshot of the list, the images are kept alive by the shared pointers.
+    //Spilled images are exported too, the images still loading or bad are reported.
+    listed = Globals::imgRegistry.snapshot();
+    for(int i = 0; i < listed.size(); i++)
+    {
+        if(!filter.exactMatch(listed.at(i)->getMyName()))
+            continue;
+        if((listed.at(i)->getMyState() == STATE_READY)||(listed.at(i)->getMyState() == STATE_SPILLED))
+            images.append(listed.at(i));
+        else
+            summary.skipped.append(listed.at(i)->getMyName());
+    }
+
+    summary.total = images.size() + summary.skipped.size();
+    summary.saved = 0;
+
+    for(int i = 0; i < images.size(); i++)
+    {
+        baseName = images.at(i)->getMyName();
+        if(!Globals::isValidName(baseName))
+            baseName = "img" + QString::number(i);
+
+        fileName = baseName;
+        for(int n = 1; usedNames.contains(fileName.toLower()); n++)
+            fileName = baseName + "_" + QString::number(n);
+        usedNames.insert(fileName.toLower());
+
+        group.run(new CExportTask(images.at(i), dir.absoluteFilePath(fileName + "." + format.toLower()), &summary));
+    }
+    group.wait();
+
+    if(summary.failed.isEmpty() && summary.skipped.isEmpty())
+    {
+        showStatusMessage("Export finished: " + QString::number(summary.saved) + " image(s) saved.", UI_STATUS_INFO, true);
+    }
+    else
+    {
+        QString report = "Export finished: " + QString::number(summary.saved) + " saved";
+
+        if(!summary.failed.isEmpty())
+            report += ", " + QString::number(summary.failed.size()) + " failed (" + summary.failed.join(", ") + ")";
+        if(!summary.skipped.isEmpty())
+            report += ", " + QString::number(summary.skipped.size()) + " skipped - not loaded (" + summary.skipped.join(", ") + ")";
+        showStatusMessage(report + ".", UI_STATUS_ERROR, true);
+    }
+
+    return summary.failed.size() + summary.skipped.size();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 CWorker_ImageComparator::CWorker_ImageComparator(const QObject *parent, qint32 shiftAX, qint32 shiftAY, bool vFlip, bool hFlip, float thresholdsv[4], QString name, QSharedPointer<CImgContext> imgA, QSharedPointer<CImgContext> imgB) : CWorker(parent)
@@ -435,19 +1003,16 @@ CWorker_ImageComparator::CWorker_ImageComparator(const QObject *parent, qint32 s
 
 void CWorker_ImageComparator::process()
 {
-    if(!Globals::toolThreadSlot.tryLock())
-    {
-      Globals::addCmdToLocalQueue(CMD_SHOW_MSGBOX_TOOL_SLOT_BUSY);
-      return;
-    }
-
     QSharedPointer<CImgContext> compResult   = QSharedPointer<CImgContext>(new CImgContext());
-    QSharedPointer<CNativeData> nativeResult = QSharedPointer<CNativeData>(new CNativeData());
+    QSharedPointer<CNativeData> nativeResult;
 
-    QByteArray dataA, dataB;
+    CNormalizator readerA, readerB;
+    QSharedPointer<CNativeData> dataA, dataB;
+    QString readerLog;
+    CCancelToken cancelToken;
     qint32 start_x, start_y, stop_x, stop_y, auX;
-    BitIndexAndCount bic;
-    quint32 bitCursorA, bitCursorB, offsAX, offsAY, offsX, offsY, shiftBX, shiftBY;
+    quint64 bitCursorA, bitCursorB;
+    quint32 offsAX, offsAY, offsX, offsY, shiftBX, shiftBY;
     quint32 hFlipMod, vFlipMod;
     float* resBuffPtr;
     float pA[4], pB[4];
@@ -460,56 +1025,27 @@ void CWorker_ImageComparator::process()
     if(imgB.isNull())
          goto __EXIT_IMMEDIATE;
 
+    //The comparison is pointless once one of the images is removed.
+    cancelToken.linkTo(imgA->getCancelToken());
+    cancelToken.linkTo(imgB->getCancelToken());
+
+    //Shared access: both images stay pickable and viewable, writers (spill) wait for the end.
+    imgA->lockDataForRead(-1);
+    imgB->lockDataForRead(-1);
+
     if((imgA->getMyState() != STATE_READY)||(imgB->getMyState() != STATE_READY))
-        goto __EXIT_IMMEDIATE;
+        goto __EXIT_POINT;
 
-    imgA->setMyState(STATE_BUSY);
-    imgB->setMyState(STATE_BUSY);
-    Globals::addCmdToLocalQueue(CMD_REFRESH_THUMBNAILS_LIST);
+    if((imgA->setupReader(readerA, dataA, readerLog) != RES_OK)||
+       (imgB->setupReader(readerB, dataB, readerLog) != RES_OK))
+    {
+        showStatusMessage("Comparison aborted - " + readerLog, UI_STATUS_ERROR, true);
+        goto __EXIT_POINT;
+    }
 
     compResult->pendingFlag(PENDING_FLAG_LOCKED); // must pass
 
-    imgA->auxInfo = imgB->auxInfo = compResult->auxInfo = "Comparing...";
-
-    if(imgA->imgSource == SOURCE_FILE)
-    {
-        dataA = imgA->getVisualData();
-        imgA->myNormalizator.setNativeDataPtr(dataA.data());
-        imgA->myNormalizator.resetMasks();
-        bic.bitIndex=0; bic.bitsCount=8;
-        imgA->myNormalizator.addBLUEBitsMask(BitIndexAndCount(bic));
-        imgA->myNormalizator.setBLUEType(NORM_IUNSIGNED);
-        bic.bitIndex=8; bic.bitsCount=8;
-        imgA->myNormalizator.addGREENBitsMask(BitIndexAndCount(bic));
-        imgA->myNormalizator.setGREENType(NORM_IUNSIGNED);
-        bic.bitIndex=16; bic.bitsCount=8;
-        imgA->myNormalizator.addREDBitsMask(BitIndexAndCount(bic));
-        imgA->myNormalizator.setREDType(NORM_IUNSIGNED);
-        bic.bitIndex=24; bic.bitsCount=8;
-        imgA->myNormalizator.addALPHABitsMask(BitIndexAndCount(bic));
-        imgA->myNormalizator.setALPHAType(NORM_IUNSIGNED);
-        imgA->myNormalizator.adjustCapacity();
-    }
-
-    if(imgB->imgSource == SOURCE_FILE)
-    {
-        dataB = imgB->getVisualData();
-        imgB->myNormalizator.setNativeDataPtr(dataB.data());
-        imgB->myNormalizator.resetMasks();
-        bic.bitIndex=0; bic.bitsCount=8;
-        imgB->myNormalizator.addBLUEBitsMask(BitIndexAndCount(bic));
-        imgB->myNormalizator.setBLUEType(NORM_IUNSIGNED);
-        bic.bitIndex=8; bic.bitsCount=8;
-        imgB->myNormalizator.addGREENBitsMask(BitIndexAndCount(bic));
-        imgB->myNormalizator.setGREENType(NORM_IUNSIGNED);
-        bic.bitIndex=16; bic.bitsCount=8;
-        imgB->myNormalizator.addREDBitsMask(BitIndexAndCount(bic));
-        imgB->myNormalizator.setREDType(NORM_IUNSIGNED);
-        bic.bitIndex=24; bic.bitsCount=8;
-        imgB->myNormalizator.addALPHABitsMask(BitIndexAndCount(bic));
-        imgB->myNormalizator.setALPHAType(NORM_IUNSIGNED);
-        imgB->myNormalizator.adjustCapacity();
-    }
+    compResult->progress.begin(PROGRESS_COMPARING, 0);
 
     start_x = max(shiftAX, 0);
     start_y = max(shiftAY, 0);
@@ -517,21 +1053,21 @@ void CWorker_ImageComparator::process()
     stop_y  = min(imgA->getIHeight()+shiftAY, imgB->getIHeight());
 
     if((stop_x <= start_x)||(stop_y <= start_y))
-    {
-        imgA->setMyState(STATE_READY);
-        imgB->setMyState(STATE_READY);
-        imgA->auxInfo = imgB->auxInfo = "";
-        Globals::addCmdToLocalQueue(CMD_REFRESH_THUMBNAILS_LIST);
         goto __EXIT_POINT;
-    }
 
     compResult->setIWidth(stop_x - start_x);
     compResult->setIHeight(stop_y - start_y);
     compResult->setMyState(STATE_BUSY);
     compResult->myPixelFormat = "fa R32 G32 B32 A32";
+    compResult->setToolOutput(true);
 
-    nativeResult->getData().fill(0, compResult->getIWidth()*compResult->getIHeight()*16);
-    resBuffPtr = (float*)nativeResult->getData().data();
+    nativeResult = QSharedPointer<CNativeData>(new CNativeData(compResult->getIWidth()*compResult->getIHeight()*16, true));
+    if(nativeResult->getData().isEmpty())
+    {
+        showStatusMessage("Comparison aborted - out of memory.", UI_STATUS_ERROR, true);
+        goto __EXIT_POINT;
+    }
+    resBuffPtr = (float*)nativeResult->getDataPtr();
 
     shiftBX = 0;
     if(shiftAX<0)
@@ -569,11 +1105,13 @@ void CWorker_ImageComparator::process()
         offsAY = compResult->getIHeight()-1;
     }
 
+    compResult->progress.begin(PROGRESS_COMPARING, stop_y - start_y);
+
     {
         for(; start_y < stop_y; start_y++)
         {
-            bitCursorA = (((shiftAY + offsY)*imgA->getIWidth() + shiftAX)*imgA->myNormalizator.getEffectiveBitCount());
-            bitCursorB = (((shiftBY + offsY)*imgB->getIWidth() + shiftBX)*imgB->myNormalizator.getEffectiveBitCount());
+            bitCursorA = (((quint64)(shiftAY + offsY)*imgA->getIWidth() + shiftAX)*readerA.getEffectiveBitCount());
+            bitCursorB = (((quint64)(shiftBY + offsY)*imgB->getIWidth() + shiftBX)*readerB.getEffectiveBitCount());
 
             offsAX = 0;
             offsX = 0;
@@ -582,8 +1120,8 @@ void CWorker_ImageComparator::process()
 
             for(auX = start_x; auX < stop_x; auX++)
             {
-                imgA->myNormalizator.getPixelValue(bitCursorA, pA);
-                imgB->myNormalizator.getPixelValue(bitCursorB, pB);
+                readerA.getPixelValue(bitCursorA, pA);
+                readerB.getPixelValue(bitCursorB, pB);
 
                 resBuffPtr[4*(offsAY*compResult->getIWidth() + offsAX)    ] += pA[0];
                 resBuffPtr[4*(offsAY*compResult->getIWidth() + offsAX) + 1] += pA[1];
@@ -606,26 +1144,28 @@ void CWorker_ImageComparator::process()
 
                 offsAX+=hFlipMod;
                 offsX++;
-                bitCursorA += imgA->myNormalizator.getColumnStride();
-                bitCursorB += imgB->myNormalizator.getColumnStride();
+                bitCursorA += readerA.getColumnStride();
+                bitCursorB += readerB.getColumnStride();
             }
             offsAY+=vFlipMod;
             offsY++;
-            bitCursorA += imgA->myNormalizator.getRowStride();
-            bitCursorB += imgB->myNormalizator.getRowStride();
-            imgA->auxInfo = imgB->auxInfo = compResult->auxInfo = "Comparing: " + QString::number((ulong)start_y*100/stop_y) + "%";
+            bitCursorA += readerA.getRowStride();
+            bitCursorB += readerB.getRowStride();
+            if(cancelToken.isCancelled())
+            {
+                showStatusMessage("Comparison cancelled - a source image has been removed.", UI_STATUS_INFO, true);
+                goto __EXIT_POINT;
+            }
+            compResult->progress.advance(offsY);
         }
 
-        imgA->setMyState(STATE_READY);
-        imgB->setMyState(STATE_READY);
-        imgA->auxInfo = imgB->auxInfo = "";
-        Globals::addCmdToLocalQueue(CMD_REFRESH_THUMBNAILS_LIST);
-
         //statistics
         float meanSNR[4] = {0.0f, 0.0f, 0.0f, 0.0f};
         float minValue[4] = {MAX_FLOAT, MAX_FLOAT, MAX_FLOAT, MAX_FLOAT};
         float maxValue[4] = {-MAX_FLOAT, -MAX_FLOAT, -MAX_FLOAT, -MAX_FLOAT};
 
+        compResult->progress.begin(PROGRESS_STATISTICS, compResult->getIHeight());
+
         for(start_y = 0; start_y < (int)compResult->getIHeight(); start_y++)
         {
             for(start_x = 0; start_x < (int)compResult->getIWidth(); start_x++)
@@ -659,7 +1199,7 @@ void CWorker_ImageComparator::process()
                 if(resBuffPtr[4*(start_y*compResult->getIWidth() + start_x) +3] > maxValue[3])
                     maxValue[3] = resBuffPtr[4*(start_y*compResult->getIWidth() + start_x) +3];
             }
-            compResult->auxInfo = "Statistics: " + QString::number((ulong)start_y*100/compResult->getIHeight()) + "%";
+            compResult->progress.advance(start_y + 1);
         }
         meanSNR[0]/= compResult->getIWidth()*compResult->getIHeight();
         meanSNR[1]/= compResult->getIWidth()*compResult->getIHeight();
@@ -702,7 +1242,7 @@ void CWorker_ImageComparator::process()
 
     compResult->setZoomFactor(0.0f);
     compResult->setMyState(STATE_READY);
-    compResult->auxInfo = "";
+    compResult->progress.end();
     showStatusMessage("Comparation finished.", UI_STATUS_INFO, true);
 
     compResult->need_thumbnail_refresh = true;
@@ -712,18 +1252,10 @@ void CWorker_ImageComparator::process()
     emit finished();
 
 __EXIT_POINT:
-    if(imgA->imgSource == SOURCE_FILE)
-    {
-        imgA->myNormalizator.setNativeDataPtr(0);
-    }
-
-    if(imgB->imgSource == SOURCE_FILE)
-    {
-        imgB->myNormalizator.setNativeDataPtr(0);
-    }
+    imgA->unlockData();
+    imgB->unlockData();
 
 __EXIT_IMMEDIATE:
-    Globals::toolThreadSlot.unlock();
     Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
  return;
 }
@@ -744,19 +1276,16 @@ CWorker_ImageRecaster::CWorker_ImageRecaster(const QObject *parent, float gain[1
 
 void CWorker_ImageRecaster::process()
 {
-    if(!Globals::toolThreadSlot.tryLock())
-    {
-      Globals::addCmdToLocalQueue(CMD_SHOW_MSGBOX_TOOL_SLOT_BUSY);
-      return;
-    }
-
     QSharedPointer<CImgContext> recastResult = QSharedPointer<CImgContext>(new CImgContext());
-    QSharedPointer<CNativeData> nativeResult = QSharedPointer<CNativeData>(new CNativeData());
+    QSharedPointer<CNativeData> nativeResult;
 
-    QByteArray data;
+    CNormalizator reader;
+    QSharedPointer<CNativeData> data;
+    QString readerLog;
+    CCancelToken cancelToken;
     quint32 start_x, start_y, stop_x, stop_y;
-    BitIndexAndCount bic;
-    quint32 bitCursor, offsX, offsY, offsYD, auX;
+    quint64 bitCursor;
+    quint32 offsX, offsY, offsYD, auX;
     quint32 hFlipMod, vFlipMod;
     float*  resBuffPtr;
     float   p[4];
@@ -768,36 +1297,25 @@ void CWorker_ImageRecaster::process()
     if(imgCtx.isNull())
          goto __EXIT_IMMEDIATE;
 
-    if((imgCtx->getMyState() != STATE_READY))
-        goto __EXIT_IMMEDIATE;
+    //The recast is pointless once the source is removed.
+    cancelToken.linkTo(imgCtx->getCancelToken());
 
-    imgCtx->setMyState(STATE_BUSY);
-    Globals::addCmdToLocalQueue(CMD_REFRESH_THUMBNAILS_LIST);
+    //Shared access: the image stays pickable and viewable, writers (spill) wait for the end.
+    imgCtx->lockDataForRead(-1);
 
-    recastResult->pendingFlag(PENDING_FLAG_LOCKED); // must pass
-
-    imgCtx->auxInfo = recastResult->auxInfo = "Recasting...";
+    if(imgCtx->getMyState() != STATE_READY)
+        goto __EXIT_POINT;
 
-    if(imgCtx->imgSource == SOURCE_FILE)
+    if(imgCtx->setupReader(reader, data, readerLog) != RES_OK)
     {
-        data = imgCtx->getVisualData();
-        imgCtx->myNormalizator.setNativeDataPtr(data.data());
-        imgCtx->myNormalizator.resetMasks();
-        bic.bitIndex=0; bic.bitsCount=8;
-        imgCtx->myNormalizator.addBLUEBitsMask(BitIndexAndCount(bic));
-        imgCtx->myNormalizator.setBLUEType(NORM_IUNSIGNED);
-        bic.bitIndex=8; bic.bitsCount=8;
-        imgCtx->myNormalizator.addGREENBitsMask(BitIndexAndCount(bic));
-        imgCtx->myNormalizator.setGREENType(NORM_IUNSIGNED);
-        bic.bitIndex=16; bic.bitsCount=8;
-        imgCtx->myNormalizator.addREDBitsMask(BitIndexAndCount(bic));
-        imgCtx->myNormalizator.setREDType(NORM_IUNSIGNED);
-        bic.bitIndex=24; bic.bitsCount=8;
-        imgCtx->myNormalizator.addALPHABitsMask(BitIndexAndCount(bic));
-        imgCtx->myNormalizator.setALPHAType(NORM_IUNSIGNED);
-        imgCtx->myNormalizator.adjustCapacity();
+        showStatusMessage("Recast aborted - " + readerLog, UI_STATUS_ERROR, true);
+        goto __EXIT_POINT;
     }
 
+    recastResult->pendingFlag(PENDING_FLAG_LOCKED); // must pass
+
+    recastResult->progress.begin(PROGRESS_RECASTING, 0);
+
     start_x = 0;
     start_y = 0;
     stop_x  = imgCtx->getIWidth();
@@ -810,10 +1328,16 @@ void CWorker_ImageRecaster::process()
     recastResult->setIHeight(stop_y - start_y);
     recastResult->setMyState(STATE_BUSY);
     recastResult->myPixelFormat = "f R32 G32 B32 A32";
+    recastResult->setToolOutput(true);
     recastResult->myNotes += "Recast from: " + imgCtx->getMyName();
 
-    nativeResult->getData().fill(0, recastResult->getIWidth()*recastResult->getIHeight()*16);
-    resBuffPtr = (float*)nativeResult->getData().data();
+    nativeResult = QSharedPointer<CNativeData>(new CNativeData(recastResult->getIWidth()*recastResult->getIHeight()*16, true));
+    if(nativeResult->getData().isEmpty())
+    {
+        showStatusMessage("Recast aborted - out of memory.", UI_STATUS_ERROR, true);
+        goto __EXIT_POINT;
+    }
+    resBuffPtr = (float*)nativeResult->getDataPtr();
 
     offsX = offsY = offsYD = 0;
     vFlipMod = hFlipMod = 1;
@@ -827,17 +1351,19 @@ void CWorker_ImageRecaster::process()
         offsY = recastResult->getIHeight()-1;
     }
 
+    recastResult->progress.begin(PROGRESS_RECASTING, stop_y - start_y);
+
     {
         for(; start_y < stop_y; start_y++)
         {
-            bitCursor = ((offsYD*imgCtx->getIWidth())*imgCtx->myNormalizator.getEffectiveBitCount());
+            bitCursor = (((quint64)offsYD*imgCtx->getIWidth())*reader.getEffectiveBitCount());
             offsX = 0;
             if(hFlip)
                 offsX = recastResult->getIWidth()-1;
 
             for(auX = start_x; auX < stop_x; auX++)
             {
-                imgCtx->myNormalizator.getPixelValue(bitCursor, p);
+                reader.getPixelValue(bitCursor, p);
 
                 resBuffPtr[4*(offsY*recastResult->getIWidth() + offsX)    ] = gain[0]*p[0] + gain[1]*p[1] + gain[2]*p[2] + gain[3]*p[3] + bias[0];
                 resBuffPtr[4*(offsY*recastResult->getIWidth() + offsX) + 1] = gain[4]*p[0] + gain[5]*p[1] + gain[2]*p[2] + gain[7]*p[3] + bias[1];
@@ -846,18 +1372,19 @@ void CWorker_ImageRecaster::process()
 
                 offsX+=hFlipMod;
 
-                bitCursor += imgCtx->myNormalizator.getColumnStride();
+                bitCursor += reader.getColumnStride();
             }
 
             offsY+=vFlipMod;
             offsYD++;
-            bitCursor += imgCtx->myNormalizator.getRowStride();
-            imgCtx->auxInfo = recastResult->auxInfo = "Recasting: " + QString::number((ulong)start_y*100/stop_y) + "%";
+            bitCursor += reader.getRowStride();
+            if(cancelToken.isCancelled())
+            {
+                showStatusMessage("Recast cancelled - the source image has been removed.", UI_STATUS_INFO, true);
+                goto __EXIT_POINT;
+            }
+            recastResult->progress.advance(offsYD);
         }
-
-        imgCtx->setMyState(STATE_READY);
-        imgCtx->auxInfo = recastResult->auxInfo = "";
-        Globals::addCmdToLocalQueue(CMD_REFRESH_THUMBNAILS_LIST);
     }
 
     recastResult->attachNativeData(nativeResult);
@@ -882,7 +1409,7 @@ void CWorker_ImageRecaster::process()
 
     recastResult->setZoomFactor(0.0f);
     recastResult->setMyState(STATE_READY);
-    recastResult->auxInfo = "";
+    recastResult->progress.end();
     showStatusMessage("Recast finished.", UI_STATUS_INFO, true);
 
     recastResult->need_thumbnail_refresh = true;
@@ -893,13 +1420,132 @@ void CWorker_ImageRecaster::process()
 
 
 __EXIT_POINT:
-    if(imgCtx->imgSource == SOURCE_FILE)
-    {
-        imgCtx->myNormalizator.setNativeDataPtr(0);
-    }
+    imgCtx->unlockData();
 
 __EXIT_IMMEDIATE:
-    Globals::toolThreadSlot.unlock();
     Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
     return;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CWorker_session::CWorker_session(const QString &fileName, bool restore): CWorker(0)
+{
+    this->fileName = fileName;
+    this->restore = restore;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_session::process()
+{
+    if(restore)
+    {
+        if(CSession::restore(fileName) != RES_OK)
+            showStatusMessage("Error restoring the session: " + fileName, UI_STATUS_ERROR, true);
+    }
+    else
+    {
+        if(CSession::save(fileName) == RES_OK)
+            showStatusMessage("Session has been saved: " + fileName, UI_STATUS_INFO, true);
+        else
+            showStatusMessage("Error saving the session: " + fileName, UI_STATUS_ERROR, true);
+    }
+
+    emit iAmDone();
+    emit finished();
+    Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CWorker_spillImage::CWorker_spillImage(const QSharedPointer<CImgContext> &imgContextPtr): CWorker(0)
+{
+    this->imgContextPtr = imgContextPtr;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_spillImage::process()
+{
+    //Exclusive access; an image being read (saved, compared...) is left for a later budget check.
+    if(!imgContextPtr->lockDataForWrite())
+    {
+        imgContextPtr->setMyState(STATE_READY);
+    }
+    else
+    {
+        if(CSpillStore::spill(imgContextPtr) != RES_OK)
+        {
+            //Do not retry on every budget check, drop images instead.
+            Globals::spillEnabled = false;
+            imgContextPtr->setMyState(STATE_READY);
+            showStatusMessage("Error writing the spill file, spilling is DISABLED.", UI_STATUS_ERROR, true);
+        }
+        imgContextPtr->unlockData();
+    }
+
+    Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, imgContextPtr);
+
+    emit iAmDone();
+    emit finished();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+CWorker_faultIn::CWorker_faultIn(const QSharedPointer<CImgContext> &imgContextPtr): CWorker(0)
+{
+    this->imgContextPtr = imgContextPtr;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+int CWorker_faultIn::getPriority()
+{
+    return Globals::isInFocus(imgContextPtr.data())?WORK_PRIORITY_FOCUS:WORK_PRIORITY_NORMAL;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CWorker_faultIn::process()
+{
+    quint32 payloadSize = imgContextPtr->spillSize;
+    char*   inBuff = CBufferPool::acquire(payloadSize);
+
+    if(inBuff && (CSpillStore::readPayload(imgContextPtr, inBuff) == RES_OK))
+    {
+        //CNativeData takes ownership of the buffer. The data is replaced, readers wait.
+        imgContextPtr->lockDataForWrite(-1);
+        CWorker_loadFromNativeData lnd(0, inBuff, payloadSize);
+        lnd.setTargetContext(imgContextPtr);
+        lnd.blockSignals(true);
+        lnd.process();
+        imgContextPtr->unlockData();
+
+        //Tiles requested while the data was being replaced were not made.
+        Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
+    }
+    else
+    {
+        CBufferPool::release(inBuff);
+    }
+
+    //The spill region is only given up once the data is back, or with the image.
+    if(imgContextPtr->getMyState() == STATE_READY)
+    {
+        CSpillStore::release(imgContextPtr);
+        imgContextPtr->dropSnapshotThumbnail();
+    }
+    else if(Globals::imgRegistry.findByContext(imgContextPtr.data()).isNull())
+    {
+        CSpillStore::release(imgContextPtr);
+    }
+    else
+    {
+        //Not decoded (cancelled or failed): the image stays spilled, selecting it tries again.
+        imgContextPtr->lockDataForWrite(-1);
+        imgContextPtr->restoreSpilled();
+        imgContextPtr->unlockData();
+        Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, imgContextPtr);
+
+        //Removed meanwhile, while it was not spilled yet (see Globals::removeImage).
+        if(Globals::imgRegistry.findByContext(imgContextPtr.data()).isNull())
+            CSpillStore::release(imgContextPtr);
+    }
+
+    emit iAmDone();
+    emit finished();
+}
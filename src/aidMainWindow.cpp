@@ -21,6 +21,12 @@
 #include "./inc/globals.h"
 #include "./inc/defines.h"
 #include "./inc/CTcpServer.h"
+#include "./inc/CSpillStore.h"
+#include "./inc/CToolQueue.h"
+#include "./inc/CStreamTable.h"
+#include "./inc/CDecodePipeline.h"
+#include "./inc/CDecodeHelpers.h"
+#include "./inc/CWorkPool.h"
 
 #ifdef QT4_HEADERS
     #include <QDesktopWidget>
@@ -36,6 +42,9 @@
     #include <QtWidgets/QInputDialog>
 #endif
 
+#include <QSet>
+#include <QTimer>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 aidMainWindow::aidMainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -65,7 +74,7 @@ aidMainWindow::aidMainWindow(QWidget *parent)
     connect(leftTopPanelPtr, SIGNAL(iHaveFocus()), rightBottomPanelPtr, SLOT(childLostFocus()));
     connect(rightBottomPanelPtr, SIGNAL(iHaveFocus()), leftTopPanelPtr, SLOT(childLostFocus()));
 
-    connect(&commandQueuePoller,SIGNAL(timeout()), this, SLOT(commandExecutor()));
+    Globals::commandQueue.setReceiver(this, "commandExecutor");
 
     myLayout.setSpacing(0);
     myLayout.setContentsMargins(0, 0, 0, 0);
@@ -89,96 +98,116 @@ void  aidMainWindow::delayedInit()
 {
     leftTopPanelPtr->applyFontScale();
     rightBottomPanelPtr->applyFontScale();
-    commandQueuePoller.start(250);
     myTCPServer.delayedInit();
     myTCPServer.restart();
+
+    if(Globals::decodeHelperCount > 0)
+    {
+        CDecodeHelpers::start(Globals::decodeHelperCount);
+        actDecodeHelpers->setChecked(CDecodeHelpers::isEnabled());
+    }
+
+    if(!Globals::watchDirectory.isEmpty())
+    {
+        if(myDirWatcher.start(Globals::watchDirectory, Globals::watchPostAction, Globals::watchArchiveDirectory) == RES_OK)
+            actWatchDirectory->setChecked(true);
+    }
+
+    if(!Globals::sessionFile.isEmpty() && QFile::exists(Globals::sessionFile))
+    {
+        CWorker_session* newWorker = new CWorker_session(Globals::sessionFile, true);
+        newWorker->selfStart();
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-#define REMOVE_IMG_CTX_HOOK \
-if(Globals::sharedPointerHooks.count((*i).auxParam)>0)\
-    Globals::sharedPointerHooks.take((*i).auxParam)
-
 void  aidMainWindow::commandExecutor()
 {
-    QVector<cmdS>::iterator i;
-    QVector<cmdS> artifacts;
+    QVector<cmdS> commands = Globals::commandQueue.takeAll();
+    QSet<const void*> thumbnailsDone;
+    CImgContext* imgCtx;
     int pflag;
+    bool budgetCheck = false;
+    bool refreshViews = false;
+    bool showFrames = false;
+    bool refreshLists = false;
+    QList<QSharedPointer<CImgContext> > images;
 
-    if(!Globals::commandQueueLock.tryLock(10)) return;
-
-    i = Globals::commandQueue.begin();
-    while(i != Globals::commandQueue.end())
+    for(int i = 0; i < commands.size(); i++)
     {
-        switch((*i).commandID)
+        imgCtx = commands.at(i).imgPtr.data();
+
+        switch(commands.at(i).commandID)
         {
+            case CMD_PUBLISH_IMAGES:
+                //The images decoded by the pipeline go through the same steps as the others, in this batch.
+                {
+                    QList<QSharedPointer<CImgContext> > published = CDecodePipeline::takePublished();
+                    for(int j = 0; j < published.size(); j++)
+                    {
+                        cmdS next;
+                        next.commandID = CMD_CREATE_RENDERABLE_DATA;
+                        next.auxParam = (quintptr)published.at(j).data();
+                        next.imgPtr = published.at(j);
+                        commands.append(next);
+                    }
+                }
+            break;
             case CMD_CREATE_RENDERABLE_DATA:
-                pflag = ((CImgContext*)(*i).auxParam)->pendingFlag(PENDING_FLAG_LOCKED);
+                //A bounded wait for the image lock; an image held by a worker is retried later.
+                pflag = imgCtx->pendingFlag(PENDING_FLAG_LOCKED, UI_IMAGE_LOCK_WAIT_MS);
 
-                if(pflag == PENDING_FLAG_MARKED_FOR_DELETION)
+                if(pflag == PENDING_FLAG_UNDEFINED)
                 {
-
+                    deferredCommands.append(commands.at(i));
                     break;
                 }
-                else if(pflag == PENDING_FLAG_UNDEFINED)
+
+                if(pflag == PENDING_FLAG_MARKED_FOR_DELETION)
                 {
-                    artifacts.append(*i);
+                    imgCtx->pendingFlag(PENDING_FLAG_MARKED_FOR_DELETION, -1);
                     break;
                 }
-                else
+
+                if(!imgCtx->need_thumbnail_refresh)
                 {
-                    if(!((CImgContext*)(*i).auxParam)->need_thumbnail_refresh)
-                    {
-                       while(((CImgContext*)(*i).auxParam)->pendingFlag(PENDING_FLAG_RELEASED)==PENDING_FLAG_UNDEFINED); //should not stall - CMD_CREATE_RENDERABLE_DATA can be queued after processing
-                       REMOVE_IMG_CTX_HOOK;
-                       break;
-                    }
+                    imgCtx->pendingFlag(PENDING_FLAG_RELEASED, -1);
+                    break;
                 }
 
             case CMD_CREATE_THUMBNAIL:
-                 pflag = ((CImgContext*)(*i).auxParam)->pendingFlag(PENDING_FLAG_LOCKED);
+                 pflag = imgCtx->pendingFlag(PENDING_FLAG_LOCKED, UI_IMAGE_LOCK_WAIT_MS);
 
-                 if(pflag == PENDING_FLAG_MARKED_FOR_DELETION)
+                 if(pflag == PENDING_FLAG_UNDEFINED)
                  {
-                     REMOVE_IMG_CTX_HOOK;
+                     deferredCommands.append(commands.at(i));
                      break;
                  }
-                 else if(pflag == PENDING_FLAG_UNDEFINED)
+
+                 if(pflag == PENDING_FLAG_MARKED_FOR_DELETION)
                  {
-                     artifacts.append(*i);
+                     imgCtx->pendingFlag(PENDING_FLAG_MARKED_FOR_DELETION, -1);
                      break;
                  }
-                 else
-                 {
 
-                    ((CImgContext*)(*i).auxParam)->makeThumbnail();
-                    if(Globals::imgContextListLock.tryLock())
-                    {
-                        leftTopPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
-                        rightBottomPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
-                        while(((CImgContext*)(*i).auxParam)->pendingFlag(PENDING_FLAG_RELEASED)==PENDING_FLAG_UNDEFINED); //should not stall
-                        Globals::imgContextListLock.unlock();
-
-                        REMOVE_IMG_CTX_HOOK;
-                    }
-                    else
-                        artifacts.append(*i);
+                 //One thumbnail per image and batch.
+                 if(!thumbnailsDone.contains(imgCtx))
+                 {
+                     imgCtx->makeThumbnail();
+                     thumbnailsDone.insert(imgCtx);
                  }
+                 imgCtx->pendingFlag(PENDING_FLAG_RELEASED, -1);
+                 refreshLists = true;
+                 budgetCheck = true;
             break;
             case CMD_REFRESH_VIEW_PANLES:
-                leftTopPanelPtr->refreshViewPanel();
-                rightBottomPanelPtr->refreshViewPanel();;
+                refreshViews = true;
+            break;
+            case CMD_SHOW_DECODED_FRAMES:
+                showFrames = true;
             break;
-
             case CMD_REFRESH_THUMBNAILS_LIST:
-                 if(Globals::imgContextListLock.tryLock())
-                 {
-                     leftTopPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
-                     rightBottomPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
-                     Globals::imgContextListLock.unlock();
-                 }
-                 else
-                    artifacts.append(*i);
+                refreshLists = true;
             break;
             case CMD_SHOW_MSGBOX_SAVE_GFILE_FAILED:
                 QMessageBox::critical(Globals::mainWindowPtr, "Error", "Failed to save to a graphics file.");
@@ -186,46 +215,66 @@ void  aidMainWindow::commandExecutor()
             case CMD_SHOW_MSGBOX_SAVE_RIC_FAILED:
                 QMessageBox::critical(Globals::mainWindowPtr, "Error", "Failed to save to the RIC file.");
             break;
-            case CMD_SHOW_MSGBOX_TOOL_SLOT_BUSY:
-                QMessageBox::information(Globals::mainWindowPtr, "Tool thread slot", "It seems that one of the tools is still running.\nPlease wait until the processing ends and then try again.");
-            break;
             case CMD_ADD_STATUS_MESSAGE:
                 myStatusBar.popAndShow();
             break;
             case CMD_REMOVE_ALL:
-                   if(Globals::imgContextListLock.tryLock())
-                   {
-                       QSharedPointer<CImgContext> tmpHeader = Globals::imgListHeadPtr;
-                       Globals::imgListHeadPtr = QSharedPointer<CImgContext>();
-                       Globals::imgCount = 0;
-                       Globals::removeAll(tmpHeader);
-                       Globals::commandQueue.clear();
-                       Globals::sharedPointerHooks.clear();
-                       leftTopPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
-                       rightBottomPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
-                       i = Globals::commandQueue.end();
-                       Globals::imgContextListLock.unlock();
-                   }
-                   else
-                      artifacts.append(*i);
+                   Globals::removeAll();
+                   CSpillStore::clear();
+                   CStreamTable::clear();
+                   //The rest of the batch refers to the removed images.
+                   commands.clear();
+                   deferredCommands.clear();
+                   refreshLists = true;
            break;
         }
+    }
 
-        if(i!= Globals::commandQueue.end())
-            i = Globals::commandQueue.erase(i);
+    //Refresh commands are coalesced: the panels are redrawn once per batch.
+    if(refreshLists)
+    {
+        images = Globals::imgRegistry.snapshot();
+        leftTopPanelPtr->refreshThumbnailsList(images);
+        rightBottomPanelPtr->refreshThumbnailsList(images);
     }
-    Globals::commandQueue.clear();
-    Globals::commandQueue = artifacts;
-    Globals::commandQueueLock.unlock();
+    if(showFrames)
+    {
+        leftTopPanelPtr->showPendingFrame();
+        rightBottomPanelPtr->showPendingFrame();
+    }
+    if(refreshViews)
+    {
+        leftTopPanelPtr->refreshViewPanel();
+        rightBottomPanelPtr->refreshViewPanel();
+    }
+
+    //Image footprints grow after loading, recheck the budget.
+    if(budgetCheck)
+        Globals::evictImages();
+
+    if(!deferredCommands.isEmpty())
+        QTimer::singleShot(UI_COMMAND_RETRY_MS, this, SLOT(retryDeferredCommands()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::retryDeferredCommands()
+{
+    QVector<cmdS> commands = deferredCommands;
+
+    deferredCommands.clear();
+    for(int i = 0; i < commands.size(); i++)
+        Globals::commandQueue.post(commands.at(i));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void aidMainWindow::refreshThumbnailsLists()
 {
-    leftTopPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
+    QList<QSharedPointer<CImgContext> > images = Globals::imgRegistry.snapshot();
+
+    leftTopPanelPtr->refreshThumbnailsList(images);
     if(dualPanelMode)
     {
-        rightBottomPanelPtr->refreshThumbnailsList(Globals::imgListHeadPtr);
+        rightBottomPanelPtr->refreshThumbnailsList(images);
     }
 }
 
@@ -371,6 +420,21 @@ void aidMainWindow::createMenu()
         connect(actSaveAs, SIGNAL(triggered()), this, SLOT(menuApp_SaveAs()));
         menuApplication->addAction(actSaveAs);
 
+        actExportAll  = new QAction("Export all images", this);
+        actExportAll->setIcon(QIcon(":/icos/save.png"));
+        connect(actExportAll, SIGNAL(triggered()), this, SLOT(menuApp_ExportAll()));
+        menuApplication->addAction(actExportAll);
+
+        actSaveSession  = new QAction("Save session", this);
+        actSaveSession->setIcon(QIcon(":/icos/save.png"));
+        connect(actSaveSession, SIGNAL(triggered()), this, SLOT(menuApp_SaveSession()));
+        menuApplication->addAction(actSaveSession);
+
+        actRestoreSession  = new QAction("Restore session", this);
+        actRestoreSession->setIcon(QIcon(":/icos/open.png"));
+        connect(actRestoreSession, SIGNAL(triggered()), this, SLOT(menuApp_RestoreSession()));
+        menuApplication->addAction(actRestoreSession);
+
         actRemoveAll = new QAction("Remove all", this);
         actRemoveAll->setIcon(QIcon(":/icos/remove_all.png"));
         connect(actRemoveAll, SIGNAL(triggered()), this, SLOT(menuApp_RemoveAll()));
@@ -378,6 +442,14 @@ void aidMainWindow::createMenu()
 
         menuApplication->addSeparator();
 
+        actWatchDirectory = new QAction("Watch a directory", this);
+        actWatchDirectory->setCheckable(true);
+        actWatchDirectory->setChecked(false);
+        connect(actWatchDirectory, SIGNAL(triggered()), this, SLOT(menuApp_WatchDirectory()));
+        menuApplication->addAction(actWatchDirectory);
+
+        menuApplication->addSeparator();
+
         actExit  = new QAction("&Exit", this);
         actExit->setIcon(QIcon(":/icos/exit.png"));
         connect(actExit, SIGNAL(triggered()), this, SLOT(menuExit()));
@@ -433,6 +505,16 @@ void aidMainWindow::createMenu()
         connect(actChangeMaxImagesNumber, SIGNAL(triggered()), this, SLOT(menuView_ChangeImageCountLimit()));
         menuView->addAction(actChangeMaxImagesNumber);
 
+        actChangeMemoryBudget = new QAction("Loaded images memory budget", this);
+        actChangeMemoryBudget->setIcon(QIcon(":/icos/dot.png"));
+        connect(actChangeMemoryBudget, SIGNAL(triggered()), this, SLOT(menuView_ChangeMemoryBudget()));
+        menuView->addAction(actChangeMemoryBudget);
+
+        actShowMemoryUsage = new QAction("Memory usage", this);
+        actShowMemoryUsage->setIcon(QIcon(":/icos/dot.png"));
+        connect(actShowMemoryUsage, SIGNAL(triggered()), this, SLOT(menuView_ShowMemoryUsage()));
+        menuView->addAction(actShowMemoryUsage);
+
         actChangeAutoScaleOnLoad = new QAction("Image auto-scale on load", this);
         actChangeAutoScaleOnLoad->setCheckable(true);
         actChangeAutoScaleOnLoad->setChecked(true);
@@ -466,6 +548,25 @@ void aidMainWindow::createMenu()
         connect(actChangeSocketTimeout, SIGNAL(triggered()), this, SLOT(menuNetwork_ChangeSocketTimeout()));
         menuNetwork->addAction(actChangeSocketTimeout);
 
+        menuNetwork->addSeparator();
+
+        actStreamMode = new QAction("Stream mode (newest frame wins)", this);
+        actStreamMode->setCheckable(true);
+        actStreamMode->setChecked(false);
+        connect(actStreamMode, SIGNAL(triggered()), this, SLOT(menuNetwork_StreamMode()));
+        menuNetwork->addAction(actStreamMode);
+
+        actDecodeHelpers = new QAction("Out-of-process decoding", this);
+        actDecodeHelpers->setCheckable(true);
+        actDecodeHelpers->setChecked(false);
+        connect(actDecodeHelpers, SIGNAL(triggered()), this, SLOT(menuNetwork_DecodeHelpers()));
+        menuNetwork->addAction(actDecodeHelpers);
+
+        actShowDecodePipeline = new QAction("Decode pipeline", this);
+        actShowDecodePipeline->setIcon(QIcon(":/icos/dot.png"));
+        connect(actShowDecodePipeline, SIGNAL(triggered()), this, SLOT(menuNetwork_ShowDecodePipeline()));
+        menuNetwork->addAction(actShowDecodePipeline);
+
     //Tools
     menuTools = menuBar()->addMenu("&Tools");
 
@@ -484,6 +585,18 @@ void aidMainWindow::createMenu()
         connect(actDataComparator, SIGNAL(triggered()), this, SLOT(menuTools_DataComparator()));
         menuTools->addAction(actDataComparator);
 
+        menuTools->addSeparator();
+
+        actShowToolJobs = new QAction("Tool jobs", this);
+        actShowToolJobs->setIcon(QIcon(":/icos/dot.png"));
+        connect(actShowToolJobs, SIGNAL(triggered()), this, SLOT(menuTools_ShowToolJobs()));
+        menuTools->addAction(actShowToolJobs);
+
+        actChangeToolConcurrency = new QAction("Tool concurrency limit", this);
+        actChangeToolConcurrency->setIcon(QIcon(":/icos/dot.png"));
+        connect(actChangeToolConcurrency, SIGNAL(triggered()), this, SLOT(menuTools_ChangeToolConcurrency()));
+        menuTools->addAction(actChangeToolConcurrency);
+
     //Help
     menuHelp = menuBar()->addMenu("&Help");
 
@@ -617,13 +730,8 @@ void aidMainWindow::menuApp_LoadRAW()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void aidMainWindow::menuApp_SaveAs(panelID pID)
 {
-
-    if(!Globals::imgContextListLock.tryLock(100))
-        return;
-
     //grab a shared pointer
     QSharedPointer<CImgContext> imgPtr = (pID == panelLeftTop)?leftTopPanelPtr->getSelectedImage():rightBottomPanelPtr->getSelectedImage();
-    Globals::imgContextListLock.unlock();
 
     if(imgPtr.isNull())
     {
@@ -637,7 +745,9 @@ void aidMainWindow::menuApp_SaveAs(panelID pID)
     QString filterStr = "Raw image container (*.ric);;";
      filterStr += "Portable Network Graphics (*.png);;";
      filterStr += "Joint Photographic Experts Group (*.jpg);;";
-     filterStr += "Windows Bitmap (*.bmp)";
+     filterStr += "Windows Bitmap (*.bmp);;";
+     filterStr += "Portable float map (*.pfm);;";
+     filterStr += "AID tiled float (*.atf)";
 
     QString fileNameStr = fdialog.getSaveFileName(this,
                                                   "Save",  QDir::home().canonicalPath(),
@@ -653,15 +763,115 @@ void aidMainWindow::menuApp_SaveAs(panelID pID)
         CWorker_saveToRICFile* newWorker = new CWorker_saveToRICFile(imgPtr,
                                                    fileName.absoluteFilePath());
         if(newWorker)
-            newWorker->selfStart();
+            CToolQueue::submit(newWorker, "Save " + fileName.fileName());
+    }
+    else if((fileName.suffix().toLower() == "pfm")||(fileName.suffix().toLower() == "atf"))
+    {
+        CWorker_saveToFloatFile* newWorker = new CWorker_saveToFloatFile(imgPtr,
+                                                   fileName.absoluteFilePath());
+        if(newWorker)
+            CToolQueue::submit(newWorker, "Save " + fileName.fileName());
     }
     else
     {
         CWorker_saveToGraphicsFile* newWorker = new CWorker_saveToGraphicsFile(imgPtr,
                                                    fileName.absoluteFilePath());
         if(newWorker)
-            newWorker->selfStart();
+            CToolQueue::submit(newWorker, "Save " + fileName.fileName());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuApp_ExportAll()
+{
+    QStringList formats = QString(EXPORT_FORMATS).split(";");
+    QString     dirName;
+    QString     format;
+    QString     filter;
+    bool        ok;
+
+    dirName = QFileDialog::getExistingDirectory(this, "Export to", QDir::home().canonicalPath());
+    if(dirName.isEmpty())
+        return;
+
+    format = QInputDialog::getItem(this, "Export all images", "Format:", formats, max(0, formats.indexOf(Globals::exportFormat)), false, &ok);
+    if(!ok)
+        return;
+
+    filter = QInputDialog::getText(this, "Export all images", "Image name filter (wildcard):", QLineEdit::Normal, Globals::exportFilter, &ok);
+    if(!ok)
+        return;
+
+    Globals::exportFormat = format;
+    Globals::exportFilter = filter;
+
+    CWorker_batchExport* newWorker = new CWorker_batchExport(dirName, format, filter);
+    CToolQueue::submit(newWorker, "Export all (" + format + ")");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuApp_SaveSession()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Save session", QDir::home().canonicalPath(), "AID session (*.aids)");
+
+    if(fileName.isEmpty())
+        return;
+    if(QFileInfo(fileName).suffix().isEmpty())
+        fileName += ".aids";
+
+    CWorker_session* newWorker = new CWorker_session(fileName, false);
+    newWorker->selfStart();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuApp_RestoreSession()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Restore session", QDir::home().canonicalPath(), "AID session (*.aids)");
+
+    if(fileName.isEmpty())
+        return;
+
+    CWorker_session* newWorker = new CWorker_session(fileName, true);
+    newWorker->selfStart();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuApp_WatchDirectory()
+{
+    QStringList postActions;
+    QString     dirName;
+    QString     postActionStr;
+    bool        ok;
+
+    if(myDirWatcher.isWorking())
+    {
+        myDirWatcher.stop();
+        actWatchDirectory->setChecked(false);
+        showStatusMessage("Directory watching is DISABLED.", UI_STATUS_NETWORK, true);
+        return;
     }
+    actWatchDirectory->setChecked(false);
+
+    dirName = QFileDialog::getExistingDirectory(this, "Directory to watch", QDir::home().canonicalPath());
+    if(dirName.isEmpty())
+        return;
+
+    postActions << "Keep loaded files" << "Delete loaded files" << "Move loaded files to an archive directory";
+    postActionStr = QInputDialog::getItem(this, "Watch a directory", "After loading:", postActions, Globals::watchPostAction, false, &ok);
+    if(!ok)
+        return;
+
+    Globals::watchPostAction = postActions.indexOf(postActionStr);
+    if(Globals::watchPostAction == WATCH_POST_ARCHIVE)
+    {
+        Globals::watchArchiveDirectory = QFileDialog::getExistingDirectory(this, "Archive directory", dirName);
+        if(Globals::watchArchiveDirectory.isEmpty())
+            return;
+    }
+    Globals::watchDirectory = dirName;
+
+    if(myDirWatcher.start(Globals::watchDirectory, Globals::watchPostAction, Globals::watchArchiveDirectory) == RES_OK)
+        actWatchDirectory->setChecked(true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -772,21 +982,47 @@ void aidMainWindow::menuView_ChangeImageCountLimit()
     bool ok;
     int newValue =  QInputDialog::getInt(this,
                                          "Image number limit",
-                                         "Enter a new limit (1-128):",
+                                         "Images kept in memory (1-" + QString::number(IMG_COUNT_LIMIT_MAX) + ", 0 - no limit):",
                                          Globals::imgCountLimit,
-                                         1,
-                                         128,
+                                         IMG_COUNT_UNLIMITED,
+                                         IMG_COUNT_LIMIT_MAX,
                                          1,
                                          &ok);
 
     if(ok)
     {
         Globals::imgCountLimit = newValue;
-        while(Globals::imgCount > Globals::imgCountLimit)
-            Globals::removeLastImage();
+        Globals::evictImages();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuView_ChangeMemoryBudget()
+{
+    bool ok;
+    int newValue =  QInputDialog::getInt(this,
+                                         "Memory budget",
+                                         "Enter a new budget for all loaded images in MB.\nThe least recently viewed unpinned images are evicted first.",
+                                         Globals::imgMemoryBudgetMB,
+                                         1,
+                                         IMG_MEMORY_BUDGET_MAX_MB,
+                                         64,
+                                         &ok);
+
+    if(ok)
+    {
+        Globals::imgMemoryBudgetMB = newValue;
+        Globals::evictImages();
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuView_ShowMemoryUsage()
+{
+    qwMemoryDialog* newHandler = new qwMemoryDialog();
+    newHandler->show();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void aidMainWindow::menuNetwork_ChangeSocketTimeout()
 {
@@ -806,6 +1042,50 @@ void aidMainWindow::menuNetwork_ChangeSocketTimeout()
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuNetwork_ShowDecodePipeline()
+{
+    qwPipelineDialog* newHandler = new qwPipelineDialog();
+    newHandler->show();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuNetwork_StreamMode()
+{
+    setStreamMode(actStreamMode->isChecked());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::setStreamMode(bool enabled)
+{
+    Globals::streamMode = enabled;
+    actStreamMode->setChecked(enabled);
+
+    if(Globals::streamMode)
+        showStatusMessage("Stream mode is ON - frames received under a listed name replace it.", UI_STATUS_NETWORK, true);
+    else
+        showStatusMessage("Stream mode is OFF.", UI_STATUS_NETWORK, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuNetwork_DecodeHelpers()
+{
+    if(CDecodeHelpers::isEnabled())
+    {
+        CDecodeHelpers::stop();
+        showStatusMessage("Out-of-process decoding is OFF.", UI_STATUS_NETWORK, true);
+    }
+    else
+    {
+        CDecodeHelpers::start((Globals::decodeHelperCount > 0)?Globals::decodeHelperCount:CWorkPool::getThreadCount());
+        if(CDecodeHelpers::isEnabled())
+            showStatusMessage("Out-of-process decoding is ON - " + QString::number(CDecodeHelpers::getHelperCount()) + " helper(s).", UI_STATUS_NETWORK, true);
+        else
+            showStatusMessage("Decode helpers could not be started.", UI_STATUS_ERROR, true);
+    }
+    actDecodeHelpers->setChecked(CDecodeHelpers::isEnabled());
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void aidMainWindow::menuView_ChangeAutoScaleOnLoad()
 {
@@ -846,7 +1126,6 @@ void aidMainWindow::menuView_ShowToolbar()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void aidMainWindow::menuTools_ReinterpretData()
 {
-    QMutexLocker lock(&Globals::imgContextListLock);
     qwReinterpretDialog  *reinterpretDataDialogPtr;
 
     if(Globals::activePanel == panelLeftTop)
@@ -874,7 +1153,6 @@ void aidMainWindow::menuTools_ReinterpretData()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void aidMainWindow::menuTools_RecastData()
 {
-    QMutexLocker lock(&Globals::imgContextListLock);
     qwRecastDataDialog  *recastDataDialogPtr;
 
     if(Globals::activePanel == panelLeftTop)
@@ -917,8 +1195,6 @@ void aidMainWindow::menuTools_DataComparator()
         return;
     }
 
-
-    QMutexLocker lock(&Globals::imgContextListLock);
     if((!leftTopPanelPtr->getCurrentImage().isNull())&&(!rightBottomPanelPtr->getCurrentImage().isNull()))
     {
         imageComparatorDialogPtr = new qwImageComparatorDialog(this, leftTopPanelPtr->getCurrentImage(), rightBottomPanelPtr->getCurrentImage());
@@ -929,6 +1205,33 @@ void aidMainWindow::menuTools_DataComparator()
 
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuTools_ShowToolJobs()
+{
+    qwToolJobsDialog* newHandler = new qwToolJobsDialog();
+    newHandler->show();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void aidMainWindow::menuTools_ChangeToolConcurrency()
+{
+    bool ok;
+    int newValue =  QInputDialog::getInt(this,
+                                         "Tool concurrency limit",
+                                         "Enter the number of tools running at once (0 - one per worker thread).\nThe remaining tools wait in the queue.",
+                                         Globals::toolConcurrencyLimit,
+                                         0,
+                                         TOOL_CONCURRENCY_MAX,
+                                         1,
+                                         &ok);
+
+    if(ok)
+    {
+        Globals::toolConcurrencyLimit = newValue;
+        CToolQueue::dispatch();
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void aidMainWindow::menuHelpAboutaid()
 {
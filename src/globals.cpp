@@ -20,30 +20,42 @@
 #include "./inc/globals.h"
 #include "./inc/defines.h"
 #include "./inc/CImgContext.h"
+#include "./inc/CSpillStore.h"
+#include "./inc/Threads.h"
 
 #include <QMutex>
+#include <QThread>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-QMutex                                    Globals::commandQueueLock(QMutex::NonRecursive);
-QVector<cmdS>                             Globals::commandQueue;
+CCommandQueue                             Globals::commandQueue;
 QMutex                                    Globals::statusMsgQueueLock(QMutex::NonRecursive);
 QVector<statusBarMsg>                     Globals::statusMsgQueue;
 QMainWindow*                              Globals::mainWindowPtr;
 QApplication*                             Globals::myApp;
 int                                       Globals::fontSizeMul                                            = 1;
-QMutex                                    Globals::imgContextListLock(QMutex::NonRecursive);
-QSharedPointer<CImgContext>               Globals::imgListHeadPtr;
+CImgRegistry                              Globals::imgRegistry;
 QSemaphore                                Globals::processingThreadTrimmer(COM_MAX_PROCESSING_THREADS);
-quint32                                   Globals::imgCount                                               = 0;
 quint32                                   Globals::imgCountAbs                                            = 0;
-quint32                                   Globals::imgCountLimit                                          = 10;
+quint32                                   Globals::imgCountLimit                                          = IMG_COUNT_UNLIMITED;
+quint32                                   Globals::imgMemoryBudgetMB                                      = IMG_MEMORY_BUDGET_DEFAULT_MB;
+bool                                      Globals::spillEnabled                                           = true;
+QString                                   Globals::spillDirectory;
 qint32                                    Globals::option_colorBase                                       = 10;
 quint16                                   Globals::serverPort                                             = COM_DEFAULT_PORT;
 quint32                                   Globals::idleSocketTimeoutInSecs                                = COM_TIMEOUT_SEC;
+QString                                   Globals::watchDirectory;
+QString                                   Globals::watchArchiveDirectory;
+int                                       Globals::watchPostAction                                        = WATCH_POST_KEEP;
+QString                                   Globals::exportDirectory;
+QString                                   Globals::exportFormat                                           = "png";
+QString                                   Globals::exportFilter                                           = "*";
+QString                                   Globals::sessionFile;
 panelID                                   Globals::activePanel                                            = panelLeftTop;
 QLabel*                                   Globals::statusBarPtr                                           = NULL;
 bool                                      Globals::imageRecEnabled                                        = true;
 bool                                      Globals::autoScaleOnLoad                                        = true;
+bool                                      Globals::streamMode                                             = false;
+int                                       Globals::decodeHelperCount                                      = 0;
 bool                                      Globals::sharedViewFlagsEnabled                                 = false;
 bool                                      Globals::sharedPositionEnabled                                  = false;
 bool                                      Globals::sharedZoomEnabled                                      = false;
@@ -53,75 +65,57 @@ quint32                                   Globals::sharedViewFlags
 quint8                                    Globals::sharedMul[3]                                           = {1, 1, 1};
 quint8                                    Globals::sharedDiv[3]                                           = {1, 1, 1};
 quint8                                    Globals::sharedBias[3]                                          = {1, 1, 1};
-QMap<int, QSharedPointer<CImgContext> >   Globals::sharedPointerHooks;
-QMutex                                    Globals::toolThreadSlot;
+quint32                                   Globals::toolConcurrencyLimit                                   = 0;
+QMutex                                    Globals::focusLock(QMutex::NonRecursive);
+const void*                               Globals::focusContext[FOCUS_SLOT_COUNT]                         = {NULL, NULL, NULL};
+QString                                   Globals::focusName[FOCUS_SLOT_COUNT];
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void registryRenameHook(const void *imgContextPtr, const QString &newName)
+{
+    Globals::imgRegistry.rename(imgContextPtr, newName);
+}
+
+void                                    (*CImgContext::renameHook)(const void*, const QString&)          = registryRenameHook;
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void Globals::addImage(const QSharedPointer<CImgContext> &newImage)
 {
     Q_ASSERT(newImage);
 
-    imgCount++;
     imgCountAbs++;
+    imgRegistry.add(newImage);
 
-    if(imgCount > imgCountLimit)
-        removeLastImage();
-
-    if(imgListHeadPtr.isNull())
-    {
-        imgListHeadPtr = newImage;
-    }
-    else
-    {
-        imgListHeadPtr->setPrevPtr(newImage);
-        newImage->setNextPtr(imgListHeadPtr);
-        imgListHeadPtr = newImage;
-    }
+    evictImages(newImage);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void Globals::removeImage(QSharedPointer<CImgContext> &anImage)
 {
-
-    if(imgCount==0)
-           return;
-
     if(anImage->pendingFlag(PENDING_FLAG_UNDEFINED) == PENDING_FLAG_MARKED_FOR_DELETION)
         return;
 
+    if(!imgRegistry.remove(anImage))
+        return;
+
     anImage->pendingFlag(PENDING_FLAG_MARKED_FOR_DELETION, -1);
-    imgCount--;
-    if(anImage == imgListHeadPtr)
-        imgListHeadPtr = anImage->getNextPtr();
-    if(!anImage->getPrevPtr().isNull())
-        anImage->getPrevPtr()->setNextPtr(anImage->getNextPtr());
-    if(!anImage->getNextPtr().isNull())
-        anImage->getNextPtr()->setPrevPtr(anImage->getPrevPtr());
-
-    anImage->setPrevPtr(QSharedPointer<CImgContext>());
-    anImage->setNextPtr(QSharedPointer<CImgContext>());
-
-    Globals::addCmdToLocalQueue(CMD_REFRESH_THUMBNAILS_LIST); //Cannot be invoked from local queue executor!
+    anImage->cancelAll();
+    if(anImage->getMyState() == STATE_SPILLED)
+        CSpillStore::release(anImage);
+
+    Globals::addCmdToLocalQueue(CMD_REFRESH_THUMBNAILS_LIST);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-void Globals::removeAll(QSharedPointer<CImgContext> &whereToStart)
+void Globals::removeAll()
 {
-    QSharedPointer<CImgContext> nextToDie, current;
-
-    current = whereToStart;
-    if(current.isNull()) return;
+    QList<QSharedPointer<CImgContext> > images = imgRegistry.takeAll();
 
-    nextToDie = current->getNextPtr();
-
-    while(current)
+    for(int i = 0; i < images.size(); i++)
     {
-        nextToDie = current->getNextPtr();
-        current->setNextPtr(QSharedPointer<CImgContext>());
-        current->setPrevPtr(QSharedPointer<CImgContext>());
-        current->pendingFlag(PENDING_FLAG_MARKED_FOR_DELETION, -1);
-        current = nextToDie;
+        images.at(i)->pendingFlag(PENDING_FLAG_MARKED_FOR_DELETION, -1);
+        images.at(i)->cancelAll();
     }
 }
 
@@ -137,23 +131,50 @@ bool Globals::isValidName(QString fileName)
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 QSharedPointer<CImgContext> Globals::findImgContextByWidget(QListWidgetItem* widgetItem)
 {
-    QSharedPointer<CImgContext> next = Globals::imgListHeadPtr;
-
     if(widgetItem == NULL)
         return QSharedPointer<CImgContext>();
 
-    while(!next.isNull())
-    {
-        if(next == (CImgContext*)(((CThumbnail*)widgetItem)->getMyParent()))
-          break;
-        next = next->getNextPtr();
-    }
+    return imgRegistry.findByContext(((CThumbnail*)widgetItem)->getMyParent());
+}
 
-    if(next != NULL)
-        if(next == Globals::imgListHeadPtr)
-            if(next != (CImgContext*)(((CThumbnail*)widgetItem)->getMyParent()))
-                next = QSharedPointer<CImgContext>();
-    return next;
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void Globals::setFocusImage(int slot, const QSharedPointer<CImgContext> &imgPtr)
+{
+    QMutexLocker lock(&focusLock);
+
+    if((slot < 0)||(slot >= FOCUS_SLOT_COUNT))
+        return;
+
+    focusContext[slot] = imgPtr.data();
+    focusName[slot] = imgPtr.isNull()?QString():imgPtr->getMyName();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool Globals::isInFocus(const CImgContext *imgPtr)
+{
+    QMutexLocker lock(&focusLock);
+
+    if(imgPtr == NULL)
+        return false;
+
+    for(int i = 0; i < FOCUS_SLOT_COUNT; i++)
+        if(focusContext[i] == imgPtr)
+            return true;
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+bool Globals::isInFocus(const QString &name)
+{
+    QMutexLocker lock(&focusLock);
+
+    if(name.isEmpty())
+        return false;
+
+    for(int i = 0; i < FOCUS_SLOT_COUNT; i++)
+        if(focusName[i] == name)
+            return true;
+    return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -162,37 +183,89 @@ void Globals::addCmdToLocalQueue(int cmdID, int auxParam)
     cmdS c1;
     c1.commandID = cmdID;
     c1.auxParam = auxParam;
-    Globals::commandQueueLock.lock();
-    Globals::commandQueue.append(c1);
-    Globals::commandQueueLock.unlock();
+    Globals::commandQueue.post(c1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void Globals::addCmdToLocalQueue(int cmdID, const QSharedPointer<CImgContext> &auxParam)
 {
-    Globals::sharedPointerHooks.insertMulti((quintptr)auxParam.data(), QSharedPointer<CImgContext>(auxParam));
     cmdS c1;
     c1.commandID = cmdID;
     c1.auxParam = (quintptr)auxParam.data();
-    Globals::commandQueueLock.lock();
-    Globals::commandQueue.append(c1);
-    Globals::commandQueueLock.unlock();
+    c1.imgPtr = auxParam;
+    Globals::commandQueue.post(c1);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-void Globals::removeLastImage()
+void Globals::evictImages(const QSharedPointer<CImgContext> &keep)
 {
-    QSharedPointer<CImgContext> next, current;
-
-    current = Globals::imgListHeadPtr;
-    if(current.isNull()) return;
-
-    next = current->getNextPtr();
+    QList<QSharedPointer<CImgContext> > images = imgRegistry.snapshot();
+    QSharedPointer<CImgContext> memVictim, spillVictim;
+    QSet<const void*>           countedBlocks;
+    quint64                     totalBytes = 0;
+    quint32                     inMemoryCount = 0;
+    quint64                     budgetBytes = (quint64)imgMemoryBudgetMB << 20;
+    bool                        overBudget, overCount;
+    //Spill workers are started from the GUI thread only, workers leave it to the next check there.
+    bool                        spillHere = spillEnabled && (QThread::currentThread() == myApp->thread());
+
+    for(int i = 0; i < images.size(); i++)
+    {
+        totalBytes += images.at(i)->getMemoryFootprint(&countedBlocks);
+        if(images.at(i)->getMyState() != STATE_SPILLED)
+            inMemoryCount++;
+    }
 
-    while(!next.isNull())
+    while(true)
     {
-        current = next;
-        next = next->getNextPtr();
+        //The count cap, when set, only limits the images in memory; the byte budget rules otherwise.
+        overBudget = (totalBytes > budgetBytes);
+        overCount = (imgCountLimit != IMG_COUNT_UNLIMITED)&&(inMemoryCount > imgCountLimit);
+        if(!overBudget && !overCount)
+            break;
+
+        //Least recently viewed first; stamps grow monotonically.
+        memVictim.clear();
+        spillVictim.clear();
+        for(int i = 0; i < images.size(); i++)
+        {
+            const QSharedPointer<CImgContext> &next = images.at(i);
+
+            if((next != keep)&&
+               (!next->isPinned())&&
+               (next->getMyState() != STATE_BUSY)&&
+               (!next->getActivePanel(panelLeftTop))&&
+               (!next->getActivePanel(panelRightBottom)))
+            {
+                if((next->getMyState() != STATE_SPILLED)&&
+                   (memVictim.isNull()||(next->getLastViewStamp() < memVictim->getLastViewStamp())))
+                    memVictim = next;
+                if((next->getMyState() == STATE_READY)&&(!next->isSequence())&&
+                   (spillVictim.isNull()||(next->getLastViewStamp() < spillVictim->getLastViewStamp())))
+                    spillVictim = next;
+            }
+        }
+
+        if(spillHere && !spillVictim.isNull())
+        {
+            totalBytes -= qMin(totalBytes, spillVictim->getMemoryFootprint());
+            inMemoryCount--;
+            spillVictim->setMyState(STATE_BUSY);
+            CWorker_spillImage* newWorker = new CWorker_spillImage(spillVictim);
+            newWorker->selfStart();
+            continue;
+        }
+        if(spillEnabled && !spillHere)
+            break;
+
+        if(memVictim.isNull())
+            break;
+
+        //Shared native data is only released with its last user, count it as freed anyway.
+        totalBytes -= qMin(totalBytes, memVictim->getMemoryFootprint());
+        inMemoryCount--;
+        showStatusMessage("Memory budget: evicted " + memVictim->getMyName(), UI_STATUS_INFO, false);
+        images.removeOne(memVictim);
+        removeImage(memVictim);
     }
-    removeImage(current);
 }
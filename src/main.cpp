@@ -18,6 +18,12 @@
 */
 
 #include "./inc/aidMainWindow.h"
+#include "./inc/CSession.h"
+#include "./inc/CSpillStore.h"
+#include "./inc/CBufferPool.h"
+#include "./inc/CRenderCache.h"
+#include "./inc/CWorkPool.h"
+#include "./inc/CDecodeHelpers.h"
 #include <QApplication>
 #include <QStringList>
 
@@ -25,6 +31,10 @@
 
 int main(int argc, char *argv[])
 {
+    //A decode helper process (see CDecodeHelpers), no GUI.
+    if((argc == 3)&&(QString(argv[1]) == CL_DECODE_HELPER_PROCESS))
+        return CDecodeHelpers::helperMain(QString(argv[2]));
+
     Q_INIT_RESOURCE(resources);
 
     Globals::fontSizeMul = 2;
@@ -107,7 +117,7 @@ int main(int argc, char *argv[])
                 break;
             }
             int v=cmdArgs.at(++i).toInt();
-            if((v <=0)||(v > 128))
+            if((v <=0)||(v > (int)IMG_COUNT_LIMIT_MAX))
             {
                 SHOW_WARNING("Invalid max images value.");
                 break;
@@ -149,6 +159,110 @@ int main(int argc, char *argv[])
             }
             Globals::fontSizeMul = v+1;
         }
+        else if(cmdArgs.at(i) == CL_WATCH_DIR)
+        {
+            if(cmdArgs.size()< i+2)
+            {
+                SHOW_WARNING("Invalid watch directory argument.");
+                break;
+            }
+            Globals::watchDirectory = cmdArgs.at(++i);
+        }
+        else if(cmdArgs.at(i) == CL_WATCH_DELETE)
+        {
+            Globals::watchPostAction = WATCH_POST_DELETE;
+        }
+        else if(cmdArgs.at(i) == CL_WATCH_ARCHIVE)
+        {
+            if(cmdArgs.size()< i+2)
+            {
+                SHOW_WARNING("Invalid archive directory argument.");
+                break;
+            }
+            Globals::watchPostAction = WATCH_POST_ARCHIVE;
+            Globals::watchArchiveDirectory = cmdArgs.at(++i);
+        }
+        else if(cmdArgs.at(i) == CL_EXPORT)
+        {
+            if(cmdArgs.size()< i+3)
+            {
+                SHOW_WARNING("Invalid export arguments.");
+                break;
+            }
+            Globals::exportDirectory = cmdArgs.at(++i);
+            Globals::exportFormat = cmdArgs.at(++i).toLower();
+            if(!QString(EXPORT_FORMATS).split(";").contains(Globals::exportFormat))
+            {
+                SHOW_WARNING("Invalid export format.");
+                Globals::exportDirectory.clear();
+                break;
+            }
+        }
+        else if(cmdArgs.at(i) == CL_EXPORT_FILTER)
+        {
+            if(cmdArgs.size()< i+2)
+            {
+                SHOW_WARNING("Invalid export filter argument.");
+                break;
+            }
+            Globals::exportFilter = cmdArgs.at(++i);
+        }
+        else if(cmdArgs.at(i) == CL_MEMORY_BUDGET)
+        {
+            if(cmdArgs.size()< i+2)
+            {
+                SHOW_WARNING("Invalid memory budget argument.");
+                break;
+            }
+            int v=cmdArgs.at(++i).toInt();
+            if((v <=0)||(v > (int)IMG_MEMORY_BUDGET_MAX_MB))
+            {
+                SHOW_WARNING("Invalid memory budget value.");
+                break;
+            }
+            Globals::imgMemoryBudgetMB =v;
+        }
+        else if(cmdArgs.at(i) == CL_SPILL_DIR)
+        {
+            if(cmdArgs.size()< i+2)
+            {
+                SHOW_WARNING("Invalid spill directory argument.");
+                break;
+            }
+            Globals::spillDirectory = cmdArgs.at(++i);
+        }
+        else if(cmdArgs.at(i) == CL_NO_SPILL)
+        {
+            Globals::spillEnabled = false;
+        }
+        else if(cmdArgs.at(i) == CL_STREAM_MODE)
+        {
+            mainWindow.setStreamMode(true);
+        }
+        else if(cmdArgs.at(i) == CL_DECODE_HELPERS)
+        {
+            if(cmdArgs.size()< i+2)
+            {
+                SHOW_WARNING("Invalid decode helpers argument.");
+                break;
+            }
+            int v=cmdArgs.at(++i).toInt();
+            if((v <0)||(v > DECODE_HELPER_MAX_COUNT))
+            {
+                SHOW_WARNING("Invalid number of decode helpers.");
+                break;
+            }
+            Globals::decodeHelperCount =v;
+        }
+        else if(cmdArgs.at(i) == CL_SESSION)
+        {
+            if(cmdArgs.size()< i+2)
+            {
+                SHOW_WARNING("Invalid session file argument.");
+                break;
+            }
+            Globals::sessionFile = cmdArgs.at(++i);
+        }
     }
 
     QFont font = aid_app.font();
@@ -158,5 +272,21 @@ int main(int argc, char *argv[])
     mainWindow.delayedInit();
     mainWindow.show();
     
-    return aid_app.exec();
+    int res = aid_app.exec();
+
+    //Keep the session for the next start.
+    if(!Globals::sessionFile.isEmpty())
+        CSession::save(Globals::sessionFile);
+
+    //Export everything that has been loaded during the session.
+    if(!Globals::exportDirectory.isEmpty())
+        CWorker_batchExport::exportImages(Globals::exportDirectory, Globals::exportFormat, Globals::exportFilter);
+
+    CDecodeHelpers::stop();
+    CWorkPool::shutdown();
+    CSpillStore::clear();
+    CRenderCache::clear();
+    CBufferPool::trim();
+
+    return res;
 }
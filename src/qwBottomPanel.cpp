@@ -104,6 +104,19 @@ qwBottomPanel::qwBottomPanel(QWidget* parent): QWidget(parent)
     infoBarString.setFont(myFont);
     topRowPtr->addWidget(&infoBarString);
 
+    frameSliderPtr = new QSlider(Qt::Horizontal);
+    frameSliderPtr->setMinimum(0);
+    frameSliderPtr->setMaximum(0);
+    frameSliderPtr->setToolTip(TIP_MAIN_FRAME_SCRUBBER);
+    frameInfoString.setFont(myFont);
+    QHBoxLayout *frameScrubberLayout = new QHBoxLayout();
+    frameScrubberLayout->setContentsMargins(0, 0, 0, 0);
+    frameScrubberLayout->addWidget(frameSliderPtr);
+    frameScrubberLayout->addWidget(&frameInfoString);
+    frameScrubber.setLayout(frameScrubberLayout);
+    frameScrubber.setVisible(false);
+    topRowPtr->addWidget(&frameScrubber);
+
     linearTransformDialogPtr = new qwDialogLT(linearTransformButtonPtr, &linearTransformDialogMenu);
     linearTransformDialogMenuActionPtr = new QWidgetAction(this);
     linearTransformDialogMenuActionPtr->setDefaultWidget(linearTransformDialogPtr);
@@ -160,6 +173,7 @@ qwBottomPanel::qwBottomPanel(QWidget* parent): QWidget(parent)
 
     connect(notesDataButtonPtr, SIGNAL(clicked()), this, SLOT(showNoteBox()));
     connect(deleteImageButtonPtr, SIGNAL(clicked()), parent, SLOT(deleteCurrentImage()));
+    connect(frameSliderPtr, SIGNAL(valueChanged(int)), parent, SLOT(showFrame(int)));
 
     setLayout(myLayoutPtr);
 }
@@ -23,6 +23,7 @@
 #include "./inc/commons.h"
 #include "./inc/defines.h"
 #include "./inc/CImgContext.h"
+#include "./inc/CSpillStore.h"
 #include "./inc/aidMainWindow.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -105,6 +106,8 @@ void qwDecoratedCanvas::disableButtons()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void qwDecoratedCanvas::restoreSWButtonsState()
 {
+    restoreFrameScrubber();
+
     if(currentImgPtr.isNull())
     {
         disableButtons();
@@ -149,8 +152,14 @@ void qwDecoratedCanvas::setCurrentImage(const QSharedPointer<CImgContext> &_ptr)
 
    myBottomPanelPtr->linearTransformDialogPtr->closeMe();
 
+   Globals::setFocusImage(myID, _ptr);
+
    if(!_ptr.isNull())
+   {
+       if(_ptr->getMyState() == STATE_SPILLED)
+           CSpillStore::faultIn(_ptr);
        _ptr->SetFocus(myID);
+   }
 
    if(_ptr != currentImgPtr)
       if(!currentImgPtr.isNull())
@@ -224,9 +233,8 @@ __EXIT_POINT:
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-void qwDecoratedCanvas::refreshThumbnailsList(QSharedPointer<CImgContext> header)
+void qwDecoratedCanvas::refreshThumbnailsList(const QList<QSharedPointer<CImgContext> > &images)
 {
-    QSharedPointer<CImgContext> next;
     CThumbnail  *tmpPtr = NULL, *currentPtr = NULL;
     int         currentRow = 0;
 
@@ -238,33 +246,22 @@ void qwDecoratedCanvas::refreshThumbnailsList(QSharedPointer<CImgContext> header
     myThumbnailListPtr->blockSignals(false);
 
 
-    if(header.isNull())
+    if(images.isEmpty())
     {
        setCurrentImageSlot(NULL);
        return;
     }
 
-    if(header->need_thumbnail_refresh)
-        header->makeThumbnail();
-
-    tmpPtr = header->myThumbnail.clone();
-    if(header == currentImgPtr)
-        currentPtr = tmpPtr;
-
-    myThumbnailListPtr->addItem(reinterpret_cast<QListWidgetItem*>(tmpPtr));
-
-    next = header->getNextPtr();
-    while((next != header) && (!next.isNull()))
+    for(int i = 0; i < images.size(); i++)
     {
-        if(next->need_thumbnail_refresh)
-            next->makeThumbnail();
+        if(images.at(i)->need_thumbnail_refresh)
+            images.at(i)->makeThumbnail();
 
-        tmpPtr = next->myThumbnail.clone();
-        if(next == currentImgPtr)
+        tmpPtr = images.at(i)->myThumbnail.clone();
+        if(images.at(i) == currentImgPtr)
             currentPtr = tmpPtr;
 
         myThumbnailListPtr->addItem(reinterpret_cast<QListWidgetItem*>(tmpPtr));
-        next = next->getNextPtr();
     }
 
     if((currentRow>0)&&(currentPtr))
@@ -374,11 +371,68 @@ void qwDecoratedCanvas::refreshInfoBar()
             tmpStr += "   ZOOM: ";
             tmpStr += QString::number(currentImgPtr->getZoomFactor(), 'f', 4);
         }
+
+        if(currentImgPtr->isSequence())
+            tmpStr += "   FRAME: " + QString::number(currentImgPtr->getCurrentFrame()+1) + "/" + QString::number(currentImgPtr->getFrameCount());
+
+        if(currentImgPtr->getStreamTicket())
+            tmpStr += "   SKIPPED: " + QString::number(currentImgPtr->getStreamSkipped());
     }
 
     myBottomPanelPtr->infoBarString.setText(tmpStr);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void qwDecoratedCanvas::restoreFrameScrubber()
+{
+    QString frameInfo;
+
+    if((currentImgPtr.isNull())||(!currentImgPtr->isSequence()))
+    {
+        myBottomPanelPtr->frameScrubber.setVisible(false);
+        return;
+    }
+
+    myBottomPanelPtr->frameSliderPtr->blockSignals(true);
+    myBottomPanelPtr->frameSliderPtr->setMaximum(currentImgPtr->getFrameCount()-1);
+    myBottomPanelPtr->frameSliderPtr->setValue(currentImgPtr->getRequestedFrame());
+    myBottomPanelPtr->frameSliderPtr->setEnabled(currentImgPtr->getMyState() == STATE_READY);
+    myBottomPanelPtr->frameSliderPtr->blockSignals(false);
+    frameInfo = QString::number(currentImgPtr->getCurrentFrame()+1) + "/" + QString::number(currentImgPtr->getFrameCount());
+    if(currentImgPtr->getRequestedFrame() != currentImgPtr->getCurrentFrame())
+        frameInfo += " (decoding " + QString::number(currentImgPtr->getRequestedFrame()+1) + ")";
+    myBottomPanelPtr->frameInfoString.setText(frameInfo);
+    myBottomPanelPtr->frameScrubber.setVisible(true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void qwDecoratedCanvas::showFrame(int index)
+{
+    if(currentImgPtr.isNull())
+        return;
+
+    if(currentImgPtr->showFrame(index) == RES_ERROR)
+        showStatusMessage("Failed to decode the frame.", UI_STATUS_ERROR, true);
+
+    restoreFrameScrubber();
+    refreshInfoBar();
+
+    //The other panel may show the same sequence.
+    Globals::addCmdToLocalQueue(CMD_REFRESH_VIEW_PANLES);
+    myGridCanvasPtr->refreshView();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void qwDecoratedCanvas::showPendingFrame()
+{
+    if(currentImgPtr.isNull()||(!currentImgPtr->showPendingFrame()))
+        return;
+
+    restoreFrameScrubber();
+    refreshInfoBar();
+    myGridCanvasPtr->refreshView();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void qwDecoratedCanvas::deleteCurrentImage()
 {
@@ -410,7 +464,7 @@ void qwDecoratedCanvas::hideEvent(QHideEvent *e)
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void qwDecoratedCanvas::showEvent(QShowEvent *e)
 {
-    refreshThumbnailsList(Globals::imgListHeadPtr);
+    refreshThumbnailsList(Globals::imgRegistry.snapshot());
     refreshInfoBar();
     QWidget::showEvent(e);
 }
@@ -22,6 +22,7 @@
 #include "./inc/commons.h"
 #include "./inc/globals.h"
 #include "./inc/defines.h"
+#include "./inc/CRenderCache.h"
 
 #include <math.h>
 
@@ -53,8 +54,6 @@ const unsigned char bkg_pattern[] = {0xFF, 0xFF, 0xFE, 0x7F, 0xFC, 0x3F, 0xF8,
 ///////////////////////////////////////////////////////////////////////////////
 //Static members
 ///////////////////////////////////////////////////////////////////////////////
-QImage   qwGridCanvas::s_rollerW;
-QImage   qwGridCanvas::s_rollerH;
 quint32  qwGridCanvas::s_references;
 QPen     qwGridCanvas::s_gridPen;
 QPen     qwGridCanvas::s_gridPenT;
@@ -65,8 +64,6 @@ QPen     qwGridCanvas::s_pixelSelector;
 ///////////////////////////////////////////////////////////////////////////////
 qwGridCanvas::qwGridCanvas(QWidget *parent):QWidget(parent)
 {
-    quint32 i;
-
     //m_ImgContextPtrLock = QSharedPointer<QMutex>(new QMutex(QMutex::Recursive));
 
     //default sizing policy
@@ -82,20 +79,10 @@ qwGridCanvas::qwGridCanvas(QWidget *parent):QWidget(parent)
 
     if(s_references<1)
     {
-        //initialize rollers
-        s_rollerW = QImage(MAX_IMG_SIZE, 1, QImage::Format_RGB32);
-        s_rollerH = QImage(1, MAX_IMG_SIZE, QImage::Format_RGB32);
-
         //initialize grid pens
         s_gridPen  = QPen(QColor((quint32)GRID_COL), GRID_WIDTH,   Qt::DashLine);
         s_gridPenT = QPen(QColor((quint32)GRID_BOUND_COL), GRID_BOUND_WIDTH, Qt::DotLine);
         s_pixelSelector = QPen(QColor((quint32)PIXEL_SELECTOR_COL), GRID_WIDTH*4, Qt::DotLine);
-
-        for(i=0; i< MAX_IMG_SIZE; i++)
-        {
-            s_rollerW.setPixel(i,0,i);
-            s_rollerH.setPixel(0,i,i);
-        };
     }
 
     //wallpaper
@@ -111,6 +98,8 @@ qwGridCanvas::qwGridCanvas(QWidget *parent):QWidget(parent)
     s_references++;
 
     m_lastSourceX = m_lastSourceY = 0;
+    m_shownW = m_shownH = 0;
+    m_shownOriginX = m_shownOriginY = 0;
 
     setContextMenuPolicy(Qt::CustomContextMenu);
 
@@ -166,22 +155,22 @@ void qwGridCanvas::calcSizeParams()
 
     if(m_ImgContextPtr == NULL)
         goto __zero_return;
-    else if(m_ImgContextPtr->getRenderDataPtr() == NULL)
+    else if(!m_ImgContextPtr->isRenderable())
         goto __zero_return;
 
     if(m_ImgContextPtr->getImgOffset(axX)<=0)
-        sourceW = (min(clientW/m_zoomFactor, m_ImgContextPtr->getRenderDataPtr()->width() + m_ImgContextPtr->getImgOffset(axX)/m_zoomFactor));
-    else if(m_ImgContextPtr->getImgOffset(axX)/m_zoomFactor + m_ImgContextPtr->getRenderDataPtr()->width() -clientW/m_zoomFactor >0)
+        sourceW = (min(clientW/m_zoomFactor, m_ImgContextPtr->getIWidth() + m_ImgContextPtr->getImgOffset(axX)/m_zoomFactor));
+    else if(m_ImgContextPtr->getImgOffset(axX)/m_zoomFactor + m_ImgContextPtr->getIWidth() -clientW/m_zoomFactor >0)
         sourceW = ((clientW- m_ImgContextPtr->getImgOffset(axX))/m_zoomFactor);
     else
-        sourceW = m_ImgContextPtr->getRenderDataPtr()->width()-1;
+        sourceW = m_ImgContextPtr->getIWidth()-1;
 
     if(m_ImgContextPtr->getImgOffset(axY)<=0)
-        sourceH = (min(clientH/m_zoomFactor, m_ImgContextPtr->getRenderDataPtr()->height() + m_ImgContextPtr->getImgOffset(axY)/m_zoomFactor));
-    else if(m_ImgContextPtr->getImgOffset(axY)/m_zoomFactor + m_ImgContextPtr->getRenderDataPtr()->height() -clientH/m_zoomFactor >0)
+        sourceH = (min(clientH/m_zoomFactor, m_ImgContextPtr->getIHeight() + m_ImgContextPtr->getImgOffset(axY)/m_zoomFactor));
+    else if(m_ImgContextPtr->getImgOffset(axY)/m_zoomFactor + m_ImgContextPtr->getIHeight() -clientH/m_zoomFactor >0)
         sourceH = ((clientH - m_ImgContextPtr->getImgOffset(axY))/m_zoomFactor);
     else
-        sourceH = m_ImgContextPtr->getRenderDataPtr()->height()-1;
+        sourceH = m_ImgContextPtr->getIHeight()-1;
 
     wtmp =  (m_ImgContextPtr->getImgOffset(axX)>0)?0:-roundTo(m_ImgContextPtr->getImgOffset(axX), m_zoomFactor);
     wtmp /= m_zoomFactor;
@@ -247,11 +236,13 @@ QPoint qwGridCanvas::whichPixel(QPoint userCoordinates)
     if(m_ImgContextPtr.isNull())
         return QPoint(-1,-1);
 
-    if( (userCoordinates.x()>=m_imgBoundaryX) && (userCoordinates.x() <= (m_imgBoundaryX + m_rollerW.width())) &&
-        ((userCoordinates.y()>=m_imgBoundaryY) && (userCoordinates.y() <= (m_imgBoundaryY + m_rollerH.height()))))
+    if( (!m_shownRect.isEmpty()) &&
+        (userCoordinates.x()>=m_imgBoundaryX) && (userCoordinates.x() <= (m_imgBoundaryX + m_shownW)) &&
+        ((userCoordinates.y()>=m_imgBoundaryY) && (userCoordinates.y() <= (m_imgBoundaryY + m_shownH))))
         {
-            userCoordinates.setX((qint32)(0x00FFFFFF&m_rollerW.pixel(userCoordinates.x()- m_imgBoundaryX,0)));
-            userCoordinates.setY((qint32)(0x00FFFFFF&m_rollerH.pixel(0,userCoordinates.y()- m_imgBoundaryY)));
+            //Shown pixels are m_zoomFactor wide, see paintEvent.
+            userCoordinates.setX(max(m_shownRect.x(), min(m_shownRect.right(), (qint32)((m_shownOriginX + userCoordinates.x()- m_imgBoundaryX)/m_zoomFactor))));
+            userCoordinates.setY(max(m_shownRect.y(), min(m_shownRect.bottom(), (qint32)((m_shownOriginY + userCoordinates.y()- m_imgBoundaryY)/m_zoomFactor))));
 
             if(m_ImgContextPtr->getFlag(IMGCX_HORIZONTAL_FLIP_check))
                 userCoordinates.setX(m_ImgContextPtr->getIWidth() - userCoordinates.x()-1);
@@ -437,8 +428,10 @@ void qwGridCanvas::paintEvent(QPaintEvent *event)
     QRect    sourceRect;
     qint32   markerX=-1, markerY=-1;
     quint32  itmp, jtmp;
+    qint32   originX, originY;
 
     calcSizeParams();
+    m_shownRect = QRect();
 
     painter.beginNativePainting();
 
@@ -450,10 +443,10 @@ void qwGridCanvas::paintEvent(QPaintEvent *event)
     }
     else if(m_ImgContextPtr->getMyState() == STATE_BUSY)
     {
-        textMessage = "Busy. " + m_ImgContextPtr->auxInfo;
+        textMessage = "Busy. " + m_ImgContextPtr->progress.format();
     }
     else if((m_ImgContextPtr->getMyState() == STATE_BAD)||
-            (m_ImgContextPtr->getRenderDataPtr()== NULL))
+            (!m_ImgContextPtr->isRenderable()))
     {
         textMessage = "Not renderable";
     }
@@ -486,24 +479,48 @@ void qwGridCanvas::paintEvent(QPaintEvent *event)
                        m_lastSourceY,
                        sourceW+1,
                        sourceH+1);
+    sourceRect = sourceRect.intersected(QRect(0, 0, m_ImgContextPtr->getIWidth(), m_ImgContextPtr->getIHeight()));
+
+    //The view is composed of the screen tiles in view, already scaled (see CRenderCache).
+    originX = (qint32)floor(sourceRect.x()*m_zoomFactor);
+    originY = (qint32)floor(sourceRect.y()*m_zoomFactor);
+    QPixmap clampedImage(max(1, (qint32)ceil((sourceRect.right() + 1)*m_zoomFactor) - originX),
+                         max(1, (qint32)ceil((sourceRect.bottom() + 1)*m_zoomFactor) - originY));
+    clampedImage.fill(Qt::transparent);
+
+    QPainter tilePainter;
+    tilePainter.begin(&clampedImage);
+    tilePainter.setCompositionMode(QPainter::CompositionMode_Source);
+    if(!sourceRect.isEmpty())
+    for(qint32 row = originY/RENDER_TILE_SIZE; row <= (originY + clampedImage.height() - 1)/RENDER_TILE_SIZE; row++)
+        for(qint32 col = originX/RENDER_TILE_SIZE; col <= (originX + clampedImage.width() - 1)/RENDER_TILE_SIZE; col++)
+        {
+            QPixmap tile = CRenderCache::getTile(m_ImgContextPtr.data(), m_zoomFactor, col, row);
 
-    QPixmap clampedImage = m_ImgContextPtr->getRenderDataPtr()->copy(sourceRect);
-    m_rollerW = s_rollerW.copy(m_lastSourceX,0,clampedImage.width(), 1);
-    m_rollerH = s_rollerH.copy(0,m_lastSourceY,1, clampedImage.height());
-    clampedImage = clampedImage.scaled(m_zoomFactor*(sourceRect.width()),m_zoomFactor*(sourceRect.height()));
+            if(!tile.isNull())
+                tilePainter.drawPixmap(col*RENDER_TILE_SIZE - originX, row*RENDER_TILE_SIZE - originY, tile);
+        }
+    tilePainter.end();
 
-    m_rollerW = m_rollerW.scaled(m_zoomFactor*(sourceRect.width()),1);
-    m_rollerH = m_rollerH.scaled(1,m_zoomFactor*(sourceRect.height()));
+    m_shownRect = sourceRect;
+    m_shownOriginX = originX;
+    m_shownOriginY = originY;
+    m_shownW = sourceRect.isEmpty()?0:clampedImage.width();
+    m_shownH = sourceRect.isEmpty()?0:clampedImage.height();
 
 
-    QPainter maskPainter;
-    maskPainter.begin(&clampedImage);
-    maskPainter.beginNativePainting();
-    maskPainter.setCompositionMode(QPainter::RasterOp_SourceAndDestination);
-    maskPainter.fillRect(0,0, clampedImage.width(), clampedImage.height(),
-                      m_ImgContextPtr->getDisplayMask());
-    maskPainter.endNativePainting();
-    maskPainter.end();
+    //All channels shown, nothing to mask.
+    if(m_ImgContextPtr->getDisplayMask() != QColor(Qt::white))
+    {
+        QPainter maskPainter;
+        maskPainter.begin(&clampedImage);
+        maskPainter.beginNativePainting();
+        maskPainter.setCompositionMode(QPainter::RasterOp_SourceAndDestination);
+        maskPainter.fillRect(0,0, clampedImage.width(), clampedImage.height(),
+                          m_ImgContextPtr->getDisplayMask());
+        maskPainter.endNativePainting();
+        maskPainter.end();
+    }
 
     if((sourceW<0)||(sourceH <0))
     {
@@ -520,8 +537,8 @@ void qwGridCanvas::paintEvent(QPaintEvent *event)
                        clampedImage);
 
     painter.setPen(s_gridPenT);
-    itmp = m_rollerW.width();
-    jtmp = m_rollerH.height();
+    itmp = m_shownW;
+    jtmp = m_shownH;
 
     painter.setCompositionMode(QPainter::RasterOp_SourceXorDestination);
     painter.drawLine(m_imgBoundaryX - GRID_BOUND_WIDTH,
@@ -544,51 +561,39 @@ void qwGridCanvas::paintEvent(QPaintEvent *event)
     markerX=-1, markerY=-1;
     if(m_zoomFactor > GRID_THRESHOLD)
     {
-        quint32  prevColor;
-        qint32   range;
-        quint32* p32;
+        qint32   index, range;
 
         painter.setPen(s_gridPen);
         painter.setCompositionMode(QPainter::RasterOp_NotSourceXorDestination);
-        p32 = (quint32*)m_rollerW.scanLine(0);
 
-        prevColor = p32[0];
-        if((qint32)(0x00FFFFFF&prevColor) == m_ImgContextPtr->getSelectedPixel(axX))
+        //A grid line starts every shown pixel.
+        if(m_shownRect.x() == m_ImgContextPtr->getSelectedPixel(axX))
             markerX = 0;
 
-        for(range = 1; range <= (qint32)itmp; range++)
+        for(index = 1; index <= m_shownRect.width(); index++)
          {
-            if(prevColor != p32[range])
-             {
-                prevColor = p32[range];
-                painter.drawLine(m_imgBoundaryX + range,
-                                 m_imgBoundaryY,
-                                 m_imgBoundaryX + range,
-                                 m_imgBoundaryY + jtmp);
-                if((qint32)(0x00FFFFFF&prevColor) == m_ImgContextPtr->getSelectedPixel(axX))
-                    markerX = range;
-             }
+            range = (qint32)ceil((m_shownRect.x() + index)*m_zoomFactor) - m_shownOriginX;
+            painter.drawLine(m_imgBoundaryX + range,
+                             m_imgBoundaryY,
+                             m_imgBoundaryX + range,
+                             m_imgBoundaryY + jtmp);
+            if(m_shownRect.x() + index == m_ImgContextPtr->getSelectedPixel(axX))
+                markerX = range;
          }
 
-        p32 = (quint32*)m_rollerH.scanLine(0);
-        prevColor = p32[0];
-        if((qint32)(0x00FFFFFF&prevColor) == m_ImgContextPtr->getSelectedPixel(axY))
+        if(m_shownRect.y() == m_ImgContextPtr->getSelectedPixel(axY))
             markerY = 0;
 
-        for(range = 1; range <= (qint32)jtmp; range++)
+        for(index = 1; index <= m_shownRect.height(); index++)
          {
-            p32 = (quint32*)m_rollerH.scanLine(range);
-            if(prevColor != *p32)
-             {
-                prevColor = *p32;
-                painter.drawLine(m_imgBoundaryX,
-                                 m_imgBoundaryY + range,
-                                 m_imgBoundaryX + itmp,
-                                 m_imgBoundaryY + range);
-
-                if((qint32)(0x00FFFFFF&prevColor) == m_ImgContextPtr->getSelectedPixel(axY))
-                    markerY = range;
-             }
+            range = (qint32)ceil((m_shownRect.y() + index)*m_zoomFactor) - m_shownOriginY;
+            painter.drawLine(m_imgBoundaryX,
+                             m_imgBoundaryY + range,
+                             m_imgBoundaryX + itmp,
+                             m_imgBoundaryY + range);
+
+            if(m_shownRect.y() + index == m_ImgContextPtr->getSelectedPixel(axY))
+                markerY = range;
          }
      }
     //draw selected pixel
@@ -699,7 +704,7 @@ void qwGridCanvas::zoom(int mag, int pposx, int pposy)
       return;
     if((m_ImgContextPtr->getIWidth()==0) || (m_ImgContextPtr->getIHeight()==0))
       return;
-    if(m_ImgContextPtr->getRenderDataPtr()==NULL)
+    if(!m_ImgContextPtr->isRenderable())
       return;
 
     float  preValue = m_ImgContextPtr->getZoomFactor();
@@ -767,13 +772,13 @@ void qwGridCanvas::zoom(int mag, int pposx, int pposy)
             Globals::sharedZoom = preValue;
     }
 
-    if(m_ImgContextPtr->getImgOffset(axX) + m_ImgContextPtr->getRenderDataPtr()->width()*m_zoomFactor<0)
-        m_ImgContextPtr->setImgOffset(axX, -(m_ImgContextPtr->getRenderDataPtr()->width()-1)*m_zoomFactor);
+    if(m_ImgContextPtr->getImgOffset(axX) + m_ImgContextPtr->getIWidth()*m_zoomFactor<0)
+        m_ImgContextPtr->setImgOffset(axX, -((qint32)m_ImgContextPtr->getIWidth()-1)*m_zoomFactor);
     else if(m_ImgContextPtr->getImgOffset(axX)>width())
         m_ImgContextPtr->setImgOffset(axX, width() - m_zoomFactor);
 
-    if(m_ImgContextPtr->getImgOffset(axY) + m_ImgContextPtr->getRenderDataPtr()->height()*m_zoomFactor<0)
-        m_ImgContextPtr->setImgOffset(axY, -(m_ImgContextPtr->getRenderDataPtr()->height()-1)*m_zoomFactor);
+    if(m_ImgContextPtr->getImgOffset(axY) + m_ImgContextPtr->getIHeight()*m_zoomFactor<0)
+        m_ImgContextPtr->setImgOffset(axY, -((qint32)m_ImgContextPtr->getIHeight()-1)*m_zoomFactor);
     else if(m_ImgContextPtr->getImgOffset(axY)>height())
         m_ImgContextPtr->setImgOffset(axY, height() - m_zoomFactor);
 
@@ -64,6 +64,10 @@ qwPickUpList::qwPickUpList(QWidget* parent):QListWidget(parent)
     connect(this, SIGNAL(saveImageAs()),
             parent, SLOT(saveImageAs()));
 
+    setMouseTracking(true);
+    connect(this, SIGNAL(itemEntered(QListWidgetItem*)),
+            this, SLOT(itemHovered(QListWidgetItem*)));
+
     setContextMenuPolicy(Qt::CustomContextMenu);
     connect(this, SIGNAL(customContextMenuRequested(const QPoint&)),
         this, SLOT(showContextMenu(const QPoint&)));
@@ -80,13 +84,14 @@ qwPickUpList::~qwPickUpList()
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void qwPickUpList::showContextMenu(const QPoint &p)
 {
+    QSharedPointer<CImgContext> whichImagePtr = Globals::findImgContextByWidget(currentItem());
+
+    myPopUpMenuPtr->setPinChecked(!whichImagePtr.isNull() && whichImagePtr->isPinned());
     myPopUpMenuPtr->popup(viewport()->mapToGlobal(p));
 }
 
 void qwPickUpList::popupRename()
 {
-    QMutexLocker lock(&Globals::imgContextListLock);
-
     QSharedPointer<CImgContext> whichImagePtr = Globals::findImgContextByWidget(currentItem());
     if(whichImagePtr == NULL)
         return;
@@ -100,9 +105,7 @@ void qwPickUpList::popupRename()
 
 void qwPickUpList::popupSaveAs()
 {
-    Globals::imgContextListLock.lock();
     QSharedPointer<CImgContext> whichImagePtr = Globals::findImgContextByWidget(currentItem());
-    Globals::imgContextListLock.unlock();
 
     if(whichImagePtr == NULL)
         return;
@@ -116,8 +119,6 @@ void qwPickUpList::popupSaveAs()
 
 void qwPickUpList::popupDelete()
 {
-    QMutexLocker lock(&Globals::imgContextListLock);
-
     QSharedPointer<CImgContext> whichImagePtr = Globals::findImgContextByWidget(currentItem());
     if(whichImagePtr == NULL)
         return;
@@ -129,6 +130,17 @@ void qwPickUpList::popupDelete()
       Globals::removeImage(whichImagePtr);
 }
 
+void qwPickUpList::popupPin()
+{
+    QSharedPointer<CImgContext> whichImagePtr = Globals::findImgContextByWidget(currentItem());
+
+    if(whichImagePtr == NULL)
+        return;
+
+    whichImagePtr->setPinned(!whichImagePtr->isPinned());
+    Globals::addCmdToLocalQueue(CMD_CREATE_THUMBNAIL, whichImagePtr);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void qwPickUpList::itemNameChanged(QListWidgetItem* itemEdited)
 {
@@ -171,6 +183,20 @@ void qwPickUpList::itemNameChanged(QListWidgetItem* itemEdited)
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void qwPickUpList::itemHovered(QListWidgetItem* item)
+{
+    //The hovered thumbnail is likely the next one picked, decode it first.
+    Globals::setFocusImage(FOCUS_SLOT_HOVER, Globals::findImgContextByWidget(item));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void qwPickUpList::leaveEvent(QEvent* event)
+{
+    Globals::setFocusImage(FOCUS_SLOT_HOVER, QSharedPointer<CImgContext>());
+    QListWidget::leaveEvent(event);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 void qwPickUpList::focusInEvent(QFocusEvent*)
 {
@@ -157,7 +157,7 @@ void qwStatusBar::nextMsg()
     else if(msgString == UI_SPEC_STATUS_IMAGES_LOADED)
     {
         msgString = "Images loaded: ";
-        msgString += QString::number(Globals::imgCount);
+        msgString += QString::number(Globals::imgRegistry.count());
         iconIndex = UI_STATUS_INFO;
     }
 
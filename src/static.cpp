@@ -19,10 +19,17 @@
 
 #include "./inc/qwAuxDialogs.h"
 #include "./inc/commons.h"
+#include "./inc/CImgContext.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 qwReinterpretDialog           *qwReinterpretDialog::myHandler                  = NULL;
 qwAboutDialog                 *qwAboutDialog::myHandler                        = NULL;
+qwMemoryDialog                *qwMemoryDialog::myHandler                       = NULL;
+qwToolJobsDialog              *qwToolJobsDialog::myHandler                     = NULL;
+qwPipelineDialog              *qwPipelineDialog::myHandler                     = NULL;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+QAtomicInt                     CImgContext::viewClock(0);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 qwImageComparatorDialog       *qwImageComparatorDialog::myHandler              = NULL;
@@ -80,3 +87,5 @@ dHeader                        qwRawHeaderEditor::rawHeader                    =
                                                                                   0};
 
 QString                         qwRawHeaderEditor::pixelFormatString            = "R8G8B8A8";
+bool                            qwRawHeaderEditor::sequenceMode                 = false;
+quint32                         qwRawHeaderEditor::sequenceParams[3]            = {0, 0, 0};